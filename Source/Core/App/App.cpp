@@ -33,6 +33,7 @@
 #include "PluginScanner.h"
 #include "Config.h"
 #include "FontSerializer.h"
+#include "JsonSerializerBenchmark.h"
 
 #include "DocumentHelpers.h"
 #include "XmlSerializer.h"
@@ -296,6 +297,12 @@ void App::initialise(const String &commandLine)
         fs.run(commandLine);
         this->quit();
     }
+    else if (this->runMode == App::JSON_BENCHMARK)
+    {
+        JsonSerializerBenchmark benchmark;
+        benchmark.run(commandLine);
+        this->quit();
+    }
 }
 
 void App::shutdown()
@@ -460,6 +467,10 @@ App::RunMode App::detectRunMode(const String &commandLine)
         {
             return App::FONT_SERIALIZE;
         }
+        if (StringArray::fromTokens(commandLine, true).contains("-B"))
+        {
+            return App::JSON_BENCHMARK;
+        }
         if (DocumentHelpers::getTempSlot(commandLine).existsAsFile())
         {
             return App::PLUGIN_CHECK;
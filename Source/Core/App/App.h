@@ -128,7 +128,8 @@ private:
     {
         NORMAL,
         PLUGIN_CHECK,
-        FONT_SERIALIZE
+        FONT_SERIALIZE,
+        JSON_BENCHMARK
     };
 
     App::RunMode detectRunMode(const String &commandLine);
@@ -0,0 +1,311 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Only compiled into debug builds by default;
+// define as 1 to profile a release build, or as 0 to compile it out
+#if !defined HELIO_PROFILING
+#   define HELIO_PROFILING JUCE_DEBUG
+#endif
+
+// Frames that took up to 0.1, 0.25, 0.5, 1, 2, 4, 8, 16, 32, 64, 128 ms, and more
+#define PROFILER_HISTOGRAM_SIZE 12
+#define PROFILER_MAX_TRACE_EVENTS (1024 * 512)
+
+// Collects the time spent in the instrumented scopes, frame by frame,
+// and can also record every scope as a Chrome trace event (chrome://tracing);
+// does nothing but a single check per scope, unless enabled
+class Profiler final
+{
+public:
+
+    static Profiler &getInstance()
+    {
+        static Profiler Instance;
+        return Instance;
+    }
+
+    struct Section final
+    {
+        const char *name = nullptr;
+
+        // Accumulated for the current frame
+        int64 frameTicks = 0;
+        int frameCalls = 0;
+
+        double lastFrameMs = 0.0;
+        int lastFrameCalls = 0;
+        double maxFrameMs = 0.0;
+        double totalMs = 0.0;
+
+        // Only the frames when the section was called at all
+        int numFrames = 0;
+        int histogram[PROFILER_HISTOGRAM_SIZE] = {};
+
+        double getAverageFrameMs() const noexcept
+        {
+            return (this->numFrames == 0) ? 0.0 : this->totalMs / this->numFrames;
+        }
+
+        // The upper bound of the histogram bucket, where the given share of frames fits
+        double getPercentileMs(float percentile) const noexcept
+        {
+            const int threshold = int(ceilf(this->numFrames * percentile));
+            int numFramesSoFar = 0;
+            for (int i = 0; i < PROFILER_HISTOGRAM_SIZE - 1; ++i)
+            {
+                numFramesSoFar += this->histogram[i];
+                if (numFramesSoFar >= threshold)
+                {
+                    return getBucketUpperBoundMs(i);
+                }
+            }
+
+            return this->maxFrameMs;
+        }
+    };
+
+    inline bool isEnabled() const noexcept
+    {
+        return this->collectingStats.get() != 0 || this->tracing.get() != 0;
+    }
+
+    //===------------------------------------------------------------------===//
+    // Per-frame stats
+    //===------------------------------------------------------------------===//
+
+    void setCollectingStats(bool shouldCollect)
+    {
+        const SpinLock::ScopedLockType lock(this->dataLock);
+        this->sections.clearQuick();
+        this->collectingStats = shouldCollect ? 1 : 0;
+    }
+
+    // Called by whoever defines the frames, i.e. the overlay
+    void closeFrame()
+    {
+        const SpinLock::ScopedLockType lock(this->dataLock);
+
+        for (auto &section : this->sections)
+        {
+            const double ms = Time::highResolutionTicksToSeconds(section.frameTicks) * 1000.0;
+            section.lastFrameMs = ms;
+            section.lastFrameCalls = section.frameCalls;
+
+            if (section.frameCalls > 0)
+            {
+                section.maxFrameMs = jmax(section.maxFrameMs, ms);
+                section.totalMs += ms;
+                section.numFrames++;
+                section.histogram[getBucketFor(ms)]++;
+            }
+
+            section.frameTicks = 0;
+            section.frameCalls = 0;
+        }
+    }
+
+    Array<Section> getSections() const
+    {
+        const SpinLock::ScopedLockType lock(this->dataLock);
+        return this->sections;
+    }
+
+    //===------------------------------------------------------------------===//
+    // Tracing
+    //===------------------------------------------------------------------===//
+
+    void startTracing()
+    {
+        const SpinLock::ScopedLockType lock(this->dataLock);
+        this->traceEvents.clearQuick();
+        this->traceStartTicks = Time::getHighResolutionTicks();
+        this->tracing = 1;
+    }
+
+    void stopTracing()
+    {
+        this->tracing = 0;
+    }
+
+    bool isTracing() const noexcept
+    {
+        return this->tracing.get() != 0;
+    }
+
+    // Writes the trace events format, which both chrome://tracing and Perfetto can open
+    bool exportTrace(const File &file) const
+    {
+        Array<TraceEvent> events;
+        int64 startTicks = 0;
+
+        {
+            const SpinLock::ScopedLockType lock(this->dataLock);
+            events = this->traceEvents;
+            startTicks = this->traceStartTicks;
+        }
+
+        file.deleteFile();
+        FileOutputStream out(file);
+        if (out.failedToOpen())
+        {
+            return false;
+        }
+
+        Array<pointer_sized_int> threadIds;
+        const double microsPerTick = 1000000.0 / double(Time::getHighResolutionTicksPerSecond());
+
+        out << "{\"traceEvents\":[";
+
+        for (int i = 0; i < events.size(); ++i)
+        {
+            const auto &event = events.getReference(i);
+            threadIds.addIfNotAlreadyThere(event.threadId);
+
+            out << (i == 0 ? "\n" : ",\n")
+                << "{\"name\":\"" << event.name
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadIds.indexOf(event.threadId)
+                << ",\"ts\":" << String(double(event.startTicks - startTicks) * microsPerTick, 3)
+                << ",\"dur\":" << String(double(event.endTicks - event.startTicks) * microsPerTick, 3)
+                << "}";
+        }
+
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        out.flush();
+        return out.getStatus().wasOk();
+    }
+
+    //===------------------------------------------------------------------===//
+    // Samples
+    //===------------------------------------------------------------------===//
+
+    // The name is expected to be a string literal, sections are told apart by its address
+    void addSample(const char *name, int64 startTicks, int64 endTicks)
+    {
+        const SpinLock::ScopedLockType lock(this->dataLock);
+
+        if (this->collectingStats.get() != 0)
+        {
+            Section *section = nullptr;
+            for (auto &s : this->sections)
+            {
+                if (s.name == name)
+                {
+                    section = &s;
+                    break;
+                }
+            }
+
+            if (section == nullptr)
+            {
+                Section newSection;
+                newSection.name = name;
+                this->sections.add(newSection);
+                section = &this->sections.getReference(this->sections.size() - 1);
+            }
+
+            section->frameTicks += (endTicks - startTicks);
+            section->frameCalls++;
+        }
+
+        if (this->tracing.get() != 0 &&
+            this->traceEvents.size() < PROFILER_MAX_TRACE_EVENTS)
+        {
+            TraceEvent event;
+            event.name = name;
+            event.threadId = pointer_sized_int(Thread::getCurrentThreadId());
+            event.startTicks = startTicks;
+            event.endTicks = endTicks;
+            this->traceEvents.add(event);
+        }
+    }
+
+private:
+
+    Profiler() = default;
+
+    static int getBucketFor(double ms) noexcept
+    {
+        for (int i = 0; i < PROFILER_HISTOGRAM_SIZE - 1; ++i)
+        {
+            if (ms <= getBucketUpperBoundMs(i))
+            {
+                return i;
+            }
+        }
+
+        return PROFILER_HISTOGRAM_SIZE - 1;
+    }
+
+    static double getBucketUpperBoundMs(int bucket) noexcept
+    {
+        static const double bounds[PROFILER_HISTOGRAM_SIZE - 1] =
+            { 0.1, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0, 64.0, 128.0 };
+
+        return bounds[bucket];
+    }
+
+    struct TraceEvent final
+    {
+        const char *name;
+        pointer_sized_int threadId;
+        int64 startTicks;
+        int64 endTicks;
+    };
+
+    Atomic<int> collectingStats;
+    Atomic<int> tracing;
+
+    SpinLock dataLock;
+    Array<Section> sections;
+    Array<TraceEvent> traceEvents;
+    int64 traceStartTicks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(Profiler)
+};
+
+class ProfilerScope final
+{
+public:
+
+    explicit ProfilerScope(const char *sectionName) noexcept :
+        name(sectionName),
+        startTicks(Profiler::getInstance().isEnabled() ? Time::getHighResolutionTicks() : 0) {}
+
+    ~ProfilerScope()
+    {
+        if (this->startTicks != 0)
+        {
+            Profiler::getInstance().addSample(this->name,
+                this->startTicks, Time::getHighResolutionTicks());
+        }
+    }
+
+private:
+
+    const char *name;
+    const int64 startTicks;
+
+    JUCE_DECLARE_NON_COPYABLE(ProfilerScope)
+};
+
+#if HELIO_PROFILING
+#   define profileScope(name) const ProfilerScope JUCE_JOIN_MACRO(profilerScope, __LINE__)(name)
+#else
+#   define profileScope(name)
+#endif
@@ -53,7 +53,12 @@ Workspace::~Workspace()
     this->recentFilesList->removeChangeListener(this);
     this->recentFilesList = nullptr;
     
-    this->pluginManager = nullptr;
+    if (this->pluginManager != nullptr)
+    {
+        this->pluginManager->removeChangeListener(this);
+        this->pluginManager = nullptr;
+    }
+
     this->audioCore = nullptr;
 }
 
@@ -63,6 +68,7 @@ void Workspace::init()
     {
         this->audioCore = new AudioCore();
         this->pluginManager = new PluginScanner();
+        this->pluginManager->addChangeListener(this);
         this->treeRoot = new RootTreeItem("Workspace");
         
         if (! this->autoload())
@@ -188,6 +194,14 @@ void Workspace::onClickedUnloadRecentFile(RecentFileDescription::Ptr fileDescrip
 
 void Workspace::changeListenerCallback(ChangeBroadcaster *source)
 {
+    // The plugins list is the largest part of the workspace,
+    // so it is kept in a separate config section and only saved when it changes
+    if (source == this->pluginManager.get())
+    {
+        Config::save(this->pluginManager.get(), Serialization::Config::pluginsList);
+        return;
+    }
+
     Config::save(this, Serialization::Config::activeWorkspace);
 }
 
@@ -427,7 +441,6 @@ ValueTree Workspace::serialize() const
     // TODO serialize window size and position
 
     tree.appendChild(this->audioCore->serialize(), nullptr);
-    tree.appendChild(this->pluginManager->serialize(), nullptr);
     tree.appendChild(this->recentFilesList->serialize(), nullptr);
 
     ValueTree treeRootNode(Core::treeRoot);
@@ -459,7 +472,16 @@ void Workspace::deserialize(const ValueTree &tree)
 
     this->recentFilesList->deserialize(root);
     this->audioCore->deserialize(root);
-    this->pluginManager->deserialize(root);
+
+    // Older workspaces have the plugins list embedded
+    if (root.getChildWithName(Audio::pluginsList).isValid())
+    {
+        this->pluginManager->deserialize(root);
+    }
+    else
+    {
+        Config::load(this->pluginManager.get(), Serialization::Config::pluginsList);
+    }
 
     auto treeRootNodeLegacy = root.getChildWithName(Core::treeItem);
     auto treeRootNode = root.getChildWithName(Core::treeRoot);
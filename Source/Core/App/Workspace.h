@@ -27,7 +27,7 @@ class PluginScanner;
 #include "TreeNavigationHistory.h"
 
 class Workspace final : public RecentFilesList::Owner,
-                        private ChangeListener, // listens to RecentFilesList
+                        private ChangeListener, // listens to RecentFilesList and PluginScanner
                         private Serializable
 {
 public:
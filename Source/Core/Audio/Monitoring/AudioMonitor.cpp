@@ -25,6 +25,8 @@
 #define AUDIO_MONITOR_CLIP_THRESHOLD                0.995f
 #define AUDIO_MONITOR_OVERSATURATION_THRESHOLD      0.5f
 #define AUDIO_MONITOR_OVERSATURATION_RATE           4.f
+#define AUDIO_MONITOR_FIFO_SIZE                     (1024 * 16)
+#define AUDIO_MONITOR_ANALYSIS_INTERVAL_MS          30
 
 class ClippingWarningAsyncCallback final  : public AsyncUpdater
 {
@@ -66,14 +68,79 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OversaturationWarningAsyncCallback)
 };
 
+class AnalysisUpdateAsyncCallback final : public AsyncUpdater
+{
+public:
+
+    explicit AnalysisUpdateAsyncCallback(AudioMonitor &parentSpectrumCallback) :
+        audioMonitor(parentSpectrumCallback) {}
+
+    void handleAsyncUpdate() override
+    {
+        this->audioMonitor.getAnalysisListeners().
+            call(&AudioMonitor::AnalysisListener::onAnalysisUpdated);
+    }
+
+private:
+
+    AudioMonitor &audioMonitor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisUpdateAsyncCallback)
+};
+
+// A single thread for the spectrum and volume analysis,
+// which is then shared by all the visualizers
+class AudioMonitor::AnalysisThread final : public Thread
+{
+public:
+
+    explicit AnalysisThread(AudioMonitor &monitor) :
+        Thread("Audio Monitor"),
+        audioMonitor(monitor) {}
+
+    void run() override
+    {
+        while (! this->threadShouldExit())
+        {
+            this->wait(AUDIO_MONITOR_ANALYSIS_INTERVAL_MS);
+            this->audioMonitor.analyzePendingSamples();
+        }
+    }
+
+private:
+
+    AudioMonitor &audioMonitor;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalysisThread)
+};
+
 AudioMonitor::AudioMonitor() :
-    fft(),
-    spectrumSize(AUDIO_MONITOR_SPECTRUM_SIZE),
+    fifo(AUDIO_MONITOR_FIFO_SIZE),
+    fifoBuffer(AUDIO_MONITOR_MAX_CHANNELS, AUDIO_MONITOR_FIFO_SIZE),
+    analysisBuffer(AUDIO_MONITOR_MAX_CHANNELS, AUDIO_MONITOR_SPECTRUM_SIZE),
+    fft(AUDIO_MONITOR_SPECTRUM_SIZE),
+    meterSampleRate(0.0),
+    momentaryLoudness(LOUDNESS_METER_SILENCE_LUFS),
+    shortTermLoudness(LOUDNESS_METER_SILENCE_LUFS),
+    spectrumSize(AUDIO_MONITOR_SPECTRUM_SIZE / 2 - 1),
     sampleRate(AUDIO_MONITOR_DEFAULT_SAMPLERATE)
 {
     zeromem(this->spectrum, sizeof(float) * AUDIO_MONITOR_MAX_CHANNELS * AUDIO_MONITOR_MAX_SPECTRUMSIZE);
+    this->fifoBuffer.clear();
+    this->analysisBuffer.clear();
+
     this->asyncClippingWarning = new ClippingWarningAsyncCallback(*this);
     this->asyncOversaturationWarning = new OversaturationWarningAsyncCallback(*this);
+    this->asyncAnalysisUpdate = new AnalysisUpdateAsyncCallback(*this);
+
+    this->analysisThread = new AnalysisThread(*this);
+    this->analysisThread->startThread(5);
+}
+
+AudioMonitor::~AudioMonitor()
+{
+    this->analysisThread->stopThread(1000);
+    this->analysisThread = nullptr;
 }
 
 //===----------------------------------------------------------------------===//
@@ -92,52 +159,161 @@ void AudioMonitor::audioDeviceIOCallback(const float **inputChannelData,
                                          int numSamples)
 {
     const int numChannels = jmin(AUDIO_MONITOR_MAX_CHANNELS, numOutputChannels);
-    
-    for (int channel = 0; channel < numChannels; ++channel)
+
+    // No locks and no analysis here, just copy the samples out;
+    // if the analysis thread falls behind, the samples are dropped
+    if (numChannels > 0)
     {
-        this->fft.computeSpectrum(outputChannelData[channel], 0, numSamples,
-                                  this->spectrum[channel], this->spectrumSize.get(),
-                                  channel, numOutputChannels);
+        int start1, size1, start2, size2;
+        this->fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < AUDIO_MONITOR_MAX_CHANNELS; ++channel)
+        {
+            // mono output is analyzed as both channels
+            const float *source = outputChannelData[jmin(channel, numChannels - 1)];
+
+            if (size1 > 0)
+            {
+                this->fifoBuffer.copyFrom(channel, start1, source, size1);
+            }
+
+            if (size2 > 0)
+            {
+                this->fifoBuffer.copyFrom(channel, start2, source + size1, size2);
+            }
+        }
+
+        this->fifo.finishedWrite(size1 + size2);
     }
     
-    for (int channel = 0; channel < numChannels; ++channel)
+#if JUCE_IOS && HELIO_AUDIOBUS_SUPPORT
+    AudiobusOutput::process();
+#endif
+    
+    for (int i = 0; i < numOutputChannels; ++i)
+    {
+        FloatVectorOperations::clear(outputChannelData[i], numSamples);
+    }
+}
+
+void AudioMonitor::audioDeviceStopped() {}
+
+//===----------------------------------------------------------------------===//
+// Analysis
+//===----------------------------------------------------------------------===//
+
+void AudioMonitor::analyzePendingSamples()
+{
+    const int numReady = this->fifo.getNumReady();
+    if (numReady == 0)
+    {
+        return;
+    }
+
+    const double currentSampleRate = this->sampleRate.get();
+    if (this->meterSampleRate != currentSampleRate)
+    {
+        this->meter.prepare(currentSampleRate);
+        this->meterSampleRate = currentSampleRate;
+    }
+
+    int start1, size1, start2, size2;
+    this->fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    const int starts[] = { start1, start2 };
+    const int sizes[] = { size1, size2 };
+
+    this->meter.resetLevels();
+
+    for (int block = 0; block < 2; ++block)
     {
-        float pcmSquaresSum = 0.f;
-        float pcmPeak = 0.f;
-        for (int samplePosition = 0; samplePosition < numSamples; ++samplePosition)
+        if (sizes[block] == 0)
         {
-            const float &pcmData = outputChannelData[channel][samplePosition];
-            pcmSquaresSum += (pcmData * pcmData);
-            pcmPeak = jmax(pcmPeak, pcmData);
+            continue;
         }
-        
-        const float rootMeanSquare = sqrtf(pcmSquaresSum / numSamples);
-        this->rms[channel] = rootMeanSquare;
+
+        const float *channels[AUDIO_MONITOR_MAX_CHANNELS];
+        for (int channel = 0; channel < AUDIO_MONITOR_MAX_CHANNELS; ++channel)
+        {
+            channels[channel] = this->fifoBuffer.getReadPointer(channel, starts[block]);
+            this->appendToAnalysisBuffer(channel, channels[channel], sizes[block]);
+        }
+
+        this->meter.process(channels, AUDIO_MONITOR_MAX_CHANNELS, sizes[block]);
+    }
+
+    this->fifo.finishedRead(size1 + size2);
+
+    for (int channel = 0; channel < AUDIO_MONITOR_MAX_CHANNELS; ++channel)
+    {
+        const float pcmPeak = this->meter.getPeak(channel);
+        const float pcmTruePeak = this->meter.getTruePeak(channel);
+        const float rootMeanSquare = this->meter.getRootMeanSquare(channel);
+
         this->peak[channel] = pcmPeak;
-        
-        if (pcmPeak > AUDIO_MONITOR_CLIP_THRESHOLD)
+        this->truePeak[channel] = pcmTruePeak;
+        this->rms[channel] = rootMeanSquare;
+
+        // inter-sample peaks clip as well, once converted to analog
+        if (pcmTruePeak > AUDIO_MONITOR_CLIP_THRESHOLD)
         {
             this->asyncClippingWarning->triggerAsyncUpdate();
         }
-        
+
         if (pcmPeak > AUDIO_MONITOR_OVERSATURATION_THRESHOLD &&
             (pcmPeak / rootMeanSquare) > AUDIO_MONITOR_OVERSATURATION_RATE)
         {
             this->asyncOversaturationWarning->triggerAsyncUpdate();
         }
     }
-    
-#if JUCE_IOS && HELIO_AUDIOBUS_SUPPORT
-    AudiobusOutput::process();
-#endif
-    
-    for (int i = 0; i < numOutputChannels; ++i)
+
+    this->momentaryLoudness = this->meter.getMomentaryLoudness();
+    this->shortTermLoudness = this->meter.getShortTermLoudness();
+
+    for (int channel = 0; channel < AUDIO_MONITOR_MAX_CHANNELS; ++channel)
     {
-        FloatVectorOperations::clear(outputChannelData[i], numSamples);
+        this->fft.computeSpectrum(this->analysisBuffer.getReadPointer(channel),
+            this->spectrum[channel]);
     }
+
+    this->asyncAnalysisUpdate->triggerAsyncUpdate();
 }
 
-void AudioMonitor::audioDeviceStopped() {}
+void AudioMonitor::appendToAnalysisBuffer(int channel, const float *samples, int numSamples)
+{
+    if (numSamples <= 0)
+    {
+        return;
+    }
+
+    const int bufferSize = this->analysisBuffer.getNumSamples();
+    float *buffer = this->analysisBuffer.getWritePointer(channel);
+
+    if (numSamples >= bufferSize)
+    {
+        FloatVectorOperations::copy(buffer, samples + numSamples - bufferSize, bufferSize);
+        return;
+    }
+
+    const int numSamplesToKeep = bufferSize - numSamples;
+    memmove(buffer, buffer + numSamples, sizeof(float) * size_t(numSamplesToKeep));
+    FloatVectorOperations::copy(buffer + numSamplesToKeep, samples, numSamples);
+}
+
+void AudioMonitor::addAnalysisListener(AnalysisListener *const listener)
+{
+    this->analysisListeners.add(listener);
+}
+
+void AudioMonitor::removeAnalysisListener(AnalysisListener *const listener)
+{
+    this->analysisListeners.remove(listener);
+}
+
+ListenerList<AudioMonitor::AnalysisListener> &AudioMonitor::getAnalysisListeners() noexcept
+{
+    return this->analysisListeners;
+}
 
 //===----------------------------------------------------------------------===//
 // Spectrum data
@@ -145,17 +321,18 @@ void AudioMonitor::audioDeviceStopped() {}
 
 float AudioMonitor::getInterpolatedSpectrumAtFrequency(float frequency) const
 {
-    const float resolution = 
-        float(this->sampleRate.get() / 2.f) / float(this->spectrumSize.get());
+    // the spectrum only holds the bins below nyquist
+    const float resolution =
+        float(this->sampleRate.get()) / float(this->fft.getSize());
     
     const int index1 = roundToInt(frequency / resolution);
-    const int safeIndex1 = jlimit(0, this->spectrumSize.get(), index1);
+    const int safeIndex1 = jlimit(0, this->spectrumSize.get() - 1, index1);
     const float f1 = index1 * resolution;
     const float y1 = (this->spectrum[0][safeIndex1].get() +
                       this->spectrum[1][safeIndex1].get()) / 2.f;
     
     const int index2 = index1 + 1;
-    const int safeIndex2 = jlimit(0, this->spectrumSize.get(), index2);
+    const int safeIndex2 = jlimit(0, this->spectrumSize.get() - 1, index2);
     const float f2 = index2 * resolution;
     const float y2 = (this->spectrum[0][safeIndex2].get() +
                       this->spectrum[1][safeIndex2].get()) / 2.f;
@@ -192,7 +369,382 @@ float AudioMonitor::getPeak(int channel) const
     return this->peak[channel].get();
 }
 
+float AudioMonitor::getTruePeak(int channel) const
+{
+    return this->truePeak[channel].get();
+}
+
 float AudioMonitor::getRootMeanSquare(int channel) const
 {
     return this->rms[channel].get();
 }
+
+float AudioMonitor::getMomentaryLoudness() const
+{
+    return this->momentaryLoudness.get();
+}
+
+float AudioMonitor::getShortTermLoudness() const
+{
+    return this->shortTermLoudness.get();
+}
+
+//===----------------------------------------------------------------------===//
+// LoudnessMeter
+//===----------------------------------------------------------------------===//
+
+#define LOUDNESS_METER_BLOCK_SECONDS        0.1
+#define LOUDNESS_METER_MOMENTARY_BLOCKS     4
+#define LOUDNESS_METER_ABSOLUTE_GATE        (-70.0)
+#define LOUDNESS_METER_RELATIVE_GATE        (-10.0)
+#define LOUDNESS_METER_HISTOGRAM_STEP       0.1
+
+static inline double energyToLoudness(double energy) noexcept
+{
+    return -0.691 + 10.0 * log10(energy);
+}
+
+static float energyToLoudnessOrSilence(double energy) noexcept
+{
+    if (energy <= 0.0)
+    {
+        return LOUDNESS_METER_SILENCE_LUFS;
+    }
+
+    return jmax(LOUDNESS_METER_SILENCE_LUFS, float(energyToLoudness(energy)));
+}
+
+// FloatVectorOperations has no sum of squares, but a loop
+// with independent accumulators gets vectorized by compilers just fine
+static float getSumOfSquares(const float *samples, int numSamples) noexcept
+{
+    float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        s0 += samples[i] * samples[i];
+        s1 += samples[i + 1] * samples[i + 1];
+        s2 += samples[i + 2] * samples[i + 2];
+        s3 += samples[i + 3] * samples[i + 3];
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        s0 += samples[i] * samples[i];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+inline double LoudnessMeter::Biquad::process(double x) noexcept
+{
+    const double y = this->b0 * x + this->z1;
+    this->z1 = this->b1 * x - this->a1 * y + this->z2;
+    this->z2 = this->b2 * x - this->a2 * y;
+    return y;
+}
+
+LoudnessMeter::LoudnessMeter() :
+    samplesPerBlock(1),
+    samplesInBlock(0),
+    samplesSinceReset(0),
+    blocksHead(0),
+    numBlocks(0)
+{
+    // The interpolation filter is a Hann-windowed sinc with the cutoff
+    // at the original nyquist, split into phases of 12 taps each;
+    // the taps are stored in the history order, the oldest sample first
+    const int numTaps = LOUDNESS_METER_OVERSAMPLING * LOUDNESS_METER_PHASE_TAPS;
+    const double centre = double(numTaps - 1) / 2.0;
+    const double pi = MathConstants<double>::pi;
+
+    for (int phase = 0; phase < LOUDNESS_METER_OVERSAMPLING; ++phase)
+    {
+        double phaseSum = 0.0;
+        double phaseTaps[LOUDNESS_METER_PHASE_TAPS];
+
+        for (int tap = 0; tap < LOUDNESS_METER_PHASE_TAPS; ++tap)
+        {
+            const int m = tap * LOUDNESS_METER_OVERSAMPLING + phase;
+            const double x = (m - centre) / double(LOUDNESS_METER_OVERSAMPLING);
+            const double sinc = (x == 0.0) ? 1.0 : sin(pi * x) / (pi * x);
+            const double window = 0.5 - 0.5 * cos(2.0 * pi * (m + 1) / (numTaps + 1));
+            phaseTaps[tap] = sinc * window;
+            phaseSum += phaseTaps[tap];
+        }
+
+        for (int tap = 0; tap < LOUDNESS_METER_PHASE_TAPS; ++tap)
+        {
+            this->truePeakTaps[phase][LOUDNESS_METER_PHASE_TAPS - 1 - tap] =
+                float(phaseTaps[tap] / phaseSum);
+        }
+    }
+
+    this->prepare(44100.0);
+}
+
+void LoudnessMeter::prepare(double sampleRate)
+{
+    // K-weighting: the BS.1770 pre-filter and RLB filter,
+    // with the coefficients derived for the given sample rate
+    const double pi = MathConstants<double>::pi;
+
+    Biquad shelf;
+    {
+        const double f0 = 1681.974450955533;
+        const double gain = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = tan(pi * f0 / sampleRate);
+        const double vh = pow(10.0, gain / 20.0);
+        const double vb = pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    Biquad highPass;
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = tan(pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    for (auto &state : this->channelStates)
+    {
+        state.shelf = shelf;
+        state.highPass = highPass;
+        state.blockEnergy = 0.0;
+        state.historyPosition = 0;
+        zeromem(state.history, sizeof(state.history));
+    }
+
+    this->samplesPerBlock = jmax(1, roundToInt(sampleRate * LOUDNESS_METER_BLOCK_SECONDS));
+    this->samplesInBlock = 0;
+
+    zeromem(this->blocks, sizeof(this->blocks));
+    this->blocksHead = 0;
+    this->numBlocks = 0;
+
+    zeromem(this->histogramEnergy, sizeof(this->histogramEnergy));
+    zeromem(this->histogramCount, sizeof(this->histogramCount));
+
+    this->resetLevels();
+}
+
+void LoudnessMeter::process(const float *const *channels, int numChannels, int numSamples)
+{
+    const int numChannelsToMeasure = jmin(numChannels, LOUDNESS_METER_MAX_CHANNELS);
+
+    // Split the input at the 100ms block boundaries
+    int offset = 0;
+    while (offset < numSamples)
+    {
+        const int chunkSize = jmin(numSamples - offset,
+            this->samplesPerBlock - this->samplesInBlock);
+
+        for (int channel = 0; channel < numChannelsToMeasure; ++channel)
+        {
+            this->processChannel(this->channelStates[channel], channels[channel] + offset, chunkSize);
+        }
+
+        offset += chunkSize;
+        this->samplesInBlock += chunkSize;
+
+        if (this->samplesInBlock == this->samplesPerBlock)
+        {
+            this->finishBlock();
+        }
+    }
+
+    this->samplesSinceReset += numSamples;
+}
+
+void LoudnessMeter::processChannel(ChannelState &state, const float *samples, int numSamples)
+{
+    if (numSamples <= 0)
+    {
+        return;
+    }
+
+    float minValue = 0.f;
+    float maxValue = 0.f;
+    FloatVectorOperations::findMinAndMax(samples, numSamples, minValue, maxValue);
+    const float samplePeak = jmax(-minValue, maxValue);
+
+    state.peak = jmax(state.peak, samplePeak);
+    state.truePeak = jmax(state.truePeak, samplePeak);
+    state.squaresSum += getSumOfSquares(samples, numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float x = samples[i];
+
+        const double weighted = state.highPass.process(state.shelf.process(x));
+        state.blockEnergy += weighted * weighted;
+
+        // The history is stored twice, so that the latest taps are contiguous
+        state.history[state.historyPosition] = x;
+        state.history[state.historyPosition + LOUDNESS_METER_PHASE_TAPS] = x;
+        state.historyPosition = (state.historyPosition + 1) % LOUDNESS_METER_PHASE_TAPS;
+        const float *history = state.history + state.historyPosition;
+
+        for (int phase = 0; phase < LOUDNESS_METER_OVERSAMPLING; ++phase)
+        {
+            float interpolated = 0.f;
+            for (int tap = 0; tap < LOUDNESS_METER_PHASE_TAPS; ++tap)
+            {
+                interpolated += this->truePeakTaps[phase][tap] * history[tap];
+            }
+
+            state.truePeak = jmax(state.truePeak, std::abs(interpolated));
+        }
+    }
+}
+
+void LoudnessMeter::finishBlock()
+{
+    double energy = 0.0;
+    for (auto &state : this->channelStates)
+    {
+        energy += state.blockEnergy / this->samplesPerBlock;
+        state.blockEnergy = 0.0;
+    }
+
+    this->samplesInBlock = 0;
+    this->blocks[this->blocksHead] = energy;
+    this->blocksHead = (this->blocksHead + 1) % LOUDNESS_METER_SHORT_TERM_BLOCKS;
+    this->numBlocks = jmin(this->numBlocks + 1, LOUDNESS_METER_SHORT_TERM_BLOCKS);
+
+    // Gating blocks are 400ms long and overlap by 75%,
+    // so a new one is complete each 100ms
+    if (this->numBlocks < LOUDNESS_METER_MOMENTARY_BLOCKS)
+    {
+        return;
+    }
+
+    const double momentaryEnergy = this->getMeanEnergy(LOUDNESS_METER_MOMENTARY_BLOCKS);
+    if (momentaryEnergy <= 0.0)
+    {
+        return;
+    }
+
+    const double loudness = energyToLoudness(momentaryEnergy);
+    if (loudness < LOUDNESS_METER_ABSOLUTE_GATE)
+    {
+        return;
+    }
+
+    const int bin = jlimit(0, LOUDNESS_METER_HISTOGRAM_SIZE - 1,
+        int((loudness - LOUDNESS_METER_ABSOLUTE_GATE) / LOUDNESS_METER_HISTOGRAM_STEP));
+
+    this->histogramEnergy[bin] += momentaryEnergy;
+    this->histogramCount[bin]++;
+}
+
+double LoudnessMeter::getMeanEnergy(int numLatestBlocks) const noexcept
+{
+    const int numBlocksToAverage = jmin(numLatestBlocks, this->numBlocks);
+    if (numBlocksToAverage == 0)
+    {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (int i = 1; i <= numBlocksToAverage; ++i)
+    {
+        const int index = (this->blocksHead - i + LOUDNESS_METER_SHORT_TERM_BLOCKS) %
+            LOUDNESS_METER_SHORT_TERM_BLOCKS;
+
+        sum += this->blocks[index];
+    }
+
+    return sum / numBlocksToAverage;
+}
+
+void LoudnessMeter::resetLevels()
+{
+    for (auto &state : this->channelStates)
+    {
+        state.peak = 0.f;
+        state.truePeak = 0.f;
+        state.squaresSum = 0.0;
+    }
+
+    this->samplesSinceReset = 0;
+}
+
+float LoudnessMeter::getPeak(int channel) const noexcept
+{
+    return this->channelStates[channel].peak;
+}
+
+float LoudnessMeter::getTruePeak(int channel) const noexcept
+{
+    return this->channelStates[channel].truePeak;
+}
+
+float LoudnessMeter::getRootMeanSquare(int channel) const noexcept
+{
+    if (this->samplesSinceReset == 0)
+    {
+        return 0.f;
+    }
+
+    return float(sqrt(this->channelStates[channel].squaresSum / double(this->samplesSinceReset)));
+}
+
+float LoudnessMeter::getMomentaryLoudness() const noexcept
+{
+    return energyToLoudnessOrSilence(this->getMeanEnergy(LOUDNESS_METER_MOMENTARY_BLOCKS));
+}
+
+float LoudnessMeter::getShortTermLoudness() const noexcept
+{
+    return energyToLoudnessOrSilence(this->getMeanEnergy(LOUDNESS_METER_SHORT_TERM_BLOCKS));
+}
+
+float LoudnessMeter::getIntegratedLoudness() const noexcept
+{
+    double energySum = 0.0;
+    int numGatedBlocks = 0;
+    for (int i = 0; i < LOUDNESS_METER_HISTOGRAM_SIZE; ++i)
+    {
+        energySum += this->histogramEnergy[i];
+        numGatedBlocks += this->histogramCount[i];
+    }
+
+    if (numGatedBlocks == 0)
+    {
+        return LOUDNESS_METER_SILENCE_LUFS;
+    }
+
+    // The relative gate is applied with the histogram's precision of 0.1 LU
+    const double relativeGate = energyToLoudness(energySum / numGatedBlocks) + LOUDNESS_METER_RELATIVE_GATE;
+    const int firstBin = jlimit(0, LOUDNESS_METER_HISTOGRAM_SIZE - 1,
+        int((relativeGate - LOUDNESS_METER_ABSOLUTE_GATE) / LOUDNESS_METER_HISTOGRAM_STEP));
+
+    energySum = 0.0;
+    numGatedBlocks = 0;
+    for (int i = firstBin; i < LOUDNESS_METER_HISTOGRAM_SIZE; ++i)
+    {
+        energySum += this->histogramEnergy[i];
+        numGatedBlocks += this->histogramCount[i];
+    }
+
+    if (numGatedBlocks == 0)
+    {
+        return LOUDNESS_METER_SILENCE_LUFS;
+    }
+
+    return energyToLoudnessOrSilence(energySum / numGatedBlocks);
+}
@@ -22,11 +22,91 @@
 #define AUDIO_MONITOR_MAX_CHANNELS      2
 #define AUDIO_MONITOR_MAX_SPECTRUMSIZE  512
 
+#define LOUDNESS_METER_MAX_CHANNELS     2
+#define LOUDNESS_METER_OVERSAMPLING     4
+#define LOUDNESS_METER_PHASE_TAPS       12
+#define LOUDNESS_METER_SHORT_TERM_BLOCKS 30
+#define LOUDNESS_METER_HISTOGRAM_SIZE   800
+#define LOUDNESS_METER_SILENCE_LUFS     (-70.f)
+
+// Sample peak, rms, true peak (ITU-R BS.1770 4x oversampling)
+// and K-weighted loudness in LUFS; not thread-safe, it is meant
+// to be owned by whatever thread does the analysis or rendering
+class LoudnessMeter final
+{
+public:
+
+    LoudnessMeter();
+
+    // Resets all the state, including the integrated loudness
+    void prepare(double sampleRate);
+
+    void process(const float *const *channels, int numChannels, int numSamples);
+
+    // Sample peak, true peak and rms since the last resetLevels() call
+    void resetLevels();
+    float getPeak(int channel) const noexcept;
+    float getTruePeak(int channel) const noexcept;
+    float getRootMeanSquare(int channel) const noexcept;
+
+    // 400ms, 3s and the gated loudness of everything since prepare(),
+    // or LOUDNESS_METER_SILENCE_LUFS when there is nothing to measure
+    float getMomentaryLoudness() const noexcept;
+    float getShortTermLoudness() const noexcept;
+    float getIntegratedLoudness() const noexcept;
+
+private:
+
+    struct Biquad final
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+        inline double process(double x) noexcept;
+    };
+
+    struct ChannelState final
+    {
+        Biquad shelf;
+        Biquad highPass;
+        float history[LOUDNESS_METER_PHASE_TAPS * 2];
+        int historyPosition = 0;
+
+        float peak = 0.f;
+        float truePeak = 0.f;
+        double squaresSum = 0.0;
+        double blockEnergy = 0.0;
+    };
+
+    void processChannel(ChannelState &state, const float *samples, int numSamples);
+    void finishBlock();
+    double getMeanEnergy(int numLatestBlocks) const noexcept;
+
+    ChannelState channelStates[LOUDNESS_METER_MAX_CHANNELS];
+    float truePeakTaps[LOUDNESS_METER_OVERSAMPLING][LOUDNESS_METER_PHASE_TAPS];
+
+    int samplesPerBlock;
+    int samplesInBlock;
+    int64 samplesSinceReset;
+
+    // The energies of the latest 100ms blocks, used for the sliding windows
+    double blocks[LOUDNESS_METER_SHORT_TERM_BLOCKS];
+    int blocksHead;
+    int numBlocks;
+
+    // Gating needs all the momentary blocks, so they are collected
+    // into a histogram of 0.1 LU bins to keep the memory constant
+    double histogramEnergy[LOUDNESS_METER_HISTOGRAM_SIZE];
+    int histogramCount[LOUDNESS_METER_HISTOGRAM_SIZE];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
+
 class AudioMonitor final : public AudioIODeviceCallback
 {
 public:
     
     AudioMonitor();
+    ~AudioMonitor() override;
 
     //===------------------------------------------------------------------===//
     // AudioIODeviceCallback
@@ -61,29 +141,73 @@ public:
     //===------------------------------------------------------------------===//
     
     float getPeak(int channel) const;
+    float getTruePeak(int channel) const;
     float getRootMeanSquare(int channel) const;
+
+    // In LUFS
+    float getMomentaryLoudness() const;
+    float getShortTermLoudness() const;
     
     //===------------------------------------------------------------------===//
     // Spectrum data
     //===------------------------------------------------------------------===//
     
     float getInterpolatedSpectrumAtFrequency(float frequency) const;
-    
+
+    //===------------------------------------------------------------------===//
+    // Analysis updates
+    //===------------------------------------------------------------------===//
+
+    // Called on the message thread each time the new portion
+    // of samples has been analyzed, so that visualizers don't need to poll
+    class AnalysisListener
+    {
+    public:
+        virtual ~AnalysisListener() {}
+        virtual void onAnalysisUpdated() = 0;
+    };
+
+    void addAnalysisListener(AnalysisListener *const listener);
+    void removeAnalysisListener(AnalysisListener *const listener);
+    ListenerList<AnalysisListener> &getAnalysisListeners() noexcept;
+
 private:
 
+    // The audio callback only copies the output into a lock-free fifo,
+    // and the analysis thread picks the samples up from there
+    void analyzePendingSamples();
+    void appendToAnalysisBuffer(int channel, const float *samples, int numSamples);
+
+    AbstractFifo fifo;
+    AudioBuffer<float> fifoBuffer;
+
+    // The latest samples, enough for a single spectrum
+    AudioBuffer<float> analysisBuffer;
+
+    class AnalysisThread;
+    ScopedPointer<AnalysisThread> analysisThread;
+
     SpectrumFFT fft;
 
+    LoudnessMeter meter;
+    double meterSampleRate;
+
     Atomic<float> spectrum[AUDIO_MONITOR_MAX_CHANNELS][AUDIO_MONITOR_MAX_SPECTRUMSIZE];
     Atomic<float> peak[AUDIO_MONITOR_MAX_CHANNELS];
+    Atomic<float> truePeak[AUDIO_MONITOR_MAX_CHANNELS];
     Atomic<float> rms[AUDIO_MONITOR_MAX_CHANNELS];
+    Atomic<float> momentaryLoudness;
+    Atomic<float> shortTermLoudness;
 
     Atomic<int> spectrumSize;
     Atomic<double> sampleRate;
 
     ListenerList<ClippingListener> clippingListeners;
+    ListenerList<AnalysisListener> analysisListeners;
 
     ScopedPointer<AsyncUpdater> asyncClippingWarning;
     ScopedPointer<AsyncUpdater> asyncOversaturationWarning;
+    ScopedPointer<AsyncUpdater> asyncAnalysisUpdate;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioMonitor)
     JUCE_DECLARE_WEAK_REFERENCEABLE(AudioMonitor)
@@ -18,207 +18,118 @@
 #include "Common.h"
 #include "SpectrumAnalyzer.h"
 
-#define FFT_ABS(x)    ((x) < 0  ? -(x) : (x))
-#define FFT_MAX(a, b) ((a) > (b) ? (a) : (b))
-#define FFT_MIN(a, b) ((a) < (b) ? (a) : (b))
-
-#define FFT_PI     3.14159265358979323846f
-#define FFT_PI2   (3.14159265358979323846f * 2.0f)
-#define FFT_PI_2  (3.14159265358979323846f / 2.0f)
-#define FFT_SQRT2  1.41421356237309504880f
-#define FFT_LOG2   0.693147180559945309417f
-
-#if JUCE_WIN32
-
-#define FFT_SIN   (float)sin
-#define FFT_SINH  (float)sinh
-#define FFT_COS   (float)cos
-#define FFT_TAN   (float)tan
-#define FFT_SQRT  (float)sqrt
-#define FFT_POW   (float)pow
-#define FFT_ATAN  (float)atan
-#define FFT_EXP   (float)exp
-#define FFT_LDEXP (float)ldexp
-#define FFT_FABS  fabsf
-#define FFT_LOG   (float)log
-#define FFT_LOG10 (float)log10
-#define FFT_FMOD  (float)fmod
-
-#else
-
-#define FFT_SIN   sinf
-#define FFT_SINH  sinhf
-#define FFT_COS   cosf
-#define FFT_TAN   tanf
-#define FFT_SQRT  sqrtf
-#define FFT_POW   powf
-#define FFT_ATAN  atanf
-#define FFT_EXP   expf
-#define FFT_LDEXP ldexpf
-#define FFT_FABS  fabsf
-#define FFT_LOG   logf
-#define FFT_LOG10 log10f
-#define FFT_EXP2(_val) powf(2.0f, _val)
-#define FFT_FMOD  fmodf
-
-#endif
-
-SpectrumFFT::SpectrumFFT ()
+// Matches the loudness of the spectrum to the meters
+#define FFT_MAGNITUDE_GAIN 2.5f
+
+static int getNumBits(int size) noexcept
 {
-    for (int count = 0; count < FFT_COSTABSIZE; count++)
+    int bits = 0;
+    while ((1 << (bits + 1)) <= size)
     {
-        this->costab[count] = FFT_COS(FFT_PI_2 * static_cast<float>(count) / static_cast<float>(FFT_COSTABSIZE));
+        bits++;
     }
+
+    return bits;
 }
 
-inline const float SpectrumFFT::cosine(float x)
+static int reverseBits(int value, int bits) noexcept
 {
-    int y;
-    
-    x *= FFT_TABLERANGE;
-    y = static_cast<int>(x);
-    if (y < 0)
-    {
-        y = -y;
-    }
-    
-    y &= FFT_TABLEMASK;
-    switch (y >> FFT_COSTABBITS)
+    int result = 0;
+    while (bits--)
     {
-        case 0 : return  this->costab[y];
-        case 1 : return -this->costab[(FFT_COSTABSIZE - 1) - (y - (FFT_COSTABSIZE * 1))];
-        case 2 : return -this->costab[                       (y - (FFT_COSTABSIZE * 2))];
-        case 3 : return  this->costab[(FFT_COSTABSIZE - 1) - (y - (FFT_COSTABSIZE * 3))];
+        result = (result << 1) | (value & 1);
+        value >>= 1;
     }
-    
-    return 0.0f;
-}
 
-inline const float SpectrumFFT::sine(float x)
-{
-    return this->cosine(x - 0.25f);
+    return result;
 }
 
-inline const unsigned int SpectrumFFT::reverse(unsigned int val, int bits)
+SpectrumFFT::SpectrumFFT(int fftSize) :
+    size(1 << getNumBits(fftSize)),
+    bits(getNumBits(fftSize))
 {
-    unsigned int retn = 0;
-    
-    while (bits--)
+    jassert(isPowerOfTwo(fftSize));
+
+    this->window.malloc(size_t(this->size));
+    this->re.malloc(size_t(this->size));
+    this->im.malloc(size_t(this->size));
+    this->cosines.malloc(size_t(this->size / 2));
+    this->sines.malloc(size_t(this->size / 2));
+    this->reversedIndices.malloc(size_t(this->size));
+
+    for (int i = 0; i < this->size; ++i)
     {
-        retn <<= 1;
-        retn |= (val & 1);
-        val >>= 1;
+        // Hann window, with the 1 / N normalization baked in
+        const float phase = MathConstants<float>::twoPi * float(i) / float(this->size);
+        this->window[i] = 0.5f * (1.f - cosf(phase)) / float(this->size);
+        this->reversedIndices[i] = reverseBits(i, this->bits);
     }
-    
-    return (retn);
-}
 
-inline void SpectrumFFT::process(int bits)
-{
-    int    count, count2, count3;
-    unsigned        i1;
-    int             i2, i3, i4, y;
-    int             fftlen = 1 << bits;
-    float           a1, a2, b1, b2, z1, z2;
-    float           oneoverN = 1.0f / fftlen;
-    
-    i1 = fftlen / 2;
-    i2 = 1;
-    
-    for (count = 0; count < bits; count++)
+    for (int i = 0; i < this->size / 2; ++i)
     {
-        i3 = 0;
-        i4 = i1;
-        
-        for (count2 = 0; count2 < i2; count2++)
-        {
-            y  = this->reverse(i3 / static_cast<int>(i1), bits);
-            
-            z1 =  this->cosine(static_cast<float>(y) * oneoverN);
-            z2 =   -this->sine(static_cast<float>(y) * oneoverN);
-            
-            for (count3 = i3; count3 < i4; count3++)
-            {
-                a1 = this->buffer[count3].re;
-                a2 = this->buffer[count3].im;
-                
-                b1 = (z1 * this->buffer[count3+i1].re) - (z2 * this->buffer[count3+i1].im);
-                b2 = (z2 * this->buffer[count3+i1].re) + (z1 * this->buffer[count3+i1].im);
-                
-                this->buffer[count3].re = a1 + b1;
-                this->buffer[count3].im = a2 + b2;
-                
-                this->buffer[count3+i1].re = a1 - b1;
-                this->buffer[count3+i1].im = a2 - b2;
-            }
-            
-            i3 += (i1 << 1);
-            i4 += (i1 << 1);
-        }
-        
-        i1 >>= 1;
-        i2 <<= 1;
+        const float phase = MathConstants<float>::twoPi * float(i) / float(this->size);
+        this->cosines[i] = cosf(phase);
+        this->sines[i] = -sinf(phase);
     }
 }
 
-void SpectrumFFT::computeSpectrum(float *pcmbuffer,
-                                  unsigned int pcmposition,
-                                  unsigned int pcmlength,
-                                  Atomic<float> *spectrum,
-                                  int length,
-                                  int channel,
-                                  int numchannels)
+int SpectrumFFT::getSize() const noexcept
 {
-    int count, bits, bitslength, nyquist;
-    
-    bitslength = length;
-    bits = 0;
-    while (bitslength > 1)
+    return this->size;
+}
+
+void SpectrumFFT::computeSpectrum(const float *samples, Atomic<float> *spectrum)
+{
+    // Windowing and the bit-reversal permutation in one pass
+    for (int i = 0; i < this->size; ++i)
     {
-        bitslength >>= 1;
-        bits++;
+        const int j = this->reversedIndices[i];
+        this->re[j] = samples[i] * this->window[i];
     }
-    
-    // Apply Hanning window
-    for (count = 0; count < length; count++)
+
+    FloatVectorOperations::clear(this->im, this->size);
+
+    this->process();
+
+    const int nyquist = this->size / 2;
+    for (int i = 0; i < nyquist - 1; ++i)
     {
-        float window;
-        float percent = static_cast<float>(count) / static_cast<float>(length);
-        
-        window = 0.5f * (1.0f  - this->cosine(percent));
-        
-        this->buffer[count].re = pcmbuffer[pcmposition] * window;
-        this->buffer[count].re /= static_cast<float>(length);
-        this->buffer[count].im = 0.00000001f;
-        
-        pcmposition++;
-        if (pcmposition >= pcmlength)
-        {
-            pcmposition = 0;
-        }
+        const float magnitude = sqrtf(this->re[i] * this->re[i] + this->im[i] * this->im[i]);
+        spectrum[i] = jmin(1.f, magnitude * FFT_MAGNITUDE_GAIN);
     }
+}
 
-    this->process(bits);
+// Iterative decimation in time, the input is already in bit-reversed order;
+// the inner loop has no dependencies between iterations, so compilers vectorize it
+void SpectrumFFT::process()
+{
+    float *const r = this->re;
+    float *const i = this->im;
 
-    nyquist = (length / 2);
-    for (count = 0; count < (nyquist - 1); ++count)
+    for (int halfSize = 1; halfSize < this->size; halfSize <<= 1)
     {
-        float magnitude;
-        int n = count;
-        
-        n = this->reverse(n, bits);
-        
-        magnitude = 
-            FFT_SQRT((this->buffer[n].re * this->buffer[n].re)
-                + (this->buffer[n].im * this->buffer[n].im));
-        
-        magnitude *= 2.5f; 
-        
-        if (magnitude > 1.0f)
+        const int twiddleStep = this->size / (halfSize * 2);
+
+        for (int start = 0; start < this->size; start += halfSize * 2)
         {
-            magnitude = 1.0f;
+            float *const r1 = r + start;
+            float *const i1 = i + start;
+            float *const r2 = r1 + halfSize;
+            float *const i2 = i1 + halfSize;
+
+            for (int k = 0; k < halfSize; ++k)
+            {
+                const float c = this->cosines[k * twiddleStep];
+                const float s = this->sines[k * twiddleStep];
+
+                const float tr = c * r2[k] - s * i2[k];
+                const float ti = s * r2[k] + c * i2[k];
+
+                r2[k] = r1[k] - tr;
+                i2[k] = i1[k] - ti;
+                r1[k] += tr;
+                i1[k] += ti;
+            }
         }
-        
-        spectrum[count] = magnitude;
     }
 }
@@ -17,41 +17,36 @@
 
 #pragma once
 
-const int FFT_COSTABBITS = 13;
-const int FFT_COSTABSIZE = (1 << FFT_COSTABBITS);
-const int FFT_TABLERANGE = (FFT_COSTABSIZE * 4);
-const int FFT_TABLEMASK  = (FFT_TABLERANGE - 1);
-
+// Radix-2 FFT of a fixed size, with all the twiddle factors, the window
+// and the bit-reversal permutation precomputed, so that the transform itself
+// is only made of the plain loops over split real/imaginary arrays
 class SpectrumFFT final
 {
 public:
     
-    SpectrumFFT();
-    
-    void computeSpectrum(float *pcmbuffer,
-        unsigned int pcmposition,
-        unsigned int pcmlength,
-        Atomic<float> *spectrum,
-        int length,
-        int channel,
-        int numchannels);
+    explicit SpectrumFFT(int size);
+
+    int getSize() const noexcept;
+
+    // Writes getSize() / 2 - 1 magnitudes, normalized and clipped to [0, 1]
+    void computeSpectrum(const float *samples, Atomic<float> *spectrum);
     
 private:
     
-    typedef struct
-    {
-        float re;
-        float im;
-    }
-    FFT_COMPLEX;
-    
-    FFT_COMPLEX     buffer[16 * 1024];
-    float           costab[FFT_COSTABSIZE];
-    
-    inline const float          cosine(float x);
-    inline const float          sine(float x);
-    inline const unsigned int   reverse(unsigned int val, int bits);
-    inline void                 process(int bits);
+    void process();
+
+    const int size;
+    const int bits;
+
+    HeapBlock<float> window;
+    HeapBlock<float> re;
+    HeapBlock<float> im;
+
+    // Twiddle factors for size / 2 points
+    HeapBlock<float> cosines;
+    HeapBlock<float> sines;
+
+    HeapBlock<int> reversedIndices;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumFFT);
 };
@@ -40,6 +40,11 @@ float RendererThread::getPercentsComplete() const
     return this->percentsDone;
 }
 
+RendererThread::LoudnessStats RendererThread::getLoudnessStats() const
+{
+    const ScopedReadLock lock(this->statsLock);
+    return this->loudnessStats;
+}
 
 void RendererThread::startRecording(const File &file)
 {
@@ -66,6 +71,11 @@ void RendererThread::startRecording(const File &file)
             const ScopedWriteLock pl(this->percentsLock);
             this->percentsDone = 0.f;
         }
+
+        {
+            const ScopedWriteLock sl(this->statsLock);
+            this->loudnessStats = LoudnessStats();
+        }
         
         if (file.getFileExtension().toLowerCase() == ".wav")
         {
@@ -185,6 +195,10 @@ void RendererThread::run()
     jassert(hasNextMessage);
     
     AudioSampleBuffer mixingBuffer(numOutChannels, bufferSize);
+
+    LoudnessMeter meter;
+    meter.prepare(sampleRate);
+    LoudnessStats stats;
     
     double prevEventTimeStamp = 0.0;
     double lastTick = 0.0;
@@ -284,7 +298,25 @@ void RendererThread::run()
             }
         }
 
-        // step 3e. finally, update counters.
+        // step 3e. measure the levels of what has just been written.
+        meter.resetLevels();
+        meter.process(mixingBuffer.getArrayOfReadPointers(), numOutChannels, bufferSize);
+
+        for (int j = 0; j < jmin(numOutChannels, LOUDNESS_METER_MAX_CHANNELS); ++j)
+        {
+            stats.peak = jmax(stats.peak, meter.getPeak(j));
+            stats.truePeak = jmax(stats.truePeak, meter.getTruePeak(j));
+        }
+
+        stats.maxShortTermLoudness = jmax(stats.maxShortTermLoudness, meter.getShortTermLoudness());
+        stats.integratedLoudness = meter.getIntegratedLoudness();
+
+        {
+            const ScopedWriteLock sl(this->statsLock);
+            this->loudnessStats = stats;
+        }
+
+        // step 3f. finally, update counters.
         currentFrame += bufferSize;
 
         {
@@ -305,6 +337,11 @@ void RendererThread::run()
         const ScopedLock sl(this->writerLock);
         this->writer = nullptr;
     }
+
+    Logger::writeToLog("Rendered: " +
+        String(stats.integratedLoudness, 1) + " LUFS integrated, " +
+        String(stats.maxShortTermLoudness, 1) + " LUFS max short-term, " +
+        String(Decibels::gainToDecibels(stats.truePeak), 1) + " dBTP");
     
     if (! this->threadShouldExit())
     {
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Transport.h"
+#include "AudioMonitor.h"
 
 class RendererThread final : private Thread
 {
@@ -28,6 +29,18 @@ public:
     
     float getPercentsComplete() const;
 
+    // Measured on the fly while rendering, to check the result
+    // without having to analyze the file afterwards
+    struct LoudnessStats final
+    {
+        float peak = 0.f;
+        float truePeak = 0.f;
+        float integratedLoudness = LOUDNESS_METER_SILENCE_LUFS;
+        float maxShortTermLoudness = LOUDNESS_METER_SILENCE_LUFS;
+    };
+
+    LoudnessStats getLoudnessStats() const;
+
     void startRecording(const File &file);
     void stop();
     bool isRecording() const;
@@ -49,6 +62,9 @@ private:
 
     ReadWriteLock percentsLock;
     float percentsDone;
+
+    ReadWriteLock statsLock;
+    LoudnessStats loudnessStats;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RendererThread)
 };
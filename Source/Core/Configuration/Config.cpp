@@ -20,8 +20,120 @@
 #include "App.h"
 #include "DocumentHelpers.h"
 #include "XmlSerializer.h"
+#include "BinarySerializer.h"
 #include "SerializationKeys.h"
 
+#define CONFIG_SECTION_PREFIX "settings."
+#define CONFIG_SECTION_EXTENSION ".helio"
+#define CONFIG_SAVE_STOP_TIMEOUT 10000
+
+struct ConfigSection final
+{
+    Identifier name;
+    File file;
+    ValueTree tree;
+};
+
+// The sections are copied on the message thread,
+// so that the config may be changed while they are being saved
+static ConfigSection createSectionSnapshot(const ValueTree &config,
+    const Identifier &name, const File &file)
+{
+    ConfigSection section;
+    section.name = name;
+    section.file = file;
+
+    if (name == Serialization::Core::globalConfig)
+    {
+        section.tree = ValueTree(Serialization::Core::globalConfig);
+        section.tree.copyPropertiesFrom(config, nullptr);
+    }
+    else
+    {
+        section.tree = config.getChildWithName(name).createCopy();
+    }
+
+    return section;
+}
+
+static Array<Identifier> saveSections(InterProcessLock &fileLock,
+    const Array<ConfigSection> &sections, const File &legacyFileToRemove)
+{
+    Array<Identifier> failedSections;
+
+    InterProcessLock::ScopedLockType fLock(fileLock);
+    if (!fLock.isLocked())
+    {
+        Logger::writeToLog("Config !fLock.isLocked()");
+        for (const auto &section : sections)
+        {
+            failedSections.add(section.name);
+        }
+
+        return failedSections;
+    }
+
+    for (const auto &section : sections)
+    {
+        if (!section.tree.isValid())
+        {
+            // the section was removed since the last save
+            section.file.deleteFile();
+        }
+        else if (!DocumentHelpers::save<BinarySerializer>(section.file, section.tree))
+        {
+            failedSections.add(section.name);
+        }
+    }
+
+    // all the settings have been moved from the legacy file by now
+    if (failedSections.isEmpty() && legacyFileToRemove.existsAsFile())
+    {
+        legacyFileToRemove.deleteFile();
+    }
+
+    return failedSections;
+}
+
+// Writes the changed sections, so that the message thread
+// doesn't wait for the disk when some setting is updated
+class Config::SaveThread final : public Thread
+{
+public:
+
+    SaveThread(InterProcessLock &fileLock, const Array<ConfigSection> &sections,
+        const File &legacyFileToRemove) :
+        Thread("Config Save Thread"),
+        fileLock(fileLock),
+        sections(sections),
+        legacyFileToRemove(legacyFileToRemove) {}
+
+    ~SaveThread() override
+    {
+        this->stopThread(CONFIG_SAVE_STOP_TIMEOUT);
+    }
+
+    void run() override
+    {
+        this->failedSections = saveSections(this->fileLock,
+            this->sections, this->legacyFileToRemove);
+    }
+
+    const Array<Identifier> &getFailedSections() const noexcept
+    {
+        return this->failedSections;
+    }
+
+private:
+
+    InterProcessLock &fileLock;
+    const Array<ConfigSection> sections;
+    const File legacyFileToRemove;
+    Array<Identifier> failedSections;
+
+    JUCE_DECLARE_NON_COPYABLE(SaveThread)
+};
+
 String Config::getDeviceId()
 {
     const String systemStats =
@@ -70,7 +182,6 @@ void Config::load(Serializable &serializer, const Identifier &key)
 
 Config::Config(int timeoutToSaveMs) :
     fileLock("Config Lock"),
-    needsSaving(false),
     saveTimeout(timeoutToSaveMs)
 {
     this->config = ValueTree(Serialization::Core::globalConfig);
@@ -81,9 +192,18 @@ Config::Config(int timeoutToSaveMs) :
 Config::~Config()
 {
     this->setProperty(Serialization::Core::machineID, this->getDeviceId());
+    this->stopTimer();
+    this->waitForBackgroundSave();
     this->saveIfNeeded();
 }
 
+File Config::getSectionFile(const Identifier &section) const
+{
+    return this->propertiesFile.getSiblingFile(CONFIG_SECTION_PREFIX +
+        section.toString() + CONFIG_SECTION_EXTENSION);
+}
+
+// Synchronous save of whatever has changed, used on shutdown
 bool Config::saveIfNeeded()
 {
     if (this->propertiesFile.getFullPathName().isEmpty())
@@ -91,27 +211,65 @@ bool Config::saveIfNeeded()
         return false;
     }
 
+    if (this->dirtySections.isEmpty())
+    {
+        return true;
+    }
+
     Logger::writeToLog("Config::saveIfNeeded - " + this->propertiesFile.getFullPathName());
 
-    InterProcessLock::ScopedLockType fLock(this->fileLock);
-    if (!fLock.isLocked())
+    Array<ConfigSection> sections;
+    for (const auto &name : this->dirtySections)
     {
-        Logger::writeToLog("Config !fLock.isLocked()");
-        return false;
+        sections.add(createSectionSnapshot(this->config, name, this->getSectionFile(name)));
     }
 
-    if (DocumentHelpers::save<XmlSerializer>(this->propertiesFile, this->config))
+    this->dirtySections = saveSections(this->fileLock, sections, this->propertiesFile);
+    return this->dirtySections.isEmpty();
+}
+
+void Config::saveInBackground()
+{
+    jassert(this->saveThread == nullptr);
+
+    if (this->propertiesFile.getFullPathName().isEmpty() ||
+        this->dirtySections.isEmpty())
     {
-        needsSaving = false;
-        return true;
+        return;
+    }
+
+    Array<ConfigSection> sections;
+    for (const auto &name : this->dirtySections)
+    {
+        sections.add(createSectionSnapshot(this->config, name, this->getSectionFile(name)));
+    }
+
+    this->dirtySections.clearQuick();
+    this->saveThread = new SaveThread(this->fileLock, sections, this->propertiesFile);
+    this->saveThread->startThread(3);
+}
+
+void Config::waitForBackgroundSave()
+{
+    if (this->saveThread == nullptr)
+    {
+        return;
+    }
+
+    this->saveThread->waitForThreadToExit(CONFIG_SAVE_STOP_TIMEOUT);
+
+    // whatever failed to save will be retried next time
+    for (const auto &name : this->saveThread->getFailedSections())
+    {
+        this->dirtySections.addIfNotAlreadyThere(name);
     }
 
-    return false;
+    this->saveThread = nullptr;
 }
 
 bool Config::reload()
 {
-    if (!this->propertiesFile.existsAsFile())
+    if (this->propertiesFile.getFullPathName().isEmpty())
     {
         return false;
     }
@@ -120,33 +278,90 @@ bool Config::reload()
 
     InterProcessLock::ScopedLockType fLock(this->fileLock);
 
-    const ValueTree doc(DocumentHelpers::load<XmlSerializer>(this->propertiesFile));
+    bool loadedAnything = false;
 
-    if (doc.isValid() && doc.hasType(Serialization::Core::globalConfig))
+    // the old all-in-one xml file is converted into sections on the next save
+    if (this->propertiesFile.existsAsFile())
     {
-        this->config = doc;
-        return true;
+        const ValueTree doc(DocumentHelpers::load<XmlSerializer>(this->propertiesFile));
+        if (doc.isValid() && doc.hasType(Serialization::Core::globalConfig))
+        {
+            this->config = doc;
+            this->dirtySections.addIfNotAlreadyThere(Serialization::Core::globalConfig);
+            for (int i = 0; i < doc.getNumChildren(); ++i)
+            {
+                this->dirtySections.addIfNotAlreadyThere(doc.getChild(i).getType());
+            }
+
+            loadedAnything = true;
+        }
+    }
+
+    Array<File> sectionFiles;
+    this->propertiesFile.getParentDirectory().findChildFiles(sectionFiles, File::findFiles, false,
+        CONFIG_SECTION_PREFIX "*" CONFIG_SECTION_EXTENSION);
+
+    for (const auto &file : sectionFiles)
+    {
+        const ValueTree section(DocumentHelpers::load<BinarySerializer>(file));
+        if (!section.isValid())
+        {
+            continue;
+        }
+
+        if (section.hasType(Serialization::Core::globalConfig))
+        {
+            this->config.copyPropertiesFrom(section, nullptr);
+        }
+        else
+        {
+            const ValueTree existingChild(this->config.getChildWithName(section.getType()));
+            this->config.removeChild(existingChild, nullptr);
+            this->config.appendChild(section, nullptr);
+        }
+
+        this->dirtySections.removeFirstMatchingValue(section.getType());
+        loadedAnything = true;
     }
 
-    return false;
+    return loadedAnything;
 }
 
 void Config::timerCallback()
 {
-    this->saveIfNeeded();
-    this->stopTimer();
+    // the previous save is still in progress, let's check on the next tick
+    if (this->saveThread != nullptr && this->saveThread->isThreadRunning())
+    {
+        return;
+    }
+
+    this->waitForBackgroundSave();
+
+    if (this->dirtySections.isEmpty())
+    {
+        this->stopTimer();
+        return;
+    }
+
+    this->saveInBackground();
 }
 
 void Config::saveConfigFor(const Identifier &key, const Serializable *serializable)
 {
+    const auto serialized(serializable->serialize());
     const ValueTree existingChild(this->config.getChildWithName(key));
+    if (existingChild.getChild(0).isEquivalentTo(serialized))
+    {
+        return; // nothing to rewrite
+    }
+
     this->config.removeChild(existingChild, nullptr);
 
     ValueTree root(key);
-    root.appendChild(serializable->serialize(), nullptr);
+    root.appendChild(serialized, nullptr);
 
     this->config.appendChild(root, nullptr);
-    this->onConfigChanged();
+    this->onConfigChanged(key);
 }
 
 void Config::loadConfigFor(const Identifier &key, Serializable *serializable)
@@ -160,8 +375,13 @@ void Config::loadConfigFor(const Identifier &key, Serializable *serializable)
 
 void Config::setProperty(const Identifier &key, const var &value)
 {
+    if (this->config.getProperty(key) == value)
+    {
+        return;
+    }
+
     this->config.setProperty(key, value, nullptr);
-    this->onConfigChanged();
+    this->onConfigChanged(Serialization::Core::globalConfig);
 }
 
 String Config::getProperty(const Identifier &key, const String &fallback) const noexcept
@@ -174,16 +394,18 @@ bool Config::containsPropertyOrChild(const Identifier &key) const noexcept
     return this->config.hasProperty(key) || this->config.getChildWithName(key).isValid();
 }
 
-void Config::onConfigChanged()
+void Config::onConfigChanged(const Identifier &section)
 {
-    this->needsSaving = true;
+    this->dirtySections.addIfNotAlreadyThere(section);
 
     if (this->saveTimeout > 0)
     {
+        // debounce: the save happens when changes stop coming for a while
         this->startTimer(this->saveTimeout);
     }
     else if (this->saveTimeout == 0)
     {
+        this->waitForBackgroundSave();
         this->saveIfNeeded();
     }
 }
@@ -39,10 +39,16 @@ public:
 
 private:
 
-    void onConfigChanged();
+    // Each child node and the top-level properties are stored
+    // as separate binary files, and only the changed ones are rewritten
+    void onConfigChanged(const Identifier &section);
     bool saveIfNeeded();
+    void saveInBackground();
+    void waitForBackgroundSave();
     bool reload();
 
+    File getSectionFile(const Identifier &section) const;
+
     void saveConfigFor(const Identifier &key, const Serializable *serializer);
     void loadConfigFor(const Identifier &key, Serializable *serializer);
 
@@ -60,8 +66,11 @@ private:
     
     ValueTree config;
 
-    bool needsSaving;
+    Array<Identifier> dirtySections;
     int saveTimeout;
 
+    class SaveThread;
+    ScopedPointer<SaveThread> saveThread;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Config)
 };
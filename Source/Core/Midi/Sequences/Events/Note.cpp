@@ -181,6 +181,51 @@ void Note::deserialize(const ValueTree &tree) noexcept
 
 void Note::reset() noexcept {}
 
+#define NOTE_RECORD_ID_SIZE 8
+
+bool Note::serializeRecord(const ValueTree &tree, uint8 *record) noexcept
+{
+    using namespace Serialization;
+
+    const String id(tree.getProperty(Midi::id));
+    const int key = tree.getProperty(Midi::key);
+    const size_t idSize = id.getNumBytesAsUTF8();
+
+    // ids are short, but let's not assume anything
+    if (idSize == 0 || idSize > NOTE_RECORD_ID_SIZE || idSize != size_t(id.length()) ||
+        key < std::numeric_limits<int16>::min() || key > std::numeric_limits<int16>::max())
+    {
+        return false;
+    }
+
+    const auto ts = ByteOrder::swapIfBigEndian(uint32(int32(tree.getProperty(Midi::timestamp))));
+    const auto len = ByteOrder::swapIfBigEndian(uint32(int32(tree.getProperty(Midi::length))));
+    const auto k = ByteOrder::swapIfBigEndian(uint16(int16(key)));
+    const auto vol = ByteOrder::swapIfBigEndian(uint16(int16(tree.getProperty(Midi::volume))));
+
+    zeromem(record, Note::recordSize);
+    memcpy(record, id.toRawUTF8(), idSize);
+    memcpy(record + 8, &ts, 4);
+    memcpy(record + 12, &len, 4);
+    memcpy(record + 16, &k, 2);
+    memcpy(record + 18, &vol, 2);
+    return true;
+}
+
+void Note::deserializeRecord(const uint8 *record) noexcept
+{
+    this->reset();
+
+    const auto idEnd = std::find(record, record + NOTE_RECORD_ID_SIZE, uint8(0));
+    this->id = String::fromUTF8(reinterpret_cast<const char *>(record), int(idEnd - record));
+
+    this->beat = float(int32(ByteOrder::littleEndianInt(record + 8))) / TICKS_PER_BEAT;
+    this->length = float(int32(ByteOrder::littleEndianInt(record + 12))) / TICKS_PER_BEAT;
+    this->key = int16(ByteOrder::littleEndianShort(record + 16));
+    const auto vol = float(int16(ByteOrder::littleEndianShort(record + 18))) / VELOCITY_SAVE_ACCURACY;
+    this->velocity = jmax(jmin(vol, 1.f), 0.f);
+}
+
 void Note::applyChanges(const Note &other) noexcept
 {
     jassert(this->id == other.id);
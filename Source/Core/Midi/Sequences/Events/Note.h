@@ -69,6 +69,12 @@ public:
     void deserialize(const ValueTree &tree) noexcept override;
     void reset() noexcept override;
 
+    // Fixed-width little-endian records used by the binary project format:
+    // [id, up to 8 ascii chars][ts, int32][len, int32][key, int16][vol, int16]
+    static constexpr int recordSize = 20;
+    static bool serializeRecord(const ValueTree &serializedNote, uint8 *record) noexcept;
+    void deserializeRecord(const uint8 *record) noexcept;
+
     //===------------------------------------------------------------------===//
     // Helpers
     //===------------------------------------------------------------------===//
@@ -45,7 +45,8 @@ MidiSequence::MidiSequence(MidiTrack &parentTrack,
     lastStartBeat(0.f),
     lastEndBeat(0.f),
     cachedSequence(),
-    cacheIsOutdated(false) {}
+    cacheIsOutdated(false),
+    revision(0) {}
 
 void MidiSequence::sort()
 {
@@ -173,30 +174,35 @@ UndoStack *MidiSequence::getUndoStack() const noexcept
 void MidiSequence::notifyEventChanged(const MidiEvent &e1, const MidiEvent &e2)
 {
     this->cacheIsOutdated = true;
+    this->revision++;
     this->eventDispatcher.dispatchChangeEvent(e1, e2);
 }
 
 void MidiSequence::notifyEventAdded(const MidiEvent &event)
 {
     this->cacheIsOutdated = true;
+    this->revision++;
     this->eventDispatcher.dispatchAddEvent(event);
 }
 
 void MidiSequence::notifyEventRemoved(const MidiEvent &event)
 {
     this->cacheIsOutdated = true;
+    this->revision++;
     this->eventDispatcher.dispatchRemoveEvent(event);
 }
 
 void MidiSequence::notifyEventRemovedPostAction()
 {
     this->cacheIsOutdated = true;
+    this->revision++;
     this->eventDispatcher.dispatchPostRemoveEvent(this);
 }
 
 void MidiSequence::invalidateSequenceCache()
 {
     this->cacheIsOutdated = true;
+    this->revision++;
 }
 
 void MidiSequence::updateBeatRange(bool shouldNotifyIfChanged)
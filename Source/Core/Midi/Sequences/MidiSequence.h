@@ -105,6 +105,11 @@ public:
     void invalidateSequenceCache();
     void updateBeatRange(bool shouldNotifyIfChanged);
 
+    // Incremented on any change, including the silent ones,
+    // so that the views can tell if their caches are outdated
+    inline int getRevision() const noexcept
+    { return this->revision; }
+
     //===------------------------------------------------------------------===//
     // Helpers
     //===------------------------------------------------------------------===//
@@ -138,6 +143,7 @@ private:
 
     mutable MidiMessageSequence cachedSequence;
     mutable bool cacheIsOutdated;
+    int revision;
 
 private:
 
@@ -98,6 +98,26 @@ void PianoSequence::silentImport(const MidiEvent &eventToImport)
     this->invalidateSequenceCache();
 }
 
+void PianoSequence::silentResetTo(const ValueTree &notesParent)
+{
+    this->reset();
+
+    forEachValueTreeChildWithType(notesParent, e, Serialization::Midi::note)
+    {
+        // parse into a detached note first, so that no new id is generated
+        Note parsed;
+        parsed.deserialize(e);
+        auto note = new Note(this, parsed);
+
+        this->midiEvents.add(note); // sorted later
+        this->usedEventIds.insert(note->getId());
+    }
+
+    this->sort();
+    this->updateBeatRange(false);
+    this->invalidateSequenceCache();
+}
+
 MidiEvent *PianoSequence::insert(const Note &eventParams, const bool undoable)
 {
     if (undoable)
@@ -360,18 +380,66 @@ void PianoSequence::deserialize(const ValueTree &tree)
         return;
     }
 
-    forEachValueTreeChildWithType(root, e, Serialization::Midi::note)
+    if (root.hasProperty(Serialization::Midi::noteRecords))
     {
-        auto note = new Note(this);
-        note->deserialize(e);
+        this->reset();
 
-        this->midiEvents.add(note); // sorted later
-        this->usedEventIds.insert(note->getId());
+        const MemoryBlock *records = root.getProperty(Serialization::Midi::noteRecords).getBinaryData();
+        const size_t numRecords = (records != nullptr) ? records->getSize() / Note::recordSize : 0;
+        const auto *data = static_cast<const uint8 *>(records != nullptr ? records->getData() : nullptr);
+
+        this->midiEvents.ensureStorageAllocated(int(numRecords));
+        for (size_t i = 0; i < numRecords; ++i)
+        {
+            Note parsed;
+            parsed.deserializeRecord(data + i * Note::recordSize);
+            auto note = new Note(this, parsed);
+
+            this->midiEvents.add(note); // sorted later
+            this->usedEventIds.insert(note->getId());
+        }
+
+        this->sort();
+        this->updateBeatRange(false);
+        this->invalidateSequenceCache();
+        return;
     }
 
-    this->sort();
-    this->updateBeatRange(false);
-    this->invalidateSequenceCache();
+    this->silentResetTo(root);
+}
+
+ValueTree PianoSequence::createCompactTrack(const ValueTree &serializedTrack)
+{
+    using namespace Serialization;
+
+    ValueTree compactTrack(serializedTrack.getType());
+    compactTrack.copyPropertiesFrom(serializedTrack, nullptr);
+
+    MemoryBlock records;
+    records.ensureSize(size_t(serializedTrack.getNumChildren()) * Note::recordSize);
+    size_t numRecords = 0;
+
+    for (int i = 0; i < serializedTrack.getNumChildren(); ++i)
+    {
+        const auto child(serializedTrack.getChild(i));
+        if (!child.hasType(Midi::note))
+        {
+            compactTrack.appendChild(child.createCopy(), nullptr);
+            continue;
+        }
+
+        auto *record = static_cast<uint8 *>(records.getData()) + numRecords * Note::recordSize;
+        if (!Note::serializeRecord(child, record))
+        {
+            return {};
+        }
+
+        numRecords++;
+    }
+
+    records.setSize(numRecords * Note::recordSize);
+    compactTrack.setProperty(Midi::noteRecords, var(records), nullptr);
+    return compactTrack;
 }
 
 void PianoSequence::reset()
@@ -39,6 +39,10 @@ public:
     //===------------------------------------------------------------------===//
 
     void silentImport(const MidiEvent &eventToImport) override;
+
+    // Replaces all notes with the ones found in a given tree,
+    // sorting once at the end instead of addSorted per note
+    void silentResetTo(const ValueTree &notesParent);
     
     MidiEvent *insert(const Note &note, const bool undoable);
     bool remove(const Note &note, const bool undoable);
@@ -72,6 +76,11 @@ public:
     void deserialize(const ValueTree &tree) override;
     void reset() override;
 
+    // Used by binary serializer: replaces note nodes of a serialized track
+    // with a single blob of fixed-width records, which deserialize() decodes
+    // directly into notes; returns an invalid tree if any note doesn't fit
+    static ValueTree createCompactTrack(const ValueTree &serializedTrack);
+
 private:
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoSequence);
@@ -41,6 +41,6 @@ void Autosaver::changeListenerCallback(ChangeBroadcaster *source)
 void Autosaver::timerCallback()
 {
     this->stopTimer();
-    this->documentOwner.getDocument()->save();
+    this->documentOwner.getDocument()->saveInBackground();
     Logger::writeToLog("Autosave trigger");
 }
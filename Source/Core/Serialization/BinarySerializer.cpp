@@ -17,20 +17,580 @@
 
 #include "Common.h"
 #include "BinarySerializer.h"
+#include "DocumentHelpers.h"
+#include "SerializationKeys.h"
+#include "PianoSequence.h"
 
 static const char *kHelioHeaderV2String = "Helio2::";
 static const uint64 kHelioHeaderV2 = ByteOrder::littleEndianInt64(kHelioHeaderV2String);
 
+// Chunked container layout:
+// [header, 8 bytes][current chunk table offset, 8 bytes][chunks and tables, append-only]
+// The table offset is updated last, so an interrupted save leaves the previous table valid
+static const char *kHelioHeaderV3String = "Helio3::";
+static const uint64 kHelioHeaderV3 = ByteOrder::littleEndianInt64(kHelioHeaderV3String);
+
+// Same as V3, but the chunks' hashes are xxHash64 checksums verified on loading,
+// and each table is followed by its own checksum and refers to the previous table,
+// so that a corrupted save falls back to the previous one still kept in the file
+static const char *kHelioHeaderV4String = "Helio4::";
+static const uint64 kHelioHeaderV4 = ByteOrder::littleEndianInt64(kHelioHeaderV4String);
+
+#define CHUNKED_HEADER_SIZE 16
+#define CHUNKED_ROOT_KEY "/"
+// rewrite the whole file, when it gets that much bigger than the live data:
+#define CHUNKED_COMPACTION_RATIO 2
+#define CHUNKED_COMPACTION_MIN_SIZE (1024 * 1024)
+// how many previous saves to try, if the latest one is corrupted:
+#define CHUNKED_MAX_TABLES_TO_TRY 8
+
+struct ChunkRecord final
+{
+    String key;
+    String hash;
+    int64 offset;
+    int64 size;
+};
+
+using ChunkTable = SparseHashMap<String, ChunkRecord, StringHash>;
+
+struct SerializedChunk final
+{
+    String key;
+    BinarySerializer::EncodedChunk::Ptr encoded;
+};
+
+//===----------------------------------------------------------------------===//
+// Checksums
+//===----------------------------------------------------------------------===//
+
+// xxHash64, see https://github.com/Cyan4973/xxHash;
+// the main loop runs four independent lanes, which compilers pipeline well
+static const uint64 kXxPrime1 = 11400714785074694791ULL;
+static const uint64 kXxPrime2 = 14029467366897019727ULL;
+static const uint64 kXxPrime3 = 1609587929392839161ULL;
+static const uint64 kXxPrime4 = 9650029242287828579ULL;
+static const uint64 kXxPrime5 = 2870177450012600261ULL;
+
+static inline uint64 xxRotateLeft(uint64 x, int r) noexcept
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64 xxRound(uint64 acc, uint64 input) noexcept
+{
+    acc += input * kXxPrime2;
+    acc = xxRotateLeft(acc, 31);
+    return acc * kXxPrime1;
+}
+
+static inline uint64 xxMergeRound(uint64 acc, uint64 value) noexcept
+{
+    acc ^= xxRound(0, value);
+    return acc * kXxPrime1 + kXxPrime4;
+}
+
+static uint64 xxHash64(const void *data, size_t size) noexcept
+{
+    const auto *p = static_cast<const uint8 *>(data);
+    const auto *const end = p + size;
+    uint64 h;
+
+    if (size >= 32)
+    {
+        const auto *const limit = end - 32;
+        uint64 v1 = kXxPrime1 + kXxPrime2;
+        uint64 v2 = kXxPrime2;
+        uint64 v3 = 0;
+        uint64 v4 = 0 - kXxPrime1;
+
+        do
+        {
+            v1 = xxRound(v1, ByteOrder::littleEndianInt64(p));
+            v2 = xxRound(v2, ByteOrder::littleEndianInt64(p + 8));
+            v3 = xxRound(v3, ByteOrder::littleEndianInt64(p + 16));
+            v4 = xxRound(v4, ByteOrder::littleEndianInt64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = xxRotateLeft(v1, 1) + xxRotateLeft(v2, 7) +
+            xxRotateLeft(v3, 12) + xxRotateLeft(v4, 18);
+
+        h = xxMergeRound(h, v1);
+        h = xxMergeRound(h, v2);
+        h = xxMergeRound(h, v3);
+        h = xxMergeRound(h, v4);
+    }
+    else
+    {
+        h = kXxPrime5;
+    }
+
+    h += uint64(size);
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= xxRound(0, ByteOrder::littleEndianInt64(p));
+        h = xxRotateLeft(h, 27) * kXxPrime1 + kXxPrime4;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= uint64(ByteOrder::littleEndianInt(p)) * kXxPrime1;
+        h = xxRotateLeft(h, 23) * kXxPrime2 + kXxPrime3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+    {
+        h ^= uint64(*p) * kXxPrime5;
+        h = xxRotateLeft(h, 11) * kXxPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kXxPrime2;
+    h ^= h >> 29;
+    h *= kXxPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+static String getChecksumString(const void *data, size_t size)
+{
+    return String::toHexString(static_cast<int64>(xxHash64(data, size)));
+}
+
+//===----------------------------------------------------------------------===//
+// Chunks
+//===----------------------------------------------------------------------===//
+
+static bool isChunksGroup(const ValueTree &node)
+{
+    using namespace Serialization;
+    return node.hasType(Core::treeItem) &&
+        (node.getChildWithName(Core::treeItem).isValid() ||
+            node.getChildWithName(Core::chunk).isValid());
+}
+
+static String getChunkKey(const ValueTree &node, const String &path)
+{
+    using namespace Serialization;
+
+    if (node.hasProperty(Core::trackId))
+    {
+        return node.getProperty(Core::trackId);
+    }
+
+    if (node.hasProperty(VCS::vcsItemId))
+    {
+        return node.getProperty(VCS::vcsItemId);
+    }
+
+    return path;
+}
+
+// Builds the root chunk, where every track and every other top-level
+// node is replaced with a placeholder, leaving the source tree untouched;
+// the placeholders already present in the tree are kept as they are,
+// and their chunks are added as invalid trees, to be reused by the key
+static ValueTree createChunksSkeleton(const ValueTree &node, const String &path,
+    Array<ValueTree> &outChunks, StringArray &outKeys)
+{
+    using namespace Serialization;
+
+    ValueTree skeleton(node.getType());
+    skeleton.copyPropertiesFrom(node, nullptr);
+
+    const bool isRoot = (path == CHUNKED_ROOT_KEY);
+
+    for (int i = 0; i < node.getNumChildren(); ++i)
+    {
+        const ValueTree child(node.getChild(i));
+        const String childPath(path + child.getType().toString() + String(i) + "/");
+
+        if (child.hasType(Core::chunk))
+        {
+            skeleton.appendChild(child.createCopy(), nullptr);
+            outChunks.add({});
+            outKeys.add(child.getProperty(Core::chunkKey));
+        }
+        else if (isChunksGroup(child))
+        {
+            skeleton.appendChild(createChunksSkeleton(child, childPath, outChunks, outKeys), nullptr);
+        }
+        else if (isRoot || child.hasType(Core::treeItem))
+        {
+            String key(getChunkKey(child, childPath));
+            if (outKeys.contains(key))
+            {
+                jassertfalse;
+                key = childPath;
+            }
+
+            ValueTree placeholder(Core::chunk);
+            placeholder.setProperty(Core::chunkKey, key, nullptr);
+            skeleton.appendChild(placeholder, nullptr);
+
+            outChunks.add(child);
+            outKeys.add(key);
+        }
+        else
+        {
+            skeleton.appendChild(child.createCopy(), nullptr);
+        }
+    }
+
+    return skeleton;
+}
+
+// Piano tracks are stored as blobs of fixed-width note records,
+// which are decoded right into the sequence on loading
+static ValueTree createCompactChunk(const ValueTree &chunk)
+{
+    using namespace Serialization;
+
+    const auto track(chunk.getChildWithName(Midi::track));
+    if (!chunk.hasType(Core::treeItem) || !track.isValid())
+    {
+        return chunk;
+    }
+
+    const auto compactTrack(PianoSequence::createCompactTrack(track));
+    if (!compactTrack.isValid())
+    {
+        return chunk;
+    }
+
+    ValueTree compactChunk(chunk.getType());
+    compactChunk.copyPropertiesFrom(chunk, nullptr);
+
+    for (int i = 0; i < chunk.getNumChildren(); ++i)
+    {
+        const auto child(chunk.getChild(i));
+        compactChunk.appendChild((child == track) ? compactTrack : child.createCopy(), nullptr);
+    }
+
+    return compactChunk;
+}
+
+static Result serializeChunks(const ValueTree &tree,
+    const BinarySerializer::EncodedChunks &reusedChunks,
+    BinarySerializer::EncodedChunks &outEncodedChunks,
+    Array<SerializedChunk> &outChunks)
+{
+    Array<ValueTree> chunks;
+    StringArray keys;
+    const auto skeleton(createChunksSkeleton(tree, CHUNKED_ROOT_KEY, chunks, keys));
+    chunks.insert(0, skeleton);
+    keys.insert(0, CHUNKED_ROOT_KEY);
+
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        SerializedChunk chunk;
+        chunk.key = keys[i];
+
+        const auto &node = chunks.getReference(i);
+        if (!node.isValid())
+        {
+            const auto found = reusedChunks.find(chunk.key);
+            if (found == reusedChunks.end())
+            {
+                jassertfalse;
+                return Result::fail("Failed to save");
+            }
+
+            chunk.encoded = found->second;
+        }
+        else
+        {
+            MemoryBlock data;
+
+            {
+                MemoryOutputStream chunkStream(data, false);
+                createCompactChunk(node).writeToStream(chunkStream);
+            }
+
+            const auto hash(getChecksumString(data.getData(), data.getSize()));
+            chunk.encoded = new BinarySerializer::EncodedChunk(hash, data);
+            outEncodedChunks[chunk.key] = chunk.encoded;
+        }
+
+        outChunks.add(chunk);
+    }
+
+    return Result::ok();
+}
+
+// Only checks the header, so that a truncated or foreign file is rejected
+// right away; returns the offset of the current chunk table, or 0
+static int64 readChunkTableOffset(InputStream &in, uint64 &outHeader)
+{
+    const int64 totalLength = in.getTotalLength();
+    if (totalLength < CHUNKED_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    in.setPosition(0);
+    outHeader = static_cast<uint64>(in.readInt64());
+    if (outHeader != kHelioHeaderV3 && outHeader != kHelioHeaderV4)
+    {
+        return 0;
+    }
+
+    const int64 tableOffset = in.readInt64();
+    if (tableOffset < CHUNKED_HEADER_SIZE || tableOffset >= totalLength)
+    {
+        return 0;
+    }
+
+    return tableOffset;
+}
+
+static bool readChunkTable(InputStream &in, int64 tableOffset, bool hasChecksums,
+    ChunkTable &outTable, int64 &outPreviousTableOffset)
+{
+    const int64 totalLength = in.getTotalLength();
+    outPreviousTableOffset = 0;
+
+    in.setPosition(tableOffset);
+
+    if (hasChecksums)
+    {
+        // read before anything else, so that the previous save
+        // is reachable even if the rest of this table is broken
+        const int64 previousTableOffset = in.readInt64();
+        if (previousTableOffset >= CHUNKED_HEADER_SIZE && previousTableOffset < tableOffset)
+        {
+            outPreviousTableOffset = previousTableOffset;
+        }
+    }
+
+    const int numChunks = in.readInt();
+    if (numChunks <= 0 || numChunks > (totalLength - tableOffset))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        ChunkRecord record;
+        record.key = in.readString();
+        record.hash = in.readString();
+        record.offset = in.readInt64();
+        record.size = in.readInt64();
+
+        if (record.offset < CHUNKED_HEADER_SIZE || record.size < 0 ||
+            record.offset + record.size > tableOffset)
+        {
+            return false;
+        }
+
+        outTable[record.key] = record;
+    }
+
+    if (hasChecksums)
+    {
+        const int64 tableSize = in.getPosition() - tableOffset;
+        if (in.getNumBytesRemaining() < 8)
+        {
+            return false;
+        }
+
+        const auto expectedChecksum = static_cast<uint64>(in.readInt64());
+
+        MemoryBlock tableData;
+        in.setPosition(tableOffset);
+        if (in.readIntoMemoryBlock(tableData, ssize_t(tableSize)) != size_t(tableSize) ||
+            xxHash64(tableData.getData(), tableData.getSize()) != expectedChecksum)
+        {
+            return false;
+        }
+    }
+
+    return outTable.find(CHUNKED_ROOT_KEY) != outTable.end();
+}
+
+static void writeChunkTable(OutputStream &out, const Array<ChunkRecord> &records,
+    int64 previousTableOffset)
+{
+    MemoryOutputStream table;
+    table.writeInt64(previousTableOffset);
+    table.writeInt(records.size());
+    for (const auto &record : records)
+    {
+        table.writeString(record.key);
+        table.writeString(record.hash);
+        table.writeInt64(record.offset);
+        table.writeInt64(record.size);
+    }
+
+    out.write(table.getData(), table.getDataSize());
+    out.writeInt64(static_cast<int64>(xxHash64(table.getData(), table.getDataSize())));
+}
+
+static ChunkRecord writeChunk(OutputStream &out, const SerializedChunk &chunk)
+{
+    ChunkRecord record;
+    record.key = chunk.key;
+    record.hash = chunk.encoded->hash;
+    record.offset = out.getPosition();
+    record.size = int64(chunk.encoded->data.getSize());
+    out.write(chunk.encoded->data.getData(), chunk.encoded->data.getSize());
+    return record;
+}
+
+static Result writeChunkedStream(FileOutputStream &fileStream, const Array<SerializedChunk> &chunks)
+{
+    fileStream.setPosition(0);
+    fileStream.truncate();
+    fileStream.writeInt64(kHelioHeaderV4);
+    fileStream.writeInt64(0);
+
+    Array<ChunkRecord> records;
+    for (const auto &chunk : chunks)
+    {
+        records.add(writeChunk(fileStream, chunk));
+    }
+
+    const int64 tableOffset = fileStream.getPosition();
+    writeChunkTable(fileStream, records, 0);
+
+    fileStream.setPosition(8);
+    fileStream.writeInt64(tableOffset);
+    fileStream.flush();
+
+    return fileStream.getStatus();
+}
+
+static Result writeChunkedFile(const File &file, const Array<SerializedChunk> &chunks)
+{
+    DocumentHelpers::TempDocument tempDoc(file);
+
+    {
+        FileOutputStream fileStream(tempDoc.getFile());
+        if (!fileStream.openedOk())
+        {
+            return Result::fail("Failed to save");
+        }
+
+        const auto result = writeChunkedStream(fileStream, chunks);
+        if (result.failed())
+        {
+            return result;
+        }
+    }
+
+    return tempDoc.overwriteTargetFileWithTemporary() ?
+        Result::ok() : Result::fail("Failed to save");
+}
+
+// Chunks are verified and parsed right from the mapped file, without copying
+static ValueTree readChunk(const MemoryInputStream &in, const ChunkRecord &record, bool hasChecksums)
+{
+    const auto *data = static_cast<const char *>(in.getData()) + record.offset;
+    const auto size = size_t(record.size);
+
+    if (hasChecksums && getChecksumString(data, size) != record.hash)
+    {
+        return {};
+    }
+
+    return ValueTree::readFromData(data, size);
+}
+
+// Replaces placeholders with the chunks they refer to, at any depth
+static bool resolveChunks(ValueTree node, const MemoryInputStream &in,
+    const ChunkTable &table, bool hasChecksums)
+{
+    using namespace Serialization;
+
+    for (int i = node.getNumChildren(); --i >= 0;)
+    {
+        const ValueTree child(node.getChild(i));
+        if (child.hasType(Core::chunk))
+        {
+            node.removeChild(i, nullptr);
+
+            const auto found = table.find(child.getProperty(Core::chunkKey).toString());
+            if (found == table.end())
+            {
+                return false;
+            }
+
+            const auto chunk(readChunk(in, found->second, hasChecksums));
+            if (!chunk.isValid())
+            {
+                return false;
+            }
+
+            node.addChild(chunk, i, nullptr);
+        }
+        else if (!resolveChunks(child, in, table, hasChecksums))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static Result loadChunkedFile(const File &file, ValueTree &tree)
+{
+    // chunks are read straight from the mapped file, so that only
+    // the resulting tree (with compact note blobs) takes memory
+    MemoryMappedFile mappedFile(file, MemoryMappedFile::readOnly);
+    if (mappedFile.getData() == nullptr)
+    {
+        return Result::fail("Failed to load");
+    }
+
+    MemoryInputStream mappedStream(mappedFile.getData(), mappedFile.getSize(), false);
+
+    uint64 header = 0;
+    int64 tableOffset = readChunkTableOffset(mappedStream, header);
+    const bool hasChecksums = (header == kHelioHeaderV4);
+
+    for (int i = 0; i < CHUNKED_MAX_TABLES_TO_TRY && tableOffset > 0; ++i)
+    {
+        ChunkTable table;
+        int64 previousTableOffset = 0;
+        if (readChunkTable(mappedStream, tableOffset, hasChecksums, table, previousTableOffset))
+        {
+            ValueTree result(readChunk(mappedStream, table[CHUNKED_ROOT_KEY], hasChecksums));
+            if (result.isValid() && resolveChunks(result, mappedStream, table, hasChecksums))
+            {
+                if (i > 0)
+                {
+                    // only a marker for the document owner, never saved back
+                    Logger::writeToLog("The latest save is corrupted, loaded the previous one: " + file.getFullPathName());
+                    result.setProperty(Serialization::Core::loadedPreviousSave, true, nullptr);
+                }
+
+                tree = result;
+                return Result::ok();
+            }
+        }
+
+        tableOffset = previousTableOffset;
+    }
+
+    return Result::fail("File is corrupted");
+}
+
 Result BinarySerializer::saveToFile(File file, const ValueTree &tree) const
 {
     FileOutputStream fileStream(file);
     if (fileStream.openedOk())
     {
+        // the chunked container is only used for projects (see saveToFileIncrementally),
+        // other documents, like config or workspace, stay readable by older versions
         fileStream.setPosition(0);
         fileStream.truncate();
         fileStream.writeInt64(kHelioHeaderV2);
         tree.writeToStream(fileStream);
-        return Result::ok();
+        fileStream.flush();
+        return fileStream.getStatus();
     }
 
     return Result::fail("Failed to save");
@@ -47,11 +607,108 @@ Result BinarySerializer::loadFromFile(const File &file, ValueTree &tree) const
             tree = ValueTree::readFromStream(fileStream);
             return Result::ok();
         }
+        else if (magicNumber == kHelioHeaderV3 || magicNumber == kHelioHeaderV4)
+        {
+            return loadChunkedFile(file, tree);
+        }
     }
 
     return Result::fail("Failed to load");
 }
 
+Result BinarySerializer::saveToFileIncrementally(File file, const ValueTree &tree,
+    const EncodedChunks &reusedChunks, EncodedChunks &outEncodedChunks) const
+{
+    Array<SerializedChunk> chunks;
+    const auto serialized = serializeChunks(tree, reusedChunks, outEncodedChunks, chunks);
+    if (serialized.failed())
+    {
+        return serialized;
+    }
+
+    ChunkTable existingTable;
+    int64 existingLength = 0;
+    int64 existingTableOffset = 0;
+
+    if (file.existsAsFile())
+    {
+        // older containers have no checksums, so they are just rewritten
+        FileInputStream fileStream(file);
+        uint64 header = 0;
+        int64 previousTableOffset = 0;
+        if (fileStream.openedOk())
+        {
+            existingTableOffset = readChunkTableOffset(fileStream, header);
+            if (existingTableOffset > 0 && header == kHelioHeaderV4 &&
+                readChunkTable(fileStream, existingTableOffset, true, existingTable, previousTableOffset))
+            {
+                existingLength = fileStream.getTotalLength();
+            }
+        }
+    }
+
+    if (existingLength == 0)
+    {
+        return writeChunkedFile(file, chunks);
+    }
+
+    int64 liveSize = 0;
+    int64 appendedSize = 0;
+    Array<ChunkRecord> records;
+    Array<const SerializedChunk *> dirtyChunks;
+
+    for (const auto &chunk : chunks)
+    {
+        const int64 chunkSize = int64(chunk.encoded->data.getSize());
+        liveSize += chunkSize;
+
+        const auto found = existingTable.find(chunk.key);
+        if (found != existingTable.end() && found->second.hash == chunk.encoded->hash)
+        {
+            records.add(found->second);
+        }
+        else
+        {
+            dirtyChunks.add(&chunk);
+            appendedSize += chunkSize;
+        }
+    }
+
+    if (dirtyChunks.isEmpty() && records.size() == int(existingTable.size()))
+    {
+        return Result::ok();
+    }
+
+    if (existingLength + appendedSize > CHUNKED_COMPACTION_MIN_SIZE &&
+        existingLength + appendedSize > liveSize * CHUNKED_COMPACTION_RATIO)
+    {
+        return writeChunkedFile(file, chunks);
+    }
+
+    // FileOutputStream starts writing at the end of existing file
+    FileOutputStream fileStream(file);
+    if (!fileStream.openedOk())
+    {
+        return Result::fail("Failed to save");
+    }
+
+    for (const auto *chunk : dirtyChunks)
+    {
+        records.add(writeChunk(fileStream, *chunk));
+    }
+
+    const int64 tableOffset = fileStream.getPosition();
+    writeChunkTable(fileStream, records, existingTableOffset);
+    fileStream.flush();
+
+    // only now the new table becomes visible
+    fileStream.setPosition(8);
+    fileStream.writeInt64(tableOffset);
+    fileStream.flush();
+
+    return fileStream.getStatus();
+}
+
 Result BinarySerializer::saveToString(String &string, const ValueTree &tree) const
 {
     MemoryOutputStream memStream;
@@ -80,5 +737,7 @@ bool BinarySerializer::supportsFileWithExtension(const String &extension) const
 
 bool BinarySerializer::supportsFileWithHeader(const String &header) const
 {
-    return header.startsWith(kHelioHeaderV2String);
+    return header.startsWith(kHelioHeaderV2String) ||
+        header.startsWith(kHelioHeaderV3String) ||
+        header.startsWith(kHelioHeaderV4String);
 }
@@ -32,4 +32,36 @@ public:
     bool supportsFileWithExtension(const String &extension) const override;
     bool supportsFileWithHeader(const String &header) const override;
 
+    // A chunk, as it was encoded by one of the saves; it is never
+    // modified afterwards, so it can be shared between threads
+    class EncodedChunk final : public ReferenceCountedObject
+    {
+    public:
+
+        EncodedChunk(const String &hash, MemoryBlock &data) : hash(hash)
+        {
+            this->data.swapWith(data);
+        }
+
+        const String hash;
+        MemoryBlock data;
+
+        using Ptr = ReferenceCountedObjectPtr<EncodedChunk>;
+    };
+
+    using EncodedChunks = SparseHashMap<String, EncodedChunk::Ptr, StringHash>;
+
+    // Saves the tree as a chunked container, where every track (and other
+    // top-level node) is a separate chunk; if the file already is a container,
+    // only the chunks whose content has changed are appended to it,
+    // and the file is rewritten from scratch once it grows too fragmented;
+    // all chunks and tables are checksummed, and, if the latest save turns out
+    // to be corrupted, loadFromFile falls back to the previous ones in the file.
+    // Any tree item may also be given as a Core::chunk placeholder, whose key
+    // refers to one of reusedChunks, so that the caller doesn't have to serialize
+    // the nodes unchanged since their previous save; every chunk encoded
+    // by this call is added to outEncodedChunks
+    Result saveToFileIncrementally(File file, const ValueTree &tree,
+        const EncodedChunks &reusedChunks, EncodedChunks &outEncodedChunks) const;
+
 };
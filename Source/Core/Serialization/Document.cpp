@@ -22,6 +22,56 @@
 #include "App.h"
 #include "MainLayout.h"
 
+// Writes a snapshot, prepared on the message thread, to a temporary file
+// and moves it over the target; never aborts in the middle of writing
+class Document::BackgroundSaveThread final : public Thread, private AsyncUpdater
+{
+public:
+
+    BackgroundSaveThread(Document &owner, DocumentOwner::SnapshotWriter writer, const File &target) :
+        Thread("Save Thread"),
+        owner(owner),
+        writer(writer),
+        target(target),
+        savedOk(false) {}
+
+    ~BackgroundSaveThread() override
+    {
+        this->cancelPendingUpdate();
+        this->waitForThreadToExit(-1);
+    }
+
+    bool wasSavedOk() const noexcept { return this->savedOk; }
+    const File &getTarget() const noexcept { return this->target; }
+
+    void waitUntilDone()
+    {
+        this->waitForThreadToExit(-1);
+        this->cancelPendingUpdate();
+    }
+
+private:
+
+    void run() override
+    {
+        this->savedOk = this->writer(this->target);
+        this->triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        // will delete this thread object
+        this->owner.onBackgroundSaveDone(this->savedOk, this->target);
+    }
+
+    Document &owner;
+    const DocumentOwner::SnapshotWriter writer;
+    const File target;
+    bool savedOk;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BackgroundSaveThread)
+};
+
 Document::Document(DocumentOwner &documentOwner,
                    const String &defaultName,
                    const String &defaultExtension) :
@@ -52,6 +102,7 @@ Document::Document(DocumentOwner &documentOwner,
 
 Document::~Document()
 {
+    this->waitForBackgroundSave();
     this->owner.removeChangeListener(this);
 }
 
@@ -75,6 +126,8 @@ void Document::renameFile(const String &newName)
     if (newName == this->workingFile.getFileNameWithoutExtension())
     { return; }
 
+    this->waitForBackgroundSave();
+
     const String safeNewName = File::createLegalFileName(newName);
 
     File newFile(this->workingFile.getSiblingFile(safeNewName + "." + this->extension));
@@ -109,6 +162,32 @@ void Document::forceSave()
     this->internalSave(this->workingFile);
 }
 
+void Document::saveInBackground()
+{
+    if (!this->hasChanges)
+    {
+        return;
+    }
+
+    // the previous autosave is still writing, the next trigger will catch up
+    if (this->backgroundSave != nullptr)
+    {
+        return;
+    }
+
+    auto writer = this->owner.onDocumentSnapshot();
+    if (writer == nullptr)
+    {
+        this->internalSave(this->workingFile);
+        return;
+    }
+
+    // any changes made from now on will set the flag back on
+    this->hasChanges = false;
+    this->backgroundSave = new BackgroundSaveThread(*this, writer, this->workingFile);
+    this->backgroundSave->startThread(3);
+}
+
 void Document::saveAs()
 {
 #if HELIO_DESKTOP
@@ -250,8 +329,38 @@ int64 Document::calculateFileHashCode(const File &file) const
     return stream != nullptr ? calculateStreamHashCode(*stream) : 0;
 }
 
+void Document::waitForBackgroundSave()
+{
+    if (this->backgroundSave != nullptr)
+    {
+        // let the pending write complete before anything else touches the file,
+        // however long it takes, and then handle it as if it finished normally,
+        // since the async callback is cancelled at this point
+        this->backgroundSave->waitUntilDone();
+        this->onBackgroundSaveDone(this->backgroundSave->wasSavedOk(),
+            this->backgroundSave->getTarget());
+    }
+}
+
+void Document::onBackgroundSaveDone(bool savedOk, File result)
+{
+    ScopedPointer<BackgroundSaveThread> finishedSave(this->backgroundSave.release());
+
+    if (savedOk)
+    {
+        Logger::writeToLog("Document::saveInBackground ok :: " + result.getFullPathName());
+        this->owner.onDocumentDidSave(result);
+        return;
+    }
+
+    Logger::writeToLog("Document::saveInBackground failed :: " + result.getFullPathName());
+    this->hasChanges = true;
+}
+
 bool Document::internalSave(File result)
 {
+    this->waitForBackgroundSave();
+
     const String fullPath = result.getFullPathName();
     const auto firstCharAfterLastSlash = fullPath.lastIndexOfChar(File::getSeparatorChar()) + 1;
     const auto lastDot = fullPath.lastIndexOfChar('.');
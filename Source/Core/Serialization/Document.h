@@ -47,6 +47,7 @@ public:
 
     void save();
     void forceSave();
+    void saveInBackground(); // used by autosaver
     void saveAs();
     void exportAs(const String &exportExtension,
                   const String &defaultFilename = "");
@@ -66,6 +67,12 @@ protected:
 
     bool internalSave(File result);
     bool internalLoad(File result);
+
+    class BackgroundSaveThread;
+    friend class BackgroundSaveThread;
+    ScopedPointer<BackgroundSaveThread> backgroundSave;
+    void waitForBackgroundSave();
+    void onBackgroundSaveDone(bool savedOk, File result);
     bool fileHasBeenModified() const;
 
     int64 calculateStreamHashCode(InputStream &in) const;
@@ -36,12 +36,19 @@ public:
     Document *getDocument() const noexcept
     { return this->document; }
 
+    // A self-contained writer for a snapshot of the document,
+    // safe to call on a worker thread after the owner is gone
+    using SnapshotWriter = Function<bool(const File &file)>;
+
 protected:
 
     virtual bool onDocumentLoad(File &file) = 0;
     virtual void onDocumentDidLoad(File &file) {}
     virtual bool onDocumentSave(File &file) = 0;
     virtual void onDocumentDidSave(File &file) {}
+    // Called on the message thread; owners that can't provide
+    // a detached snapshot are saved synchronously via onDocumentSave
+    virtual SnapshotWriter onDocumentSnapshot() { return nullptr; }
     virtual void onDocumentImport(File &file) = 0;
     virtual bool onDocumentExport(File &file) = 0;
 
@@ -55,6 +55,52 @@ struct JsonParser final
     }
 
     static Result parseString(const juce_wchar quoteChar, String::CharPointerType &t, String &result)
+    {
+        // fast path: most strings have no escape sequences,
+        // so they can be created right from the input buffer
+        auto end = t;
+        for (;;)
+        {
+            const auto c = *end;
+            if (c == quoteChar)
+            {
+                result = String(t, end);
+                t = ++end;
+                return Result::ok();
+            }
+
+            if (c == '\\' || c == 0) { break; }
+            ++end;
+        }
+
+        return parseEscapedString(quoteChar, t, result);
+    }
+
+    static Result parseIdentifier(const juce_wchar quoteChar, String::CharPointerType &t, Identifier &result)
+    {
+        // same as above, but skips creating a temporary string
+        auto end = t;
+        for (;;)
+        {
+            const auto c = *end;
+            if (c == quoteChar)
+            {
+                result = (end == t) ? Identifier() : Identifier(t, end);
+                t = ++end;
+                return Result::ok();
+            }
+
+            if (c == '\\' || c == 0) { break; }
+            ++end;
+        }
+
+        String name;
+        const auto r = parseEscapedString(quoteChar, t, name);
+        result = name.isEmpty() ? Identifier() : Identifier(name);
+        return r;
+    }
+
+    static Result parseEscapedString(const juce_wchar quoteChar, String::CharPointerType &t, String &result)
     {
         MemoryOutputStream buffer(256);
 
@@ -292,11 +338,10 @@ private:
             if (c == 0) { return createFail("Unexpected end-of-input in object declaration"); }
             if (c == '"')
             {
-                String nodeNameVar;
-                const auto r = parseString('"', t, nodeNameVar);
+                Identifier nodeName;
+                const auto r = parseIdentifier('"', t, nodeName);
                 if (r.failed()) { return r; }
 
-                const Identifier nodeName(nodeNameVar);
                 if (nodeName.isValid())
                 {
                     skipCommentsAndWhitespaces(t);
@@ -424,34 +469,34 @@ struct JsonFormatter final
             }
         }
 
-        using GroupedChildren = HashMap<Identifier, Array<ValueTree>, IdentifierHash>;
-        GroupedChildren children;
-        for (const auto child : tree)
+        // children are grouped by type, in order of appearance;
+        // most nodes have children of one or two types, so linear search is fine
+        Array<Identifier> childrenTypes;
+        for (const auto &child : tree)
         {
-            children.getReference(child.getType()).add(child);
+            childrenTypes.addIfNotAlreadyThere(child.getType());
         }
 
-        for (GroupedChildren::Iterator i(children); i.next();)
+        for (int i = 0; i < childrenTypes.size(); ++i)
         {
-            const auto childrenType(i.getKey());
-            const auto childGroupOfSameType(i.getValue());
+            const auto &childrenType = childrenTypes.getReference(i);
 
             if (!allOnOneLine) { writeSpaces(out, indentLevel + indentSize); }
             out << '"';
             writeString(out, childrenType);
             out << "\": ";
 
-            if (childGroupOfSameType.size() == 1)
+            const auto firstChild(tree.getChildWithName(childrenType));
+            if (countChildrenWithType(tree, childrenType) == 1)
             {
-                writeObject(out, childGroupOfSameType.getFirst(), indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
+                writeObject(out, firstChild, indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
             }
             else
             {
-                writeArray(out, childGroupOfSameType, indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
+                writeArray(out, tree, childrenType, indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
             }
 
-            GroupedChildren::Iterator endCheck(i);
-            if (endCheck.next())
+            if (i < childrenTypes.size() - 1)
             {
                 if (allOnOneLine) { out << ", "; } else { out << ',' << newLine; }
             }
@@ -487,7 +532,7 @@ struct JsonFormatter final
         }
         else if (v.isInt() || v.isInt64())
         {
-            out << v.toString();
+            writeInteger(out, static_cast<int64>(v));
         }
         else if (v.isDouble())
         {
@@ -501,6 +546,40 @@ struct JsonFormatter final
         }
     }
 
+    static int countChildrenWithType(const ValueTree &tree, const Identifier &type)
+    {
+        int result = 0;
+        for (const auto &child : tree)
+        {
+            result += child.hasType(type) ? 1 : 0;
+        }
+
+        return result;
+    }
+
+    // Avoids creating a temporary string for every number
+    static void writeInteger(OutputStream &out, int64 value)
+    {
+        char buffer[24];
+        char *end = buffer + sizeof(buffer);
+        char *t = end;
+
+        auto v = (value < 0) ? (0 - static_cast<uint64>(value)) : static_cast<uint64>(value);
+        do
+        {
+            *--t = static_cast<char>('0' + (v % 10));
+            v /= 10;
+        } while (v > 0);
+
+        if (value < 0) { *--t = '-'; }
+        out.write(t, static_cast<size_t>(end - t));
+    }
+
+    static inline bool isPlainChar(juce_wchar c) noexcept
+    {
+        return c >= 32 && c < 127 && c != '"' && c != '\\';
+    }
+
     static void writeEscapedChar(OutputStream &out, const unsigned short value)
     {
         out << "\\u" << String::toHexString((int)value).paddedLeft('0', 4);
@@ -510,6 +589,15 @@ struct JsonFormatter final
     {
         for (;;)
         {
+            // plain ascii runs are written at once, they are single bytes in utf-8
+            auto runEnd = t;
+            while (isPlainChar(*runEnd)) { ++runEnd; }
+            if (runEnd != t)
+            {
+                out.write(t.getAddress(), static_cast<size_t>(runEnd.getAddress() - t.getAddress()));
+                t = runEnd;
+            }
+
             auto c = t.getAndAdvance();
 
             switch (c)
@@ -559,33 +647,34 @@ struct JsonFormatter final
         out.writeRepeatedByte(' ', (size_t)numSpaces);
     }
 
-    static void writeArray(OutputStream &out, const Array<ValueTree> &array,
+    static void writeArray(OutputStream &out, const ValueTree &parent, const Identifier &childrenType,
         int indentLevel, bool allOnOneLine, int maximumDecimalPlaces)
     {
         out << '[';
 
-        if (!array.isEmpty())
+        bool isFirst = true;
+        for (const auto &child : parent)
         {
-            if (!allOnOneLine) { out << newLine; }
+            if (!child.hasType(childrenType)) { continue; }
 
-            for (int i = 0; i < array.size(); ++i)
+            if (isFirst)
             {
-                if (!allOnOneLine) { writeSpaces(out, indentLevel + indentSize); }
-
-                writeObject(out, array.getReference(i),
-                    indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
-
-                if (i < array.size() - 1)
-                {
-                    if (allOnOneLine) { out << ", "; } else { out << ',' << newLine; }
-                }
-                else if (!allOnOneLine)
-                {
-                    out << newLine;
-                }
+                if (!allOnOneLine) { out << newLine; }
+                isFirst = false;
+            }
+            else
+            {
+                if (allOnOneLine) { out << ", "; } else { out << ',' << newLine; }
             }
 
-            if (!allOnOneLine) { writeSpaces(out, indentLevel); }
+            if (!allOnOneLine) { writeSpaces(out, indentLevel + indentSize); }
+            writeObject(out, child, indentLevel + indentSize, allOnOneLine, maximumDecimalPlaces);
+        }
+
+        if (!isFirst && !allOnOneLine)
+        {
+            out << newLine;
+            writeSpaces(out, indentLevel);
         }
 
         out << ']';
@@ -617,7 +706,12 @@ Result JsonSerializer::saveToFile(File file, const ValueTree &tree) const
         fileStream.truncate();
 
         JsonFormatter::write(fileStream, tree, this->headerComments, 0, this->allOnOneLine, 6);
-        return Result::ok();
+        fileStream.flush();
+
+        if (fileStream.getStatus().wasOk())
+        {
+            return Result::ok();
+        }
     }
 
     return Result::fail("Failed to save");
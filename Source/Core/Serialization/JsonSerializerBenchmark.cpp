@@ -0,0 +1,124 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "JsonSerializerBenchmark.h"
+#include "JsonSerializer.h"
+
+struct BenchmarkTiming final
+{
+    double bestMs = DBL_MAX;
+    double totalMs = 0.0;
+};
+
+static BenchmarkTiming measure(int numIterations, const Function<void()> &callback)
+{
+    // warm up the allocator and the caches first
+    callback();
+
+    BenchmarkTiming timing;
+    for (int i = 0; i < numIterations; ++i)
+    {
+        const int64 startTicks = Time::getHighResolutionTicks();
+        callback();
+        const int64 endTicks = Time::getHighResolutionTicks();
+
+        const double ms = Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1000.0;
+        timing.bestMs = jmin(timing.bestMs, ms);
+        timing.totalMs += ms;
+    }
+
+    return timing;
+}
+
+static void printTiming(const char *name, const BenchmarkTiming &timing, int numIterations, size_t numBytes)
+{
+    const double megabytes = double(numBytes) / (1024.0 * 1024.0);
+    const double megabytesPerSecond = megabytes / jmax(0.000001, timing.bestMs / 1000.0);
+    printf("%-32s best %10.3f ms, average %10.3f ms, %8.2f MB/s\n",
+        name, timing.bestMs, timing.totalMs / numIterations, megabytesPerSecond);
+}
+
+void JsonSerializerBenchmark::run(const String &commandLine)
+{
+    const StringArray toks(StringArray::fromTokens(commandLine, true));
+
+    const int fileNameIndex = toks.indexOf("-B") + 1;
+    if (fileNameIndex <= 0 || fileNameIndex >= toks.size())
+    {
+        printf("JsonSerializerBenchmark::run -B (json file name) [-n (number of iterations)]\n\n");
+        return;
+    }
+
+    const String fileName(toks[fileNameIndex].unquoted());
+    const File file(File::isAbsolutePath(fileName) ? File(fileName) :
+        File::getCurrentWorkingDirectory().getChildFile(fileName));
+
+    const int numIterationsIndex = toks.indexOf("-n") + 1;
+    const int numIterations = (numIterationsIndex > 0) ?
+        jmax(1, toks[numIterationsIndex].getIntValue()) : JSON_BENCHMARK_DEFAULT_ITERATIONS;
+
+    const String text(file.loadFileAsString());
+    if (text.isEmpty())
+    {
+        printf("JsonSerializerBenchmark::run ERROR can't read %s\n", file.getFullPathName().toRawUTF8());
+        return;
+    }
+
+    JsonSerializer serializer;
+    ValueTree tree;
+    const auto result = serializer.loadFromString(text, tree);
+    if (result.failed() || !tree.isValid())
+    {
+        printf("JsonSerializerBenchmark::run ERROR can't parse %s\n", file.getFullPathName().toRawUTF8());
+        return;
+    }
+
+    const var json(JSON::parse(text));
+    const size_t numBytes = text.getNumBytesAsUTF8();
+
+    printf("\n%s, %d bytes, %d iterations\n\n",
+        file.getFullPathName().toRawUTF8(), int(numBytes), numIterations);
+
+    const auto parseTiming = measure(numIterations, [&serializer, &text]()
+    {
+        ValueTree parsed;
+        serializer.loadFromString(text, parsed);
+    });
+
+    const auto juceParseTiming = measure(numIterations, [&text]()
+    {
+        const var parsed(JSON::parse(text));
+    });
+
+    const auto formatTiming = measure(numIterations, [&serializer, &tree]()
+    {
+        String formatted;
+        serializer.saveToString(formatted, tree);
+    });
+
+    const auto juceFormatTiming = measure(numIterations, [&json]()
+    {
+        const String formatted(JSON::toString(json));
+    });
+
+    printTiming("JsonSerializer::loadFromString", parseTiming, numIterations, numBytes);
+    printTiming("JSON::parse", juceParseTiming, numIterations, numBytes);
+    printTiming("JsonSerializer::saveToString", formatTiming, numIterations, numBytes);
+    printTiming("JSON::toString", juceFormatTiming, numIterations, numBytes);
+    printf("\n");
+}
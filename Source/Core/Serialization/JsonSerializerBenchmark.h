@@ -0,0 +1,40 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#define JSON_BENCHMARK_DEFAULT_ITERATIONS 20
+
+// Measures JsonSerializer parsing and formatting of a given file,
+// next to JUCE's own JSON parser and writer, which ours is derived from,
+// and which still creates a var for every token and a stream for every string.
+// Only uses the public serializer API, so that it can also be run
+// against the older revisions to compare the results.
+class JsonSerializerBenchmark final
+{
+public:
+
+    JsonSerializerBenchmark() = default;
+
+    // -B (json file name) [-n (number of iterations)]
+    void run(const String &commandLine);
+
+private:
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JsonSerializerBenchmark)
+
+};
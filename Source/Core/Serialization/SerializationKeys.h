@@ -75,6 +75,11 @@ namespace Serialization
 
         static const Identifier filePath = "filePath";
 
+        // Chunked binary container placeholders
+        static const Identifier chunk = "chunk";
+        static const Identifier chunkKey = "key";
+        static const Identifier loadedPreviousSave = "loadedPreviousSave";
+
         static const Identifier clipboard = "helioClipboard";
     } // namespace Core
 
@@ -115,6 +120,9 @@ namespace Serialization
         static const Identifier length = "len";
         static const Identifier volume = "vol";
 
+        // Binary format only: all notes as a blob of fixed-width records
+        static const Identifier noteRecords = "noteRecords";
+
         static const Identifier text = "text";
         static const Identifier colour = "colour";
 
@@ -188,6 +196,8 @@ namespace Serialization
         static const Identifier lastUsedScale = "lastUsedScale";
         static const Identifier lastUsedLogin = "lastUsedLogin";
         static const Identifier lastUpdatesInfo = "lastUpdatesInfo";
+        static const Identifier undoHistoryDepth = "undoHistoryDepth";
+        static const Identifier pluginsList = "pluginsList";
     } // namespace Config
 
     // Available types of dynamically fetched resources/configs
@@ -341,6 +351,7 @@ namespace Serialization
         static const Identifier packItem = "record";
         static const Identifier packItemRevId = "itemId";
         static const Identifier packItemDeltaId = "deltaId";
+        static const Identifier packItemData = "data";
 
         static const Identifier revision = "revision";
         static const Identifier head = "head";
@@ -352,6 +363,10 @@ namespace Serialization
         static const Identifier commitVersion = "version";
         static const Identifier commitId = "id";
 
+        // Runtime-only cached hashes, never saved
+        static const Identifier commitHash = "hash";
+        static const Identifier commitTreeHash = "treeHash";
+
         static const Identifier vcsItemId = "vcsId";
 
         static const Identifier revisionItem = "revisionItem";
@@ -482,6 +497,16 @@ namespace Serialization
         static const Identifier undoStack = "undoStack";
         static const Identifier transaction = "transaction";
 
+        static const Identifier journalHeader = "journal";
+        static const Identifier journalPerform = "perform";
+        static const Identifier journalUndo = "undo";
+        static const Identifier journalClear = "clear";
+        static const Identifier journalTruncate = "truncate";
+        static const Identifier journalCheckpoint = "checkpoint";
+        static const Identifier journalRecordId = "journalRecordId";
+        static const Identifier startsTransaction = "startsTransaction";
+        static const Identifier projectId = "projectId";
+
         static const Identifier name = "name";
         static const Identifier xPath = "path";
         static const Identifier trackId = "trackId";
@@ -508,6 +533,7 @@ namespace Serialization
         static const Identifier noteAfter = "noteAfter";
         static const Identifier groupBefore = "groupBefore";
         static const Identifier groupAfter = "groupAfter";
+        static const Identifier groupDelta = "groupDelta";
         static const Identifier instanceBefore = "instanceBefore";
         static const Identifier instanceAfter = "instanceAfter";
 
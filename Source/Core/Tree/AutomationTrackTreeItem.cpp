@@ -207,16 +207,7 @@ void AutomationTrackTreeItem::deserialize(const ValueTree &tree)
 
     this->deserializeVCSUuid(tree);
     this->deserializeTrackProperties(tree);
-
-    forEachValueTreeChildWithType(tree, e, Serialization::Midi::automation)
-    {
-        this->sequence->deserialize(e);
-    }
-
-    forEachValueTreeChildWithType(tree, e, Serialization::Midi::pattern)
-    {
-        this->pattern->deserialize(e);
-    }
+    this->deserializeTrackContent(tree);
 
     // Proceed with basic properties and children
     TreeItem::deserialize(tree);
@@ -458,6 +458,30 @@ ProjectTreeItem *MidiTrackTreeItem::getProject() const noexcept
     return this->lastFoundParent;
 }
 
+void MidiTrackTreeItem::deserializeTrackContent(const ValueTree &tree)
+{
+    if (this->lastFoundParent != nullptr &&
+        this->lastFoundParent->deferTrackDeserialization(this, tree))
+    {
+        return;
+    }
+
+    this->deserializeSequenceAndPattern(tree);
+}
+
+void MidiTrackTreeItem::deserializeSequenceAndPattern(const ValueTree &tree)
+{
+    // Sequence is able to find its node within the track node
+    this->sequence->deserialize(tree);
+
+    // Pattern keeps its default clip for legacy tracks with no pattern node
+    const auto patternNode = tree.getChildWithName(Serialization::Midi::pattern);
+    if (patternNode.isValid())
+    {
+        this->pattern->deserialize(patternNode);
+    }
+}
+
 //===----------------------------------------------------------------------===//
 // Dragging
 //===----------------------------------------------------------------------===//
@@ -49,6 +49,9 @@ public:
 
     void importMidi(const MidiMessageSequence &sequence);
 
+    // Doesn't send any notifications, so it is safe to call from a worker thread
+    void deserializeSequenceAndPattern(const ValueTree &tree);
+
     //===------------------------------------------------------------------===//
     // VCS::TrackedItem
     //===------------------------------------------------------------------===//
@@ -127,6 +130,9 @@ public:
 
 protected:
 
+    // Parses sequence and pattern, or defers that to the project's parallel loader
+    void deserializeTrackContent(const ValueTree &tree);
+
     ProjectTreeItem *lastFoundParent;
 
     ScopedPointer<MidiSequence> sequence;
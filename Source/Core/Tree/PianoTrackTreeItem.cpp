@@ -219,16 +219,7 @@ void PianoTrackTreeItem::deserialize(const ValueTree &tree)
 
     this->deserializeVCSUuid(tree);
     this->deserializeTrackProperties(tree);
-
-    forEachValueTreeChildWithType(tree, e, Serialization::Midi::track)
-    {
-        this->sequence->deserialize(e);
-    }
-
-    forEachValueTreeChildWithType(tree, e, Serialization::Midi::pattern)
-    {
-        this->pattern->deserialize(e);
-    }
+    this->deserializeTrackContent(tree);
 
     // Proceed with basic properties and children
     TreeItem::deserialize(tree);
@@ -324,9 +315,5 @@ void PianoTrackTreeItem::resetEventsDelta(const ValueTree &state)
 {
     jassert(state.hasType(PianoSequenceDeltas::notesAdded));
 
-    this->getSequence()->reset();
-    forEachValueTreeChildWithType(state, e, Serialization::Midi::note)
-    {
-        this->getSequence()->silentImport(Note(this->getSequence()).withParameters(e));
-    }
+    static_cast<PianoSequence *>(this->getSequence())->silentResetTo(state);
 }
@@ -18,7 +18,6 @@
 #include "Common.h"
 #include "ProjectTreeItem.h"
 
-#include "TreeItemChildrenSerializer.h"
 #include "TrackGroupTreeItem.h"
 #include "PianoTrackTreeItem.h"
 #include "AutomationTrackTreeItem.h"
@@ -29,8 +28,8 @@
 #include "Autosaver.h"
 #include "Document.h"
 #include "DocumentHelpers.h"
-#include "XmlSerializer.h"
 #include "BinarySerializer.h"
+#include "TreeItemChildrenSerializer.h"
 
 #include "AudioCore.h"
 #include "PlayerThread.h"
@@ -58,6 +57,140 @@
 #include "SerializationKeys.h"
 #include "Config.h"
 #include "Icons.h"
+#include "Profiler.h"
+
+class ProjectTreeItem::LoadJob final : public ThreadPoolJob
+{
+public:
+
+    LoadJob(Function<void()> task, Atomic<int> &numDone, WaitableEvent &onDone) :
+        ThreadPoolJob("Project Load Job"),
+        task(task),
+        numDone(numDone),
+        onDone(onDone) {}
+
+    JobStatus runJob() override
+    {
+        // Each task only touches its own data while deserializing,
+        // and the message thread is blocked in loadDeferredJobs() meanwhile
+        this->task();
+        ++this->numDone;
+        this->onDone.signal();
+        return jobHasFinished;
+    }
+
+private:
+
+    Function<void()> task;
+
+    Atomic<int> &numDone;
+    WaitableEvent &onDone;
+
+    JUCE_DECLARE_NON_COPYABLE(LoadJob)
+};
+
+// A snapshot refers to the unchanged tracks' chunks with placeholders instead
+// of serializing them again, and the chunks encoded by a successful save
+// are kept for the next snapshots, until their tracks change
+class ProjectTreeItem::TrackChunksCache final
+{
+public:
+
+    TrackChunksCache() = default;
+
+    // Filled in on the message thread, then passed to the save thread,
+    // and read back on the message thread when the save is done
+    class Snapshot final : public ReferenceCountedObject
+    {
+    public:
+
+        BinarySerializer::EncodedChunks reusedChunks;
+        BinarySerializer::EncodedChunks encodedChunks;
+        StringArray serializedTrackIds;
+
+        using Ptr = ReferenceCountedObjectPtr<Snapshot>;
+    };
+
+    Snapshot::Ptr startSnapshot()
+    {
+        this->changedTrackIds.clear();
+        this->allTracksChanged = false;
+        this->snapshot = new Snapshot();
+        return this->snapshot;
+    }
+
+    void finishSnapshot()
+    {
+        if (this->snapshot == nullptr)
+        {
+            return;
+        }
+
+        // the tracks changed while saving are already outdated in the file
+        for (const auto &trackId : this->snapshot->serializedTrackIds)
+        {
+            const auto found = this->snapshot->encodedChunks.find(trackId);
+            if (!this->allTracksChanged &&
+                found != this->snapshot->encodedChunks.end() &&
+                this->changedTrackIds.find(trackId) == this->changedTrackIds.end())
+            {
+                this->savedChunks[trackId] = found->second;
+            }
+        }
+
+        this->snapshot = nullptr;
+    }
+
+    // Used as a substitution while serializing the project's children:
+    // the tracks which haven't changed since they were saved become
+    // the placeholders, and all other items serialize themselves as usual
+    ValueTree substitute(const TreeItem &item)
+    {
+        using namespace Serialization;
+        jassert(this->snapshot != nullptr);
+
+        const auto *track = dynamic_cast<const MidiTrackTreeItem *>(&item);
+        if (track == nullptr)
+        {
+            return {};
+        }
+
+        const String &trackId = track->getTrackId();
+        const auto found = this->savedChunks.find(trackId);
+        if (found == this->savedChunks.end())
+        {
+            this->snapshot->serializedTrackIds.add(trackId);
+            return {};
+        }
+
+        this->snapshot->reusedChunks[trackId] = found->second;
+        ValueTree placeholder(Core::chunk);
+        placeholder.setProperty(Core::chunkKey, trackId, nullptr);
+        return placeholder;
+    }
+
+    void invalidateTrack(const String &trackId)
+    {
+        this->savedChunks.erase(trackId);
+        this->changedTrackIds.insert(trackId);
+    }
+
+    void invalidateAllTracks()
+    {
+        this->savedChunks.clear();
+        this->allTracksChanged = true;
+    }
+
+private:
+
+    BinarySerializer::EncodedChunks savedChunks;
+
+    Snapshot::Ptr snapshot;
+    SparseHashSet<String, StringHash> changedTrackIds;
+    bool allTracksChanged = false;
+
+    JUCE_DECLARE_NON_COPYABLE(TrackChunksCache)
+};
 
 ProjectTreeItem::ProjectTreeItem(const String &name) :
     DocumentOwner(name, "helio"),
@@ -76,6 +209,10 @@ ProjectTreeItem::ProjectTreeItem(const File &existingFile) :
 void ProjectTreeItem::initialize()
 {
     this->isTracksHashOutdated = true;
+    this->isLoadingTracks = false;
+    this->loadedPreviousSave = false;
+    this->snapshotJournalRecordId = 0;
+    this->trackChunks = new TrackChunksCache();
     
     this->undoStack = new UndoStack(*this);
     
@@ -142,6 +279,7 @@ void ProjectTreeItem::deletePermanently()
         File localProjectFile(this->getDocument()->getFullPath());
         App::Workspace().unloadProjectById(this->getId());
         localProjectFile.deleteFile();
+        UndoStack::getJournalFileFor(localProjectFile).deleteFile();
         
         if (this->recentFilesList != nullptr)
         {
@@ -519,7 +657,7 @@ void ProjectTreeItem::reset()
     //this->broadcastChangeProjectBeatRange();
 }
 
-ValueTree ProjectTreeItem::save() const
+ValueTree ProjectTreeItem::save()
 {
     ValueTree tree(Serialization::Core::project);
 
@@ -531,6 +669,11 @@ ValueTree ProjectTreeItem::save() const
     tree.appendChild(this->transport->serialize(), nullptr);
     tree.appendChild(this->sequencerLayout->serialize(), nullptr);
 
+    const TreeItemChildrenSerializer::ScopedSubstitution substitution([this](const TreeItem &item)
+    {
+        return this->trackChunks->substitute(item);
+    });
+
     TreeItemChildrenSerializer::serializeChildren(*this, tree);
 
     return tree;
@@ -546,10 +689,17 @@ void ProjectTreeItem::load(const ValueTree &tree)
     if (!root.isValid()) { return; }
 
     this->info->deserialize(root);
-    this->timeline->deserialize(root);
 
-    // Proceed with basic properties and children
+    // Proceed with basic properties and children;
+    // the timeline and tracks' content are parsed in parallel afterwards.
+    // Version control and the undo stack stay here on the message thread:
+    // the former locks the message manager when created, and the latter
+    // is journaled and checkpointed after the content reload broadcast
+    this->isLoadingTracks = true;
+    this->deferDeserialization([this, root]() { this->timeline->deserialize(root); });
     TreeItem::deserialize(root);
+    this->isLoadingTracks = false;
+    this->loadDeferredJobs();
 
     // Legacy support: if no pattern set manager found, create one
     if (nullptr == this->findChildOfType<PatternEditorTreeItem>())
@@ -578,6 +728,74 @@ void ProjectTreeItem::load(const ValueTree &tree)
     this->sequencerLayout->deserialize(root);
 }
 
+//===----------------------------------------------------------------------===//
+// Loading
+//===----------------------------------------------------------------------===//
+
+void ProjectTreeItem::setLoadProgressCallback(LoadProgressCallback callback)
+{
+    this->loadProgressCallback = callback;
+}
+
+bool ProjectTreeItem::deferTrackDeserialization(MidiTrackTreeItem *track, const ValueTree &tree)
+{
+    if (! this->isLoadingTracks)
+    {
+        return false;
+    }
+
+    this->deferDeserialization([track, tree]() { track->deserializeSequenceAndPattern(tree); });
+    return true;
+}
+
+void ProjectTreeItem::deferDeserialization(Function<void()> task)
+{
+    this->loadJobs.add(new LoadJob(task, this->numLoadedJobs, this->loadJobsEvent));
+}
+
+void ProjectTreeItem::loadDeferredJobs()
+{
+    const int numJobs = this->loadJobs.size();
+    if (numJobs == 0)
+    {
+        return;
+    }
+
+    this->numLoadedJobs = 0;
+
+    {
+        ThreadPool pool(jlimit(1, numJobs, SystemStats::getNumCpus()));
+
+        for (auto job : this->loadJobs)
+        {
+            pool.addJob(job, false);
+        }
+
+        // The message thread is blocked until all the jobs are done,
+        // since the rest of the project depends on them;
+        // it only wakes up when some job has finished
+        int numReported = 0;
+        while (numReported < numJobs)
+        {
+            this->loadJobsEvent.wait();
+
+            const int numLoaded = this->numLoadedJobs.get();
+            if (numLoaded > numReported)
+            {
+                numReported = numLoaded;
+                if (this->loadProgressCallback != nullptr)
+                {
+                    this->loadProgressCallback(numLoaded, numJobs);
+                }
+            }
+        }
+
+        // all jobs are done at this point, the pool just stops its threads
+    }
+
+    this->loadJobs.clear();
+}
+
 void ProjectTreeItem::importMidi(File &file)
 {
     MidiFile tempFile;
@@ -639,35 +857,52 @@ void ProjectTreeItem::removeAllListeners()
 
 void ProjectTreeItem::broadcastChangeEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent)
 {
+    profileScope("ProjectTreeItem::broadcastChangeEvent");
+
     //jassert(oldEvent.isValid()); // old event is allowed to be un-owned
     jassert(newEvent.isValid());
+    this->trackChunks->invalidateTrack(newEvent.getSequence()->getTrackId());
     this->changeListeners.call(&ProjectListener::onChangeMidiEvent, oldEvent, newEvent);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastAddEvent(const MidiEvent &event)
 {
+    profileScope("ProjectTreeItem::broadcastAddEvent");
+
     jassert(event.isValid());
+    this->trackChunks->invalidateTrack(event.getSequence()->getTrackId());
     this->changeListeners.call(&ProjectListener::onAddMidiEvent, event);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastRemoveEvent(const MidiEvent &event)
 {
+    profileScope("ProjectTreeItem::broadcastRemoveEvent");
+
     jassert(event.isValid());
+    this->trackChunks->invalidateTrack(event.getSequence()->getTrackId());
     this->changeListeners.call(&ProjectListener::onRemoveMidiEvent, event);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastPostRemoveEvent(MidiSequence *const layer)
 {
+    profileScope("ProjectTreeItem::broadcastPostRemoveEvent");
+
     this->changeListeners.call(&ProjectListener::onPostRemoveMidiEvent, layer);
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastAddTrack(MidiTrack *const track)
 {
+    profileScope("ProjectTreeItem::broadcastAddTrack");
+
     this->isTracksHashOutdated = true;
+    this->trackChunks->invalidateTrack(track->getTrackId());
 
     if (VCS::TrackedItem *tracked = dynamic_cast<VCS::TrackedItem *>(track))
     {
@@ -676,12 +911,16 @@ void ProjectTreeItem::broadcastAddTrack(MidiTrack *const track)
     }
 
     this->changeListeners.call(&ProjectListener::onAddTrack, track);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastRemoveTrack(MidiTrack *const track)
 {
+    profileScope("ProjectTreeItem::broadcastRemoveTrack");
+
     this->isTracksHashOutdated = true;
+    this->trackChunks->invalidateTrack(track->getTrackId());
 
     if (VCS::TrackedItem *tracked = dynamic_cast<VCS::TrackedItem *>(track))
     {
@@ -690,47 +929,71 @@ void ProjectTreeItem::broadcastRemoveTrack(MidiTrack *const track)
     }
 
     this->changeListeners.call(&ProjectListener::onRemoveTrack, track);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastChangeTrackProperties(MidiTrack *const track)
 {
+    profileScope("ProjectTreeItem::broadcastChangeTrackProperties");
+
+    this->trackChunks->invalidateTrack(track->getTrackId());
     this->changeListeners.call(&ProjectListener::onChangeTrackProperties, track);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastAddClip(const Clip &clip)
 {
+    profileScope("ProjectTreeItem::broadcastAddClip");
+
+    this->trackChunks->invalidateTrack(clip.getPattern()->getTrackId());
     this->changeListeners.call(&ProjectListener::onAddClip, clip);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastChangeClip(const Clip &oldClip, const Clip &newClip)
 {
+    profileScope("ProjectTreeItem::broadcastChangeClip");
+
+    this->trackChunks->invalidateTrack(newClip.getPattern()->getTrackId());
     this->changeListeners.call(&ProjectListener::onChangeClip, oldClip, newClip);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastRemoveClip(const Clip &clip)
 {
+    profileScope("ProjectTreeItem::broadcastRemoveClip");
+
+    this->trackChunks->invalidateTrack(clip.getPattern()->getTrackId());
     this->changeListeners.call(&ProjectListener::onRemoveClip, clip);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastPostRemoveClip(Pattern *const pattern)
 {
+    profileScope("ProjectTreeItem::broadcastPostRemoveClip");
+
     this->changeListeners.call(&ProjectListener::onPostRemoveClip, pattern);
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastChangeProjectInfo(const ProjectInfo *info)
 {
+    profileScope("ProjectTreeItem::broadcastChangeProjectInfo");
+
     this->changeListeners.call(&ProjectListener::onChangeProjectInfo, info);
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 Point<float> ProjectTreeItem::broadcastChangeProjectBeatRange()
 {
+    profileScope("ProjectTreeItem::broadcastChangeProjectBeatRange");
+
     const Point<float> &beatRange = this->getProjectRangeInBeats();
 
     const float &firstBeat = beatRange.getX();
@@ -752,12 +1015,18 @@ Point<float> ProjectTreeItem::broadcastChangeProjectBeatRange()
 
 void ProjectTreeItem::broadcastReloadProjectContent()
 {
+    profileScope("ProjectTreeItem::broadcastReloadProjectContent");
+
+    this->trackChunks->invalidateAllTracks();
     this->changeListeners.call(&ProjectListener::onReloadProjectContent, this->getTracks());
+    this->undoStack->checkpointJournalIfNeeded();
     this->sendChangeMessage();
 }
 
 void ProjectTreeItem::broadcastChangeViewBeatRange(float firstBeat, float lastBeat)
 {
+    profileScope("ProjectTreeItem::broadcastChangeViewBeatRange");
+
     this->changeListeners.call(&ProjectListener::onChangeViewBeatRange, firstBeat, lastBeat);
     // this->sendChangeMessage(); the project itself didn't change, so dont call this
 }
@@ -774,6 +1043,7 @@ bool ProjectTreeItem::onDocumentLoad(File &file)
         const ValueTree tree(DocumentHelpers::load(file));
         if (tree.isValid())
         {
+            this->loadedPreviousSave = tree.getProperty(Serialization::Core::loadedPreviousSave, false);
             this->load(tree);
             return true;
         }
@@ -784,6 +1054,16 @@ bool ProjectTreeItem::onDocumentLoad(File &file)
 
 void ProjectTreeItem::onDocumentDidLoad(File &file)
 {
+    // replays the changes made after the last save, if any;
+    // if the previous save was loaded, replays the ones made after it
+    this->undoStack->openJournal(UndoStack::getJournalFileFor(file));
+
+    if (this->loadedPreviousSave)
+    {
+        this->loadedPreviousSave = false;
+        App::Layout().showTooltip(TRANS("dialog::document::load::recovered"));
+    }
+
     if (this->recentFilesList != nullptr)
     {
         this->recentFilesList->
@@ -796,10 +1076,29 @@ void ProjectTreeItem::onDocumentDidLoad(File &file)
 
 bool ProjectTreeItem::onDocumentSave(File &file)
 {
+    return this->onDocumentSnapshot()(file);
+}
+
+void ProjectTreeItem::onDocumentDidSave(File &file)
+{
+    this->trackChunks->finishSnapshot();
+    this->undoStack->truncateJournal(this->snapshotJournalRecordId);
+    this->undoStack->openJournal(UndoStack::getJournalFileFor(file));
+}
+
+DocumentOwner::SnapshotWriter ProjectTreeItem::onDocumentSnapshot()
+{
+    // the serialized tree is not shared with the model,
+    // so encoding and writing it is safe on any thread;
+    // only the tracks changed since the previous saves are serialized
+    this->snapshotJournalRecordId = this->undoStack->getLastJournalRecordId();
+    const auto snapshot(this->trackChunks->startSnapshot());
     const auto projectNode(this->save());
-    // Debug:
-    DocumentHelpers::save<XmlSerializer>(file.withFileExtension("xml"), projectNode);
-    return DocumentHelpers::save<BinarySerializer>(file, projectNode);
+    return [projectNode, snapshot](const File &file)
+    {
+        return BinarySerializer().saveToFileIncrementally(file, projectNode,
+            snapshot->reusedChunks, snapshot->encodedChunks).wasOk();
+    };
 }
 
 void ProjectTreeItem::onDocumentImport(File &file)
@@ -34,6 +34,7 @@ class UndoStack;
 class RecentFilesList;
 class Pattern;
 class MidiTrack;
+class MidiTrackTreeItem;
 class Clip;
 
 #include "TreeItem.h"
@@ -120,6 +121,18 @@ public:
     Array<MidiTrack *> getSelectedTracks() const;
     Point<float> getProjectRangeInBeats() const;
 
+    //===------------------------------------------------------------------===//
+    // Loading
+    //===------------------------------------------------------------------===//
+
+    // Called on the message thread with the number of load jobs done so far
+    using LoadProgressCallback = Function<void(int numLoaded, int numTotal)>;
+    void setLoadProgressCallback(LoadProgressCallback callback);
+
+    // Tracks call this from their deserialize(): if the project is being loaded,
+    // the track's sequence and pattern are parsed later on worker threads
+    bool deferTrackDeserialization(MidiTrackTreeItem *track, const ValueTree &tree);
+
     //===------------------------------------------------------------------===//
     // Serializable
     //===------------------------------------------------------------------===//
@@ -185,6 +198,8 @@ protected:
     bool onDocumentLoad(File &file) override;
     void onDocumentDidLoad(File &file) override;
     bool onDocumentSave(File &file) override;
+    void onDocumentDidSave(File &file) override;
+    SnapshotWriter onDocumentSnapshot() override;
     void onDocumentImport(File &file) override;
     bool onDocumentExport(File &file) override;
 
@@ -217,8 +232,28 @@ private:
 private:
 
     void initialize();
-    ValueTree save() const;
+    ValueTree save();
     void load(const ValueTree &tree);
+    void deferDeserialization(Function<void()> task);
+    void loadDeferredJobs();
+
+    class LoadJob;
+    OwnedArray<LoadJob> loadJobs;
+    Atomic<int> numLoadedJobs;
+    WaitableEvent loadJobsEvent;
+    LoadProgressCallback loadProgressCallback;
+    bool isLoadingTracks;
+
+    // The latest save was corrupted, and the previous one was loaded instead
+    bool loadedPreviousSave;
+
+    // The undo journal position of the latest snapshot being saved
+    int64 snapshotJournalRecordId;
+
+    // The encoded tracks unchanged since they were saved,
+    // so that a snapshot only serializes the changed ones
+    class TrackChunksCache;
+    ScopedPointer<TrackChunksCache> trackChunks;
 
 private:
 
@@ -25,6 +25,7 @@
 #include "AudioSettings.h"
 #include "ThemeSettings.h"
 #include "OpenGLSettings.h"
+#include "UndoHistorySettings.h"
 #include "TranslationSettings.h"
 #include "ComponentsList.h"
 #include "LabeledSettingsWrapper.h"
@@ -74,6 +75,8 @@ void SettingsTreeItem::recreatePage()
     this->translationSettings = nullptr;
     this->openGLSettingsWrapper = nullptr;
     this->openGLSettings = nullptr;
+    this->undoHistorySettingsWrapper = nullptr;
+    this->undoHistorySettings = nullptr;
     this->themeSettingsWrapper = nullptr;
     this->themeSettings = nullptr;
     this->audioSettingsWrapper = nullptr;
@@ -99,6 +102,10 @@ void SettingsTreeItem::recreatePage()
     this->audioSettingsWrapper = new LabeledSettingsWrapper(this->audioSettings, TRANS("settings::audio"));
     this->settingsList->addAndMakeVisible(this->audioSettingsWrapper);
     
+    this->undoHistorySettings = new UndoHistorySettings();
+    this->undoHistorySettingsWrapper = new LabeledSettingsWrapper(this->undoHistorySettings, TRANS("settings::history"));
+    this->settingsList->addAndMakeVisible(this->undoHistorySettingsWrapper);
+    
 #if ! HELIO_MOBILE
     this->openGLSettings = new OpenGLSettings();
     this->openGLSettingsWrapper = new LabeledSettingsWrapper(this->openGLSettings, TRANS("settings::renderer"));
@@ -56,6 +56,8 @@ private:
     ScopedPointer<Component> themeSettingsWrapper;
     ScopedPointer<Component> openGLSettings;
     ScopedPointer<Component> openGLSettingsWrapper;
+    ScopedPointer<Component> undoHistorySettings;
+    ScopedPointer<Component> undoHistorySettingsWrapper;
     ScopedPointer<Component> translationSettings;
     ScopedPointer<Component> translationSettingsWrapper;
     ScopedPointer<Component> authSettings;
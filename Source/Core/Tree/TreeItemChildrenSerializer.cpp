@@ -28,6 +28,19 @@
 #include "PatternEditorTreeItem.h"
 #include "SettingsTreeItem.h"
 
+TreeItemChildrenSerializer::Substitution TreeItemChildrenSerializer::currentSubstitution;
+
+TreeItemChildrenSerializer::ScopedSubstitution::ScopedSubstitution(Substitution substitution) :
+    previousSubstitution(TreeItemChildrenSerializer::currentSubstitution)
+{
+    TreeItemChildrenSerializer::currentSubstitution = substitution;
+}
+
+TreeItemChildrenSerializer::ScopedSubstitution::~ScopedSubstitution()
+{
+    TreeItemChildrenSerializer::currentSubstitution = this->previousSubstitution;
+}
+
 void TreeItemChildrenSerializer::serializeChildren(const TreeItem &parentItem, ValueTree &parent)
 {
     for (int i = 0; i < parentItem.getNumSubItems(); ++i)
@@ -35,6 +48,17 @@ void TreeItemChildrenSerializer::serializeChildren(const TreeItem &parentItem, V
         if (TreeViewItem *sub = parentItem.getSubItem(i))
         {
             TreeItem *treeItem = static_cast<TreeItem *>(sub);
+
+            if (currentSubstitution != nullptr)
+            {
+                const ValueTree substitute(currentSubstitution(*treeItem));
+                if (substitute.isValid())
+                {
+                    parent.appendChild(substitute, nullptr);
+                    continue;
+                }
+            }
+
             parent.appendChild(treeItem->serialize(), nullptr);
         }
     }
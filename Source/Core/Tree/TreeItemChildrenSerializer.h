@@ -25,4 +25,29 @@ public:
 
     static void serializeChildren(const TreeItem &parentItem, ValueTree &parent);
     static void deserializeChildren(TreeItem &parentItem, const ValueTree &parent);
+
+    // Returns a tree to be used instead of the item's own serialization,
+    // or an invalid tree to let the item serialize itself
+    using Substitution = Function<ValueTree(const TreeItem &item)>;
+
+    // While in scope, all children serialized at any depth go through
+    // the given substitution first; only to be used on the message thread
+    class ScopedSubstitution final
+    {
+    public:
+
+        explicit ScopedSubstitution(Substitution substitution);
+        ~ScopedSubstitution();
+
+    private:
+
+        Substitution previousSubstitution;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedSubstitution)
+    };
+
+private:
+
+    static Substitution currentSubstitution;
+
 };
@@ -164,15 +164,18 @@ void VersionControlTreeItem::toggleQuickStash()
     
     if (this->vcs->hasQuickStash())
     {
-        if (this->vcs->getHead().hasAnythingOnTheStage())
+        // the changes made since are merged with the stashed ones
+        StringArray conflicts;
+        this->vcs->applyQuickStash(conflicts);
+
+        if (conflicts.isEmpty())
         {
-            App::Layout().showTooltip("Cannot revert, stage is not empty!");
-            App::Layout().showModalComponentUnowned(new FailTooltip());
-            return;
+            App::Layout().showTooltip("Toggle changes: latest state");
+        }
+        else
+        {
+            App::Layout().showTooltip(TRANS("vcs::warning::conflicts") + conflicts.joinIntoString(", "));
         }
-        
-        this->vcs->applyQuickStash();
-        App::Layout().showTooltip("Toggle changes: latest state");
     }
     else
     {
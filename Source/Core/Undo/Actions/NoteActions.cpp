@@ -22,6 +22,145 @@
 #include "MidiTrackSource.h"
 #include "SerializationKeys.h"
 
+//===----------------------------------------------------------------------===//
+// Compact group delta
+//===----------------------------------------------------------------------===//
+
+// Group changes are stored as a binary blob: number of notes,
+// then, for each note, its full record before the change (see Note::recordSize),
+// a byte mask of the fields that have changed, and the changed fields' bytes only;
+// the notes after the change are matched by index, so ids are never repeated.
+// This is only how the action is saved with a project and written to the journal:
+// in memory, it keeps the full copies of the notes, which perform, undo and coalescing use.
+
+struct NoteRecordField final
+{
+    int offset;
+    int size;
+};
+
+// timestamp, length, key, volume (the id is never changed)
+static const NoteRecordField noteRecordFields[] = { { 8, 4 }, { 12, 4 }, { 16, 2 }, { 18, 2 } };
+
+static bool serializeNotesDelta(const Array<Note> &before, const Array<Note> &after, MemoryBlock &result)
+{
+    if (before.size() != after.size())
+    {
+        return false;
+    }
+
+    MemoryOutputStream out(result, false);
+    out.writeInt(before.size());
+
+    uint8 recordBefore[Note::recordSize];
+    uint8 recordAfter[Note::recordSize];
+
+    for (int i = 0; i < before.size(); ++i)
+    {
+        const Note &noteBefore = before.getReference(i);
+        const Note &noteAfter = after.getReference(i);
+
+        if (noteBefore.getId() != noteAfter.getId() ||
+            !Note::serializeRecord(noteBefore.serialize(), recordBefore) ||
+            !Note::serializeRecord(noteAfter.serialize(), recordAfter))
+        {
+            return false;
+        }
+
+        uint8 mask = 0;
+        for (int f = 0; f < numElementsInArray(noteRecordFields); ++f)
+        {
+            const auto &field = noteRecordFields[f];
+            if (memcmp(recordBefore + field.offset, recordAfter + field.offset, size_t(field.size)) != 0)
+            {
+                mask |= uint8(1 << f);
+            }
+        }
+
+        out.write(recordBefore, Note::recordSize);
+        out.writeByte(char(mask));
+
+        for (int f = 0; f < numElementsInArray(noteRecordFields); ++f)
+        {
+            if ((mask & (1 << f)) != 0)
+            {
+                const auto &field = noteRecordFields[f];
+                out.write(recordAfter + field.offset, size_t(field.size));
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool deserializeNotesDelta(const MemoryBlock &data, Array<Note> &before, Array<Note> &after)
+{
+    MemoryInputStream in(data, false);
+    const int numNotes = in.readInt();
+    if (numNotes < 0)
+    {
+        return false;
+    }
+
+    before.ensureStorageAllocated(numNotes);
+    after.ensureStorageAllocated(numNotes);
+
+    uint8 recordBefore[Note::recordSize];
+    uint8 recordAfter[Note::recordSize];
+
+    for (int i = 0; i < numNotes; ++i)
+    {
+        if (in.read(recordBefore, Note::recordSize) != Note::recordSize)
+        {
+            return false;
+        }
+
+        const uint8 mask = uint8(in.readByte());
+        memcpy(recordAfter, recordBefore, Note::recordSize);
+
+        for (int f = 0; f < numElementsInArray(noteRecordFields); ++f)
+        {
+            if ((mask & (1 << f)) != 0)
+            {
+                const auto &field = noteRecordFields[f];
+                if (in.read(recordAfter + field.offset, field.size) != field.size)
+                {
+                    return false;
+                }
+            }
+        }
+
+        Note noteBefore;
+        noteBefore.deserializeRecord(recordBefore);
+        before.add(noteBefore);
+
+        Note noteAfter;
+        noteAfter.deserializeRecord(recordAfter);
+        after.add(noteAfter);
+    }
+
+    return true;
+}
+
+// The actual memory taken by the notes copies: the notes themselves,
+// and their ids' text, which is kept alive by these copies
+// (the string's header is a reference count and an allocated size)
+static int getSizeInBytes(const Note &note) noexcept
+{
+    return int(sizeof(Note) + sizeof(int) + sizeof(size_t) + note.getId().getNumBytesAsUTF8() + 1);
+}
+
+static int getSizeInBytes(const Array<Note> &notes) noexcept
+{
+    int result = 0;
+    for (const auto &note : notes)
+    {
+        result += getSizeInBytes(note);
+    }
+
+    return result;
+}
+
 //===----------------------------------------------------------------------===//
 // Insert
 //===----------------------------------------------------------------------===//
@@ -56,7 +195,7 @@ bool NoteInsertAction::undo()
 
 int NoteInsertAction::getSizeInUnits()
 {
-    return sizeof(Note);
+    return getSizeInBytes(this->note);
 }
 
 ValueTree NoteInsertAction::serialize() const
@@ -113,7 +252,7 @@ bool NoteRemoveAction::undo()
 
 int NoteRemoveAction::getSizeInUnits()
 {
-    return sizeof(Note);
+    return getSizeInBytes(this->note);
 }
 
 ValueTree NoteRemoveAction::serialize() const
@@ -174,7 +313,7 @@ bool NoteChangeAction::undo()
 
 int NoteChangeAction::getSizeInUnits()
 {
-    return sizeof(Note) * 2;
+    return getSizeInBytes(this->noteBefore) + getSizeInBytes(this->noteAfter);
 }
 
 UndoAction *NoteChangeAction::createCoalescedAction(UndoAction *nextAction)
@@ -202,6 +341,27 @@ UndoAction *NoteChangeAction::createCoalescedAction(UndoAction *nextAction)
     return nullptr;
 }
 
+bool NoteChangeAction::coalesceWith(UndoAction *nextAction)
+{
+    if (NoteChangeAction *nextChanger =
+        dynamic_cast<NoteChangeAction *>(nextAction))
+    {
+        if (this->trackId == nextChanger->trackId &&
+            this->noteAfter.getId() == nextChanger->noteBefore.getId())
+        {
+            this->noteAfter = nextChanger->noteAfter;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+String NoteChangeAction::getCoalescingTrackId() const
+{
+    return this->trackId;
+}
+
 ValueTree NoteChangeAction::serialize() const
 {
     ValueTree tree(Serialization::Undo::noteChangeAction);
@@ -272,7 +432,7 @@ bool NotesGroupInsertAction::undo()
 
 int NotesGroupInsertAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notes.size());
+    return getSizeInBytes(this->notes);
 }
 
 ValueTree NotesGroupInsertAction::serialize() const
@@ -343,7 +503,7 @@ bool NotesGroupRemoveAction::undo()
 
 int NotesGroupRemoveAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notes.size());
+    return getSizeInBytes(this->notes);
 }
 
 ValueTree NotesGroupRemoveAction::serialize() const
@@ -415,8 +575,7 @@ bool NotesGroupChangeAction::undo()
 
 int NotesGroupChangeAction::getSizeInUnits()
 {
-    return (sizeof(Note) * this->notesBefore.size()) +
-        (sizeof(Note) * this->notesAfter.size());
+    return getSizeInBytes(this->notesBefore) + getSizeInBytes(this->notesAfter);
 }
 
 UndoAction *NotesGroupChangeAction::createCoalescedAction(UndoAction *nextAction)
@@ -459,11 +618,52 @@ UndoAction *NotesGroupChangeAction::createCoalescedAction(UndoAction *nextAction
 // Serializable
 //===----------------------------------------------------------------------===//
 
+bool NotesGroupChangeAction::coalesceWith(UndoAction *nextAction)
+{
+    if (NotesGroupChangeAction *nextChanger =
+        dynamic_cast<NotesGroupChangeAction *>(nextAction))
+    {
+        if (nextChanger->trackId != this->trackId ||
+            nextChanger->notesBefore.size() != this->notesAfter.size())
+        {
+            return false;
+        }
+
+        for (int i = 0; i < this->notesAfter.size(); ++i)
+        {
+            if (this->notesAfter.getReference(i).getId() !=
+                nextChanger->notesBefore.getReference(i).getId())
+            {
+                return false;
+            }
+        }
+
+        // no copying here: the next action is deleted right after that
+        this->notesAfter.swapWith(nextChanger->notesAfter);
+        return true;
+    }
+
+    return false;
+}
+
+String NotesGroupChangeAction::getCoalescingTrackId() const
+{
+    return this->trackId;
+}
+
 ValueTree NotesGroupChangeAction::serialize() const
 {
     ValueTree tree(Serialization::Undo::notesGroupChangeAction);
     tree.setProperty(Serialization::Undo::trackId, this->trackId, nullptr);
-    
+
+    MemoryBlock delta;
+    if (serializeNotesDelta(this->notesBefore, this->notesAfter, delta))
+    {
+        tree.setProperty(Serialization::Undo::groupDelta, var(delta), nullptr);
+        return tree;
+    }
+
+    // Fallback to full copies, e.g. for the notes with unusually long ids
     ValueTree groupBeforeChild(Serialization::Undo::groupBefore);
     ValueTree groupAfterChild(Serialization::Undo::groupAfter);
     
@@ -488,6 +688,17 @@ void NotesGroupChangeAction::deserialize(const ValueTree &tree)
     this->reset();
     
     this->trackId = tree.getProperty(Serialization::Undo::trackId);
+
+    if (const MemoryBlock *delta = tree.getProperty(Serialization::Undo::groupDelta).getBinaryData())
+    {
+        if (! deserializeNotesDelta(*delta, this->notesBefore, this->notesAfter))
+        {
+            this->notesBefore.clear();
+            this->notesAfter.clear();
+        }
+
+        return;
+    }
     
     const auto groupBeforeChild = tree.getChildWithName(Serialization::Undo::groupBefore);
     const auto groupAfterChild = tree.getChildWithName(Serialization::Undo::groupAfter);
@@ -101,6 +101,8 @@ public:
     bool undo() override;
     int getSizeInUnits() override;
     UndoAction *createCoalescedAction(UndoAction *nextAction) override;
+    bool coalesceWith(UndoAction *nextAction) override;
+    String getCoalescingTrackId() const override;
     
     ValueTree serialize() const override;
     void deserialize(const ValueTree &tree) override;
@@ -194,6 +196,8 @@ public:
     bool undo() override;
     int getSizeInUnits() override;
     UndoAction *createCoalescedAction(UndoAction *nextAction) override;
+    bool coalesceWith(UndoAction *nextAction) override;
+    String getCoalescingTrackId() const override;
     
     ValueTree serialize() const override;
     void deserialize(const ValueTree &tree) override;
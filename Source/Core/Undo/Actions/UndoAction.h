@@ -40,6 +40,22 @@ public:
         (void) nextAction;
         return nullptr;
     }
+
+    // Merges the next action into this one in place, keeping this action's
+    // original state and the next one's resulting state; used by the undo stack
+    // in coalescing mode (see UndoStack::beginCoalescing)
+    virtual bool coalesceWith(UndoAction *nextAction)
+    {
+        (void) nextAction;
+        return false;
+    }
+
+    // The undo stack only tries to coalesce an action with the last one
+    // for the same track, so the actions which support it should return their track id
+    virtual String getCoalescingTrackId() const
+    {
+        return {};
+    }
     
 protected:
     
@@ -21,6 +21,7 @@
 #include "SerializationKeys.h"
 
 #include "ProjectTreeItem.h"
+#include "Config.h"
 
 #include "MidiTrackActions.h"
 #include "PianoTrackActions.h"
@@ -32,7 +33,13 @@
 #include "KeySignatureEventActions.h"
 #include "PatternActions.h"
 
-#define MAX_TRANSACTIONS_TO_STORE 10
+// The number of transactions saved with the project
+// can be changed in the settings, see getNumTransactionsToStore
+#define DEFAULT_TRANSACTIONS_TO_STORE 10
+#define MAX_TRANSACTIONS_TO_STORE 1000
+
+#define JOURNAL_FLUSH_INTERVAL_MS 1000
+#define JOURNAL_STOP_TIMEOUT 5000
 
 using namespace Serialization;
 
@@ -159,21 +166,444 @@ UndoAction *UndoStack::ActionSet::createUndoActionsByTagName(const Identifier &t
     return nullptr;
 }
 
+//===----------------------------------------------------------------------===//
+// Journal
+//===----------------------------------------------------------------------===//
+
+// Each record is a size-prefixed binary ValueTree; the records are appended
+// and synced to disk in batches, so that a crash costs at most one batch,
+// and a partially written record at the end of the file is just dropped
+class UndoStack::JournalThread final : public Thread
+{
+public:
+
+    JournalThread(const File &file, const ValueTree &header,
+        int64 validLength, const Array<ValueTree> &existingRecords) :
+        Thread("Journal Thread"),
+        file(file),
+        header(header),
+        validLength(validLength),
+        writtenRecords(existingRecords) {}
+
+    ~JournalThread() override
+    {
+        // the pending records are still written before the thread exits
+        this->signalThreadShouldExit();
+        this->notify();
+        this->stopThread(JOURNAL_STOP_TIMEOUT);
+    }
+
+    const File &getFile() const noexcept
+    {
+        return this->file;
+    }
+
+    void enqueue(const ValueTree &record)
+    {
+        const ScopedLock lock(this->queueLock);
+        this->queue.add(record);
+    }
+
+    void run() override
+    {
+        this->out = new FileOutputStream(this->file);
+        if (this->out->failedToOpen())
+        {
+            this->out = nullptr;
+        }
+        else
+        {
+            this->out->setPosition(this->validLength);
+            this->out->truncate();
+        }
+
+        while (! this->threadShouldExit())
+        {
+            this->wait(JOURNAL_FLUSH_INTERVAL_MS);
+            this->writePendingRecords();
+        }
+
+        this->writePendingRecords();
+        this->out = nullptr;
+    }
+
+private:
+
+    void writePendingRecords()
+    {
+        Array<ValueTree> records;
+
+        {
+            const ScopedLock lock(this->queueLock);
+            records.swapWith(this->queue);
+        }
+
+        if (records.isEmpty() || this->out == nullptr)
+        {
+            return;
+        }
+
+        for (const auto &record : records)
+        {
+            if (record.hasType(Undo::journalTruncate))
+            {
+                this->truncate(record.getProperty(Undo::journalRecordId));
+                continue;
+            }
+
+            if (this->out->getPosition() == 0)
+            {
+                this->writeRecord(this->header);
+            }
+
+            this->writeRecord(record);
+            this->writtenRecords.add(record);
+        }
+
+        // syncs the file to disk
+        this->out->flush();
+    }
+
+    // Drops the records up to the given one, and rewrites the rest;
+    // there are only a few of them, written since the previous save,
+    // and they are written to a temporary file, which then replaces the journal,
+    // so that a crash in the middle of this never loses the surviving records
+    void truncate(int64 recordId)
+    {
+        int numRecordsToDrop = 0;
+        while (numRecordsToDrop < this->writtenRecords.size() &&
+            int64(this->writtenRecords.getReference(numRecordsToDrop)
+                .getProperty(Undo::journalRecordId)) <= recordId)
+        {
+            ++numRecordsToDrop;
+        }
+
+        if (numRecordsToDrop == 0)
+        {
+            return;
+        }
+
+        this->writtenRecords.removeRange(0, numRecordsToDrop);
+
+        TemporaryFile tempFile(this->file);
+        bool writtenOk = false;
+
+        {
+            FileOutputStream tempOut(tempFile.getFile());
+            if (tempOut.openedOk())
+            {
+                if (! this->writtenRecords.isEmpty())
+                {
+                    this->writeRecord(tempOut, this->header);
+                    for (const auto &record : this->writtenRecords)
+                    {
+                        this->writeRecord(tempOut, record);
+                    }
+                }
+
+                tempOut.flush();
+                writtenOk = tempOut.getStatus().wasOk();
+            }
+        }
+
+        if (! writtenOk)
+        {
+            // the old records are still there, but they are skipped on replay anyway
+            return;
+        }
+
+        // can't replace a file that is still open on some platforms
+        this->out = nullptr;
+        tempFile.overwriteTargetFileWithTemporary();
+
+        // a newly opened stream is positioned at the end of file
+        this->out = new FileOutputStream(this->file);
+        if (this->out->failedToOpen())
+        {
+            this->out = nullptr;
+        }
+    }
+
+    void writeRecord(const ValueTree &record)
+    {
+        this->writeRecord(*this->out, record);
+    }
+
+    void writeRecord(OutputStream &stream, const ValueTree &record)
+    {
+        {
+            MemoryOutputStream data(this->buffer, false);
+            record.writeToStream(data);
+            this->bufferSize = data.getDataSize();
+        }
+
+        stream.writeInt(int(this->bufferSize));
+        stream.write(this->buffer.getData(), this->bufferSize);
+    }
+
+    const File file;
+    const ValueTree header;
+    const int64 validLength;
+
+    // The records which are still in the file
+    Array<ValueTree> writtenRecords;
+
+    ScopedPointer<FileOutputStream> out;
+    MemoryBlock buffer;
+    size_t bufferSize = 0;
+
+    CriticalSection queueLock;
+    Array<ValueTree> queue;
+
+    JUCE_DECLARE_NON_COPYABLE(JournalThread)
+};
+
+// Returns the length of the readable part of the journal
+static int64 readJournal(const File &file, Array<ValueTree> &records)
+{
+    FileInputStream in(file);
+    if (in.failedToOpen())
+    {
+        return 0;
+    }
+
+    int64 validLength = 0;
+    MemoryBlock data;
+
+    while (! in.isExhausted())
+    {
+        const int size = in.readInt();
+        if (size <= 0 || size > in.getNumBytesRemaining())
+        {
+            break;
+        }
+
+        data.setSize(size_t(size));
+        if (in.read(data.getData(), size) != size)
+        {
+            break;
+        }
+
+        const auto record = ValueTree::readFromData(data.getData(), size_t(size));
+        if (! record.isValid())
+        {
+            break;
+        }
+
+        records.add(record);
+        validLength = in.getPosition();
+    }
+
+    return validLength;
+}
+
+File UndoStack::getJournalFileFor(const File &projectFile)
+{
+    return projectFile.getSiblingFile(projectFile.getFileName() + ".journal");
+}
+
+void UndoStack::openJournal(const File &journalFile)
+{
+    if (this->journal != nullptr && this->journal->getFile() == journalFile)
+    {
+        return;
+    }
+
+    this->closeJournal();
+
+    Array<ValueTree> records;
+    const int64 validLength = readJournal(journalFile, records);
+    const String projectId = this->project.getId();
+
+    const bool isOwnJournal = records.size() > 0 &&
+        records.getReference(0).hasType(Undo::journalHeader) &&
+        records.getReference(0).getProperty(Undo::projectId).toString() == projectId;
+
+    if (isOwnJournal)
+    {
+        records.remove(0);
+        bool reachedCheckpoint = false;
+
+        for (const auto &record : records)
+        {
+            const int64 recordId = record.getProperty(Undo::journalRecordId);
+            this->lastJournalRecordId = jmax(this->lastJournalRecordId, recordId);
+
+            // skip everything that has made it to the project file,
+            // and everything after the changes which are not in the journal
+            if (recordId > this->serializedJournalRecordId && !reachedCheckpoint)
+            {
+                reachedCheckpoint = record.hasType(Undo::journalCheckpoint);
+                this->replayJournalRecord(record);
+            }
+        }
+    }
+
+    ValueTree header(Undo::journalHeader);
+    header.setProperty(Undo::projectId, projectId, nullptr);
+
+    // someone else's or unreadable journal gets overwritten
+    this->journal = new JournalThread(journalFile, header,
+        isOwnJournal ? validLength : 0,
+        isOwnJournal ? records : Array<ValueTree>());
+
+    this->journal->startThread(3);
+}
+
+void UndoStack::closeJournal()
+{
+    this->flushJournal();
+    this->journal = nullptr;
+}
+
+int64 UndoStack::getLastJournalRecordId()
+{
+    // the pending actions are already in the snapshot
+    this->flushJournal();
+    return this->lastJournalRecordId;
+}
+
+void UndoStack::flushJournal()
+{
+    if (this->pendingJournalActions.isEmpty())
+    {
+        return;
+    }
+
+    // all of them are in the current transaction, see perform()
+    if (const ActionSet *actionSet = this->getCurrentSet())
+    {
+        bool startsTransaction = this->pendingJournalStartsTransaction;
+
+        for (const auto *action : actionSet->actions)
+        {
+            if (! this->pendingJournalActions.contains(action))
+            {
+                continue;
+            }
+
+            ValueTree record(Undo::journalPerform);
+            if (startsTransaction)
+            {
+                record.setProperty(Undo::startsTransaction, true, nullptr);
+                record.setProperty(Undo::name, actionSet->name, nullptr);
+                startsTransaction = false;
+            }
+
+            record.appendChild(action->serialize(), nullptr);
+            this->writeToJournal(record);
+        }
+    }
+
+    this->pendingJournalActions.clearQuick();
+    this->pendingJournalStartsTransaction = false;
+
+    // the flushed actions can't absorb any more changes, as those would be lost
+    this->coalescingTargets.clear();
+}
+
+void UndoStack::truncateJournal(int64 savedJournalRecordId)
+{
+    // the records after the previous save are kept until the next one,
+    // in case the latest save gets corrupted and the previous one is loaded
+    const int64 truncatedRecordId = this->previousSerializedJournalRecordId;
+    this->previousSerializedJournalRecordId = savedJournalRecordId;
+    this->serializedJournalRecordId = savedJournalRecordId;
+
+    if (this->journal != nullptr)
+    {
+        ValueTree command(Undo::journalTruncate);
+        command.setProperty(Undo::journalRecordId, truncatedRecordId, nullptr);
+        this->journal->enqueue(command);
+        this->journal->notify();
+    }
+}
+
+void UndoStack::checkpointJournalIfNeeded()
+{
+    if (this->journal != nullptr &&
+        !this->performingAction &&
+        !this->reentrancyCheck &&
+        !this->lastJournalRecordIsCheckpoint)
+    {
+        this->flushJournal();
+        this->writeToJournal(ValueTree(Undo::journalCheckpoint));
+        this->lastJournalRecordIsCheckpoint = true;
+    }
+}
+
+void UndoStack::writeToJournal(ValueTree record)
+{
+    if (this->journal != nullptr)
+    {
+        record.setProperty(Undo::journalRecordId, ++this->lastJournalRecordId, nullptr);
+        this->journal->enqueue(record);
+        this->lastJournalRecordIsCheckpoint = false;
+    }
+}
+
+void UndoStack::replayJournalRecord(const ValueTree &record)
+{
+    if (record.hasType(Undo::journalPerform))
+    {
+        const auto actionNode = record.getChild(0);
+        ActionSet actionsFactory(this->project, {});
+        if (UndoAction *action = actionsFactory.createUndoActionsByTagName(actionNode.getType()))
+        {
+            action->deserialize(actionNode);
+
+            if (record.getProperty(Undo::startsTransaction))
+            {
+                this->beginNewTransaction(record.getProperty(Undo::name));
+            }
+
+            this->perform(action);
+        }
+    }
+    else if (record.hasType(Undo::journalUndo))
+    {
+        this->undo();
+    }
+    else if (record.hasType(Undo::journalClear))
+    {
+        this->clearUndoHistory();
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// UndoStack
+//===----------------------------------------------------------------------===//
+
 UndoStack::UndoStack(ProjectTreeItem &parentProject,
-    int maxNumberOfUnitsToKeep,
+    int maxNumberOfBytesToKeep,
     int minimumTransactions) :
     project(parentProject),
-    totalUnitsStored(0),
+    totalBytesStored(0),
     nextIndex(0),
+    coalescingDepth(0),
     newTransaction(true),
     reentrancyCheck(false),
-    maxNumUnitsToKeep(maxNumberOfUnitsToKeep),
+    lastJournalRecordId(0),
+    serializedJournalRecordId(0),
+    previousSerializedJournalRecordId(0),
+    lastJournalRecordIsCheckpoint(false),
+    pendingJournalStartsTransaction(false),
+    performingAction(false),
+    maxNumBytesToKeep(maxNumberOfBytesToKeep),
     minimumTransactionsToKeep(minimumTransactions) {}
 
+UndoStack::~UndoStack()
+{
+    this->closeJournal();
+}
+
 void UndoStack::clearUndoHistory()
 {
+    this->flushJournal();
+    this->writeToJournal(ValueTree(Undo::journalClear));
     this->transactions.clear();
-    this->totalUnitsStored = 0;
+    this->coalescingTargets.clear();
+    this->totalBytesStored = 0;
     this->nextIndex = 0;
     this->sendChangeMessage();
 }
@@ -206,23 +636,80 @@ bool UndoStack::perform (UndoAction *const newAction)
             return false;
         }
 
-        if (action->perform())
+        bool performedOk = false;
+
+        {
+            const ScopedValueSetter<bool> setter(this->performingAction, true);
+            performedOk = action->perform();
+        }
+
+        if (performedOk)
         {
+            // the actions pending since the previous transaction go first
+            if (this->newTransaction)
+            {
+                this->flushJournal();
+            }
+
             ActionSet *actionSet = getCurrentSet();
+            const bool startsTransaction = (actionSet == nullptr || this->newTransaction);
+
+            // while coalescing, the action is only journaled when the coalescing ends,
+            // along with all the changes merged into it, see flushJournal()
+            if (this->journal != nullptr && this->coalescingDepth == 0)
+            {
+                ValueTree record(Undo::journalPerform);
+                if (startsTransaction)
+                {
+                    record.setProperty(Undo::startsTransaction, true, nullptr);
+                    record.setProperty(Undo::name, this->newTransactionName, nullptr);
+                }
+
+                // serialized before it gets coalesced with other actions
+                record.appendChild(action->serialize(), nullptr);
+                this->writeToJournal(record);
+            }
             
+            const String coalescingTrackId = (this->coalescingDepth > 0) ?
+                action->getCoalescingTrackId() : String();
+
+            if (actionSet != nullptr && ! newTransaction && coalescingTrackId.isNotEmpty())
+            {
+                // multi-track edits interleave actions for each track,
+                // so the matching one is the last one for the same track
+                if (UndoAction *const lastAction = this->coalescingTargets[coalescingTrackId])
+                {
+                    const int lastActionSize = lastAction->getSizeInUnits();
+                    if (lastAction->coalesceWith(action))
+                    {
+                        this->totalBytesStored += lastAction->getSizeInUnits() - lastActionSize;
+                        this->sendChangeMessage();
+                        return true;
+                    }
+                }
+            }
+
             if (actionSet != nullptr && ! newTransaction)
             {
                 for (signed int i = (actionSet->actions.size() - 1); i >= 0; --i)
                 {
-                    if (UndoAction *const lastAction = actionSet->actions[i])
+                    UndoAction *const lastAction = actionSet->actions[i];
+
+                    // while coalescing, the actions already journaled are left as they are
+                    if (lastAction == nullptr || (this->coalescingDepth > 0 &&
+                        ! this->pendingJournalActions.contains(lastAction)))
                     {
-                        if (UndoAction *const coalescedAction = lastAction->createCoalescedAction(action))
-                        {
-                            action = coalescedAction;
-                            this->totalUnitsStored -= lastAction->getSizeInUnits();
-                            actionSet->actions.remove(i);
-                            break;
-                        }
+                        continue;
+                    }
+
+                    if (UndoAction *const coalescedAction = lastAction->createCoalescedAction(action))
+                    {
+                        action = coalescedAction;
+                        this->totalBytesStored -= lastAction->getSizeInUnits();
+                        this->coalescingTargets.removeValue(lastAction);
+                        this->pendingJournalActions.removeFirstMatchingValue(lastAction);
+                        actionSet->actions.remove(i);
+                        break;
                     }
                 }
             }
@@ -230,10 +717,24 @@ bool UndoStack::perform (UndoAction *const newAction)
             {
                 actionSet = new ActionSet (this->project, newTransactionName);
                 transactions.insert (nextIndex, actionSet);
+                this->coalescingTargets.clear();
                 ++nextIndex;
             }
             
-            this->totalUnitsStored += action->getSizeInUnits();
+            this->totalBytesStored += action->getSizeInUnits();
+
+            if (coalescingTrackId.isNotEmpty())
+            {
+                this->coalescingTargets.set(coalescingTrackId, action.get());
+            }
+
+            if (this->coalescingDepth > 0)
+            {
+                this->pendingJournalActions.add(action.get());
+                this->pendingJournalStartsTransaction =
+                    this->pendingJournalStartsTransaction || startsTransaction;
+            }
+
             actionSet->actions.add(action.release());
             this->newTransaction = false;
             //Logger::writeToLog("size " + String(actionSet->actions.size()));
@@ -251,21 +752,21 @@ void UndoStack::clearFutureTransactions()
 {
     while (this->nextIndex < this->transactions.size())
     {
-        this->totalUnitsStored -= transactions.getLast()->getTotalSize();
+        this->totalBytesStored -= transactions.getLast()->getTotalSize();
         this->transactions.removeLast();
     }
     
     while (this->nextIndex > 0
-           && this->totalUnitsStored > this->maxNumUnitsToKeep
+           && this->totalBytesStored > this->maxNumBytesToKeep
            && this->transactions.size() > this->minimumTransactionsToKeep)
     {
-        this->totalUnitsStored -= this->transactions.getFirst()->getTotalSize();
+        this->totalBytesStored -= this->transactions.getFirst()->getTotalSize();
         this->transactions.remove (0);
         --this->nextIndex;
         
         // if this fails, then some actions may not be returning
         // consistent results from their getSizeInUnits() method
-        jassert (this->totalUnitsStored >= 0);
+        jassert (this->totalBytesStored >= 0);
     }
 }
 
@@ -280,6 +781,23 @@ void UndoStack::beginNewTransaction(const String &actionName) noexcept
     this->newTransactionName = actionName;
 }
 
+void UndoStack::beginCoalescing() noexcept
+{
+    this->coalescingDepth++;
+}
+
+void UndoStack::endCoalescing() noexcept
+{
+    jassert(this->coalescingDepth > 0);
+    this->coalescingDepth = jmax(0, this->coalescingDepth - 1);
+
+    if (this->coalescingDepth == 0)
+    {
+        this->flushJournal();
+        this->coalescingTargets.clear();
+    }
+}
+
 void UndoStack::setCurrentTransactionName(const String &newName) noexcept
 {
     if (this->newTransaction)
@@ -300,8 +818,11 @@ bool UndoStack::canRedo() const noexcept   { return this->getNextSet()    != nul
 
 bool UndoStack::undo()
 {
+    this->flushJournal();
+
     if (const auto s = getCurrentSet())
     {
+        this->writeToJournal(ValueTree(Undo::journalUndo));
         const ScopedValueSetter<bool> setter(this->reentrancyCheck, true);
         
         if (s->undo())
@@ -323,8 +844,25 @@ bool UndoStack::undo()
 
 bool UndoStack::redo()
 {
+    this->flushJournal();
+
     if (const ActionSet* const s = getNextSet())
     {
+        // the redo future is not saved with the project, so the redone
+        // actions are journaled as performed anew, and replayed as such
+        for (int i = 0; this->journal != nullptr && i < s->actions.size(); ++i)
+        {
+            ValueTree record(Undo::journalPerform);
+            if (i == 0)
+            {
+                record.setProperty(Undo::startsTransaction, true, nullptr);
+                record.setProperty(Undo::name, s->name, nullptr);
+            }
+
+            record.appendChild(s->actions.getUnchecked(i)->serialize(), nullptr);
+            this->writeToJournal(record);
+        }
+
         const ScopedValueSetter<bool> setter(this->reentrancyCheck, true);
         
         if (s->perform())
@@ -401,12 +939,18 @@ int UndoStack::getNumActionsInCurrentTransaction() const
 ValueTree UndoStack::serialize() const
 {
     ValueTree tree(Serialization::Undo::undoStack);
+
+    // the journal records up to this one are in the snapshot,
+    // see ProjectTreeItem::onDocumentSnapshot and truncateJournal
+    tree.setProperty(Serialization::Undo::journalRecordId, this->lastJournalRecordId, nullptr);
     
+    const int numTransactionsToStore = UndoStack::getNumTransactionsToStore();
+
     int currentIndex = (this->nextIndex - 1);
     int numStoredTransactions = 0;
     
     while (currentIndex >= 0 &&
-           numStoredTransactions < MAX_TRANSACTIONS_TO_STORE)
+           numStoredTransactions < numTransactionsToStore)
     {
         if (ActionSet *action = this->transactions[currentIndex])
         {
@@ -420,6 +964,20 @@ ValueTree UndoStack::serialize() const
     return tree;
 }
 
+int UndoStack::getNumTransactionsToStore()
+{
+    const auto value = Config::get(Serialization::Config::undoHistoryDepth,
+        String(DEFAULT_TRANSACTIONS_TO_STORE));
+
+    return jlimit(0, MAX_TRANSACTIONS_TO_STORE, value.getIntValue());
+}
+
+void UndoStack::setNumTransactionsToStore(int numTransactions)
+{
+    Config::set(Serialization::Config::undoHistoryDepth,
+        jlimit(0, MAX_TRANSACTIONS_TO_STORE, numTransactions));
+}
+
 void UndoStack::deserialize(const ValueTree &tree)
 {
     const auto root = tree.hasType(Serialization::Undo::undoStack) ?
@@ -429,11 +987,16 @@ void UndoStack::deserialize(const ValueTree &tree)
     { return; }
     
     this->reset();
+
+    this->serializedJournalRecordId = root.getProperty(Serialization::Undo::journalRecordId, 0);
+    this->previousSerializedJournalRecordId = this->serializedJournalRecordId;
+    this->lastJournalRecordId = jmax(this->lastJournalRecordId, this->serializedJournalRecordId);
     
     for (const auto &childTransaction : root)
     {
         auto actionSet = new ActionSet(this->project, {});
         actionSet->deserialize(childTransaction);
+        this->totalBytesStored += actionSet->getTotalSize();
         this->transactions.insert(this->nextIndex, actionSet);
         ++this->nextIndex;
     }
@@ -443,3 +1006,25 @@ void UndoStack::reset()
 {
     this->clearUndoHistory();
 }
+
+//===----------------------------------------------------------------------===//
+// ScopedUndoCoalescing
+//===----------------------------------------------------------------------===//
+
+ScopedUndoCoalescing::ScopedUndoCoalescing(UndoStack *stack) noexcept :
+    undoStack(stack)
+{
+    if (stack != nullptr)
+    {
+        stack->beginCoalescing();
+    }
+}
+
+ScopedUndoCoalescing::~ScopedUndoCoalescing()
+{
+    // the stack might have been deleted while a gesture was in progress
+    if (this->undoStack != nullptr)
+    {
+        this->undoStack->endCoalescing();
+    }
+}
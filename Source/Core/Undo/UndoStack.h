@@ -25,9 +25,15 @@ class UndoStack final : public ChangeBroadcaster, public Serializable
 {
 public:
 
+    // Action sizes, as returned by UndoAction::getSizeInUnits(), are in-memory sizes
+    // in bytes (note actions also count their ids' text, others only their events);
+    // the oldest transactions are dropped when the history exceeds the budget
+    // (the actions are not compacted in memory, only when saved)
     explicit UndoStack(ProjectTreeItem &parentProject,
-        int maxNumberOfUnitsToKeep = 30000,
+        int maxNumberOfBytesToKeep = 8 * 1024 * 1024,
         int minimumTransactionsToKeep = 30);
+
+    ~UndoStack() override;
     
     void clearUndoHistory();
 
@@ -37,6 +43,13 @@ public:
     void beginNewTransaction() noexcept;
     void beginNewTransaction(const String &actionName) noexcept;
     void setCurrentTransactionName(const String &newName) noexcept;
+
+    // While coalescing, each action is merged in place into the last action
+    // for the same track in the current transaction, if possible (see UndoAction::coalesceWith),
+    // so that continuous edits like dragging produce a single small undo record;
+    // the calls can be nested, prefer ScopedUndoCoalescing to calling them directly
+    void beginCoalescing() noexcept;
+    void endCoalescing() noexcept;
     
     bool canUndo() const noexcept;
     String getUndoDescription() const;
@@ -51,9 +64,57 @@ public:
     ValueTree serialize() const override;
     void deserialize(const ValueTree &tree) override;
     void reset() override;
+
+    // How many of the latest transactions are saved with a project,
+    // a user setting, see UndoHistorySettings
+    static int getNumTransactionsToStore();
+    static void setNumTransactionsToStore(int numTransactions);
+
+    //===------------------------------------------------------------------===//
+    // Journal
+    //===------------------------------------------------------------------===//
+
+    // The journal is an append-only file next to the project, which records
+    // the actions performed since the last full save; it is written and
+    // flushed to disk in batches on a background thread, and, when opened,
+    // the actions missing in the loaded project are replayed (e.g. after a crash)
+    static File getJournalFileFor(const File &projectFile);
+    void openJournal(const File &journalFile);
+    void closeJournal();
+
+    // The record id to be stored in a project snapshot, when it's serialized;
+    // journals the actions which are still being coalesced, as they are in the snapshot
+    int64 getLastJournalRecordId();
+
+    // Called when a project snapshot with the given record id has been saved
+    // successfully, to forget the records which are in the file's previous save
+    void truncateJournal(int64 savedJournalRecordId);
+
+    // Called by the project on every change: the changes, which are not made
+    // by this stack's actions, can't be replayed, so the journal records
+    // after them are skipped, until a snapshot with those changes is saved
+    void checkpointJournalIfNeeded();
     
 private:
 
+    class JournalThread;
+    ScopedPointer<JournalThread> journal;
+
+    int64 lastJournalRecordId;
+    int64 serializedJournalRecordId;
+    int64 previousSerializedJournalRecordId;
+    bool lastJournalRecordIsCheckpoint;
+
+    void writeToJournal(ValueTree record);
+    void replayJournalRecord(const ValueTree &record);
+
+    // While coalescing, the actions performed in the current transaction
+    // are journaled only once, in their final form, when the coalescing ends
+    // or before anything else is journaled
+    Array<const UndoAction *> pendingJournalActions;
+    bool pendingJournalStartsTransaction;
+    void flushJournal();
+
     void getActionsInCurrentTransaction(Array<const UndoAction *> &actionsFound) const;
     int getNumActionsInCurrentTransaction() const;
 
@@ -82,13 +143,34 @@ private:
     OwnedArray<ActionSet> transactions;
     String newTransactionName;
     
-    int totalUnitsStored, maxNumUnitsToKeep, minimumTransactionsToKeep, nextIndex;
-    bool newTransaction, reentrancyCheck;
+    int totalBytesStored, maxNumBytesToKeep, minimumTransactionsToKeep, nextIndex;
+    int coalescingDepth;
+    bool newTransaction, reentrancyCheck, performingAction;
+
+    // While coalescing, the last action of the current transaction for each track
+    HashMap<String, UndoAction *> coalescingTargets;
     
     ActionSet *getCurrentSet() const noexcept;
     ActionSet *getNextSet() const noexcept;
     
     void clearFutureTransactions();
     
+    JUCE_DECLARE_WEAK_REFERENCEABLE(UndoStack)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UndoStack)
 };
+
+// Keeps the undo stack coalescing for as long as it exists, e.g. for the duration
+// of a mouse drag, so that the mode is not left on when a gesture is interrupted
+class ScopedUndoCoalescing final
+{
+public:
+
+    explicit ScopedUndoCoalescing(UndoStack *stack) noexcept;
+    ~ScopedUndoCoalescing();
+
+private:
+
+    WeakReference<UndoStack> undoStack;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedUndoCoalescing)
+};
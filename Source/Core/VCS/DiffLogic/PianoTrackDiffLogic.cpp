@@ -45,6 +45,11 @@ static Array<DeltaDiff> createEventsDiffs(const ValueTree &state, const ValueTre
 static void deserializeLayerChanges(const ValueTree &state, const ValueTree &changes,
     OwnedArray<Note> &stateNotes, OwnedArray<Note> &changesNotes);
 
+static Array<const Note *> sortedById(const OwnedArray<Note> &notes);
+static bool notesHaveSameParameters(const Note *first, const Note *second);
+static void forEachNotesPairById(const Array<const Note *> &first, const Array<const Note *> &second,
+    Function<void(const Note *first, const Note *second)> callback);
+
 static DeltaDiff serializeLayerChanges(Array<const MidiEvent *> changes,
     const String &description, int64 numChanges,  const Identifier &deltaType);
 
@@ -344,28 +349,14 @@ ValueTree mergeNotesAdded(const ValueTree &state, const ValueTree &changes)
     deserializeLayerChanges(state, changes, stateNotes, changesNotes);
 
     Array<const MidiEvent *> result;
-
-    result.addArray(stateNotes);
+    result.ensureStorageAllocated(stateNotes.size() + changesNotes.size());
 
     // на всякий пожарный, ищем, нет ли в состоянии нот с теми же id, где нет - добавляем
-    HashMap<MidiEvent::Id, int> stateIDs;
-    
-    for (int j = 0; j < stateNotes.size(); ++j)
-    {
-        const Note *stateNote(stateNotes.getUnchecked(j));
-        stateIDs.set(stateNote->getId(), j);
-    }
-
-    for (int i = 0; i < changesNotes.size(); ++i)
+    forEachNotesPairById(sortedById(stateNotes), sortedById(changesNotes),
+        [&result](const Note *stateNote, const Note *changesNote)
     {
-        const Note *changesNote(changesNotes.getUnchecked(i));
-        bool foundNoteInState = stateIDs.contains(changesNote->getId());
-
-        if (! foundNoteInState)
-        {
-            result.add(changesNote);
-        }
-    }
+        result.add(stateNote != nullptr ? stateNote : changesNote);
+    });
 
     return serializeLayer(result, PianoSequenceDeltas::notesAdded);
 }
@@ -377,25 +368,17 @@ ValueTree mergeNotesRemoved(const ValueTree &state, const ValueTree &changes)
     deserializeLayerChanges(state, changes, stateNotes, changesNotes);
 
     Array<const MidiEvent *> result;
+    result.ensureStorageAllocated(stateNotes.size());
 
     // добавляем все ноты из состояния, которых нет в изменениях
-    HashMap<MidiEvent::Id, int> changesIDs;
-
-    for (int j = 0; j < changesNotes.size(); ++j)
-    {
-        const Note *changesNote(changesNotes.getUnchecked(j));
-        changesIDs.set(changesNote->getId(), j);
-    }
-    
-    for (int i = 0; i < stateNotes.size(); ++i)
+    forEachNotesPairById(sortedById(stateNotes), sortedById(changesNotes),
+        [&result](const Note *stateNote, const Note *changesNote)
     {
-        const Note *stateNote(stateNotes.getUnchecked(i));
-        const bool foundNoteInChanges = changesIDs.contains(stateNote->getId());
-        if (! foundNoteInChanges)
+        if (stateNote != nullptr && changesNote == nullptr)
         {
             result.add(stateNote);
         }
-    }
+    });
 
     return serializeLayer(result, PianoSequenceDeltas::notesAdded);
 }
@@ -407,26 +390,73 @@ ValueTree mergeNotesChanged(const ValueTree &state, const ValueTree &changes)
     deserializeLayerChanges(state, changes, stateNotes, changesNotes);
 
     Array<const MidiEvent *> result;
-
-    result.addArray(stateNotes);
+    result.ensureStorageAllocated(stateNotes.size());
 
     // снова ищем по id и заменяем
-    HashMap<MidiEvent::Id, const Note *> changesIDs;
-    
-    for (int j = 0; j < changesNotes.size(); ++j)
+    forEachNotesPairById(sortedById(stateNotes), sortedById(changesNotes),
+        [&result](const Note *stateNote, const Note *changesNote)
     {
-        const Note *changesNote(changesNotes.getUnchecked(j));
-        changesIDs.set(changesNote->getId(), changesNote);
-    }
+        if (stateNote != nullptr)
+        {
+            result.add(changesNote != nullptr ? changesNote : stateNote);
+        }
+    });
+
+    return serializeLayer(result, PianoSequenceDeltas::notesAdded);
+}
+
+ValueTree PianoTrackDiffLogic::mergeNotes(const ValueTree &base,
+    const ValueTree &local, const ValueTree &remote, StringArray &conflicts)
+{
+    OwnedArray<Note> baseNotes;
+    OwnedArray<Note> localNotes;
+    OwnedArray<Note> remoteNotes;
+    OwnedArray<Note> unused;
+    deserializeLayerChanges(base, local, baseNotes, localNotes);
+    deserializeLayerChanges(remote, {}, remoteNotes, unused);
 
-    for (int i = 0; i < stateNotes.size(); ++i)
+    const auto b = sortedById(baseNotes);
+    const auto l = sortedById(localNotes);
+    const auto r = sortedById(remoteNotes);
+
+    Array<const MidiEvent *> result;
+    result.ensureStorageAllocated(jmax(l.size(), r.size()));
+
+    int ib = 0, il = 0, ir = 0;
+    while (ib < b.size() || il < l.size() || ir < r.size())
     {
-        const Note *stateNote(stateNotes.getUnchecked(i));
-        if (changesIDs.contains(stateNote->getId()))
+        // pick the smallest id among the three heads,
+        // and take the notes with that id from each side
+        const MidiEvent::Id *minId = nullptr;
+        if (ib < b.size()) { minId = &b.getUnchecked(ib)->getId(); }
+        if (il < l.size() && (minId == nullptr || l.getUnchecked(il)->getId().compare(*minId) < 0))
+        { minId = &l.getUnchecked(il)->getId(); }
+        if (ir < r.size() && (minId == nullptr || r.getUnchecked(ir)->getId().compare(*minId) < 0))
+        { minId = &r.getUnchecked(ir)->getId(); }
+
+        const MidiEvent::Id id(*minId);
+        const Note *baseNote = (ib < b.size() && b.getUnchecked(ib)->getId() == id) ? b.getUnchecked(ib++) : nullptr;
+        const Note *localNote = (il < l.size() && l.getUnchecked(il)->getId() == id) ? l.getUnchecked(il++) : nullptr;
+        const Note *remoteNote = (ir < r.size() && r.getUnchecked(ir)->getId() == id) ? r.getUnchecked(ir++) : nullptr;
+
+        const bool localChanged = !notesHaveSameParameters(baseNote, localNote);
+        const bool remoteChanged = !notesHaveSameParameters(baseNote, remoteNote);
+
+        // whichever side has changed (or added, or removed) the note wins;
+        // if both sides have changed it differently, that's a conflict,
+        // which is resolved in favour of the local version
+        const Note *mergedNote = remoteChanged ? remoteNote : localNote;
+
+        if (localChanged && remoteChanged &&
+            !notesHaveSameParameters(localNote, remoteNote))
+        {
+            conflicts.add(id);
+            mergedNote = localNote;
+        }
+
+        if (mergedNote != nullptr)
         {
-            const Note *changesNote = changesIDs[stateNote->getId()];
-            result.removeAllInstancesOf(stateNote);
-            result.addIfNotAlreadyThere(changesNote);
+            result.add(mergedNote);
         }
     }
 
@@ -495,65 +525,25 @@ Array<DeltaDiff> createEventsDiffs(const ValueTree &state, const ValueTree &chan
     Array<const MidiEvent *> changedNotes;
 
     // собственно, само сравнение
-    for (int i = 0; i < stateNotes.size(); ++i)
+    forEachNotesPairById(sortedById(stateNotes), sortedById(changesNotes),
+        [&](const Note *stateNote, const Note *changesNote)
     {
-        bool foundNoteInChanges = false;
-        const Note *stateNote(stateNotes.getUnchecked(i));
-
-        for (int j = 0; j < changesNotes.size(); ++j)
-        {
-            const Note *changesNote(changesNotes.getUnchecked(j));
-
-            // нота из состояния - существует в изменениях. добавляем запись changed, если нужно.
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInChanges = true;
-
-                const bool noteHasChanged =
-                    (stateNote->getKey() != changesNote->getKey() ||
-                    stateNote->getBeat() != changesNote->getBeat() ||
-                    stateNote->getLength() != changesNote->getLength() ||
-                    stateNote->getVelocity() != changesNote->getVelocity());
-
-                if (noteHasChanged)
-                {
-                    changedNotes.add(changesNote);
-                }
-
-                break;
-            }
-        }
-
-        // нота из состояния - в изменениях не найдена. добавляем запись removed.
-        if (! foundNoteInChanges)
+        if (changesNote == nullptr)
         {
+            // нота из состояния - в изменениях не найдена. добавляем запись removed.
             removedNotes.add(stateNote);
         }
-    }
-
-    // теперь ищем в изменениях ноты, которые отсутствуют в состоянии
-    for (int i = 0; i < changesNotes.size(); ++i)
-    {
-        bool foundNoteInState = false;
-        const Note *changesNote(changesNotes.getUnchecked(i));
-
-        for (int j = 0; j < stateNotes.size(); ++j)
+        else if (stateNote == nullptr)
         {
-            const Note *stateNote(stateNotes.getUnchecked(j));
-
-            if (stateNote->getId() == changesNote->getId())
-            {
-                foundNoteInState = true;
-                break;
-            }
+            // нота из изменений отсутствует в состоянии, пишем ее в список добавленных
+            addedNotes.add(changesNote);
         }
-
-        // и пишем ее в список добавленных
-        if (! foundNoteInState)
+        else if (!notesHaveSameParameters(stateNote, changesNote))
         {
-            addedNotes.add(changesNote);
+            // нота из состояния - существует в изменениях. добавляем запись changed, если нужно.
+            changedNotes.add(changesNote);
         }
-    }
+    });
 
     // сериализуем диффы, если таковые есть
 
@@ -594,7 +584,7 @@ void deserializeLayerChanges(const ValueTree &state, const ValueTree &changes,
         {
             auto note = new Note();
             note->deserialize(e);
-            stateNotes.addSorted(*note, note);
+            stateNotes.add(note); // ordered by id later, if needed
         }
     }
 
@@ -604,7 +594,7 @@ void deserializeLayerChanges(const ValueTree &state, const ValueTree &changes,
         {
             auto note = new Note();
             note->deserialize(e);
-            changesNotes.addSorted(*note, note);
+            changesNotes.add(note);
         }
     }
 }
@@ -631,6 +621,76 @@ ValueTree serializeLayer(Array<const MidiEvent *> changes, const Identifier &tag
     return tree;
 }
 
+struct NoteIdComparator final
+{
+    static int compareElements(const Note *first, const Note *second) noexcept
+    {
+        return first->getId().compare(second->getId());
+    }
+};
+
+Array<const Note *> sortedById(const OwnedArray<Note> &notes)
+{
+    Array<const Note *> result;
+    result.addArray(notes);
+
+    // the layers written by the merge helpers are already ordered by id,
+    // so that merging a chain of deltas takes a single pass per delta,
+    // and only the layers serialized from a track need sorting
+    for (int i = 1; i < result.size(); ++i)
+    {
+        if (result.getUnchecked(i - 1)->getId().compare(result.getUnchecked(i)->getId()) > 0)
+        {
+            NoteIdComparator comparator;
+            result.sort(comparator);
+            break;
+        }
+    }
+
+    return result;
+}
+
+bool notesHaveSameParameters(const Note *first, const Note *second)
+{
+    if (first == nullptr || second == nullptr)
+    {
+        return first == second;
+    }
+
+    return first->getKey() == second->getKey() &&
+        first->getBeat() == second->getBeat() &&
+        first->getLength() == second->getLength() &&
+        first->getVelocity() == second->getVelocity();
+}
+
+// walks through both arrays sorted by id at once, calling back
+// with notes of the same id, or with nullptr for the missing one
+void forEachNotesPairById(const Array<const Note *> &first, const Array<const Note *> &second,
+    Function<void(const Note *first, const Note *second)> callback)
+{
+    int i = 0, j = 0;
+    while (i < first.size() || j < second.size())
+    {
+        const int order =
+            (j >= second.size()) ? -1 :
+            (i >= first.size()) ? 1 :
+            first.getUnchecked(i)->getId().compare(second.getUnchecked(j)->getId());
+
+        if (order < 0)
+        {
+            callback(first.getUnchecked(i++), nullptr);
+        }
+        else if (order > 0)
+        {
+            callback(nullptr, second.getUnchecked(j++));
+        }
+        else
+        {
+            callback(first.getUnchecked(i++), second.getUnchecked(j++));
+        }
+    }
+}
+
 bool checkIfDeltaIsNotesType(const Delta *d)
 {
     return (d->hasType(PianoSequenceDeltas::notesAdded) ||
@@ -41,5 +41,13 @@ namespace VCS
         void resetStateTo(const TrackedItem &newState) override;
         Diff *createDiff(const TrackedItem &initialState) const override;
         Diff *createMergedItem(const TrackedItem &initialState) const override;
+
+        // Three-way merge of two notes layers (serialized as notesAdded deltas)
+        // against their common ancestor, linear over the notes sorted by id;
+        // fills in the ids of notes changed differently on both sides,
+        // which are resolved in favour of the local version
+        static ValueTree mergeNotes(const ValueTree &base,
+            const ValueTree &local, const ValueTree &remote,
+            StringArray &conflicts);
     };
 } // namespace VCS
@@ -25,10 +25,13 @@
 
 #include "Diff.h"
 #include "DiffLogic.h"
+#include "PianoTrackDiffLogic.h"
+#include "SerializationKeys.h"
 
 using namespace VCS;
 
 #define DIFF_BUILD_THREAD_STOP_TIMEOUT 5000
+#define DIFF_BUILD_JOBS_POLL_TIMEOUT 50
 
 Head::Head(const Head &other) :
     Thread("Diff Thread"),
@@ -162,71 +165,99 @@ void Head::mergeStateWith(ValueTree changes)
 
 bool VCS::Head::moveTo(const ValueTree revision)
 {
+    HeadState *newState = (this->targetVcsItemsSource != nullptr) ?
+        Head::createStateFor(Head::createRevisionsPath(revision)) : nullptr;
+
+    this->moveTo(revision, newState);
+    return true;
+}
+
+void VCS::Head::moveTo(const ValueTree revision, HeadState *prebuiltState)
+{
+    ScopedPointer<HeadState> newState(prebuiltState);
+
     if (this->isThreadRunning())
     {
         this->stopThread(DIFF_BUILD_THREAD_STOP_TIMEOUT);
     }
 
-    if (this->targetVcsItemsSource != nullptr)
+    if (newState != nullptr)
     {
-        // здесь надо будет пройтись до корня и запомнить все ревизии
-        Array<ValueTree> treePath;
-        ValueTree currentRevision(revision);
+        const ScopedWriteLock lock(this->stateLock);
+        this->state = newState.release();
+    }
 
-        // сначала обнуляем состояние
-        {
-            const ScopedWriteLock lock(this->stateLock);
-            this->state = new HeadState();
-        }
+    this->headingAt = revision;
+    this->setDiffOutdated(true);
+}
+
+Array<ValueTree> VCS::Head::createRevisionsPath(const ValueTree revision)
+{
+    // здесь надо будет пройтись до корня и запомнить все ревизии;
+    // only the properties are copied, the revision items are shared,
+    // so that the history tree itself is never walked off the message thread
+    Array<ValueTree> treePath;
+    ValueTree currentRevision(revision);
+
+    Logger::writeToLog("Head::createRevisionsPath " + Revision::getUuid(currentRevision));
+
+    while (currentRevision.isValid())
+    {
+        ValueTree revisionCopy(currentRevision.getType());
+        revisionCopy.copyPropertiesFrom(currentRevision, nullptr);
+        treePath.insert(0, revisionCopy);
+        currentRevision = currentRevision.getParent();
+    }
 
-        Logger::writeToLog("Head::moveTo " + Revision::getUuid(currentRevision));
+    return treePath;
+}
 
-        while (currentRevision.isValid())
+HeadState *VCS::Head::createStateFor(const Array<ValueTree> &treePath, Thread *ownerThread)
+{
+    ScopedPointer<HeadState> newState(new HeadState());
+
+    // затем, идти по ним в обратном порядке - от корня
+    for (auto && i : treePath)
+    {
+        if (ownerThread != nullptr && ownerThread->threadShouldExit())
         {
-            treePath.insert(0, currentRevision);
-            currentRevision = currentRevision.getParent();
+            return nullptr;
         }
 
-        // затем, идти по ним в обратном порядке - от корня
-        for (auto && i : treePath)
-        {
-            const ValueTree rev(i);
+        const ValueTree rev(i);
 
-            Logger::writeToLog("Head::moveTo -> " + Revision::getUuid(rev));
+        Logger::writeToLog("Head::createStateFor -> " + Revision::getUuid(rev));
 
-            // собираем все дельты и применяем их к текущему состоянию
-            for (int j = 0; j < rev.getNumProperties(); ++j)
-            {
-                Identifier id = rev.getPropertyName(j);
-                const var &property = rev.getProperty(id);
+        // собираем все дельты и применяем их к текущему состоянию
+        for (int j = 0; j < rev.getNumProperties(); ++j)
+        {
+            Identifier id = rev.getPropertyName(j);
+            const var &property = rev.getProperty(id);
 
-                if (RevisionItem *item = dynamic_cast<RevisionItem *>(property.getObject()))
+            if (RevisionItem *item = dynamic_cast<RevisionItem *>(property.getObject()))
+            {
+                if (item->getType() == RevisionItem::Added)
                 {
-                    if (item->getType() == RevisionItem::Added)
-                    {
-                        // ::Ptr сам создастся конструктором из указателя и увеличит его счетчик ссылок
-                        this->state->addItem(item);
-                    }
-                    else if (item->getType() == RevisionItem::Removed)
-                    {
-                        this->state->removeItem(item);
-                    }
-                    else if (item->getType() == RevisionItem::Changed)
-                    {
-                        this->state->mergeItem(item);
-                    }
-                    else
-                    {
-                        jassertfalse;
-                    }
+                    // ::Ptr сам создастся конструктором из указателя и увеличит его счетчик ссылок
+                    newState->addItem(item);
+                }
+                else if (item->getType() == RevisionItem::Removed)
+                {
+                    newState->removeItem(item);
+                }
+                else if (item->getType() == RevisionItem::Changed)
+                {
+                    newState->mergeItem(item);
+                }
+                else
+                {
+                    jassertfalse;
                 }
             }
         }
     }
 
-    this->headingAt = revision;
-    this->setDiffOutdated(true);
-    return true;
+    return newState.release();
 }
 
 void Head::pointTo(const ValueTree revision)
@@ -329,26 +360,10 @@ void Head::checkout()
     if (this->state == nullptr)
     { return; }
 
-    // clear all tracked items
-    {
-        Array<TrackedItem *> itemsToClear;
-
-        for (int i = 0; i < this->targetVcsItemsSource->getNumTrackedItems(); ++i)
-        {
-            TrackedItem *ti = this->targetVcsItemsSource->getTrackedItem(i);
-
-            if (this->state->getItemWithUuid(ti->getUuid()) != nullptr)
-            {
-                itemsToClear.add(ti);
-            }
-        }
-
-        for (auto i : itemsToClear)
-        {
-            this->targetVcsItemsSource->deleteTrackedItem(i);
-        }
-    }
-
+    // the items which exist in the project are reset in place, without
+    // being deleted and re-created with their own add/remove notifications;
+    // only the items added or removed in the state are created or deleted,
+    // and then the project reloads its content once, in onResetState
     for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
     {
         RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
@@ -401,6 +416,161 @@ void Head::cherryPickAll()
     this->targetVcsItemsSource->onResetState();
 }
 
+//===----------------------------------------------------------------------===//
+// Three-way merge
+//===----------------------------------------------------------------------===//
+
+static TrackedItem *findTrackedItem(TrackedItemsSource &source, const Uuid &id)
+{
+    for (int i = 0; i < source.getNumTrackedItems(); ++i)
+    {
+        TrackedItem *item = source.getTrackedItem(i);
+        if (item->getUuid() == id)
+        {
+            return item;
+        }
+    }
+
+    return nullptr;
+}
+
+static ValueTree findDeltaData(const TrackedItem &item, const Identifier &deltaType)
+{
+    for (int i = 0; i < item.getNumDeltas(); ++i)
+    {
+        if (item.getDelta(i)->hasType(deltaType))
+        {
+            return item.serializeDeltaData(i);
+        }
+    }
+
+    return {};
+}
+
+static bool hasChangesSince(const TrackedItem &item, const TrackedItem &initialState)
+{
+    ScopedPointer<Diff> diff(item.getDiffLogic()->createDiff(initialState));
+    return diff->hasAnyChanges();
+}
+
+// For every delta, the side which has changed it since the common state wins,
+// and the notes are merged note by note; if both sides have changed
+// something differently, that's a conflict, resolved in favour of the project
+static RevisionItem::Ptr createMergedItem(Pack::Ptr pack, const TrackedItem &common,
+    const TrackedItem &local, RevisionItem &remote, bool &outHasConflicts)
+{
+    RevisionItem::Ptr merged(new RevisionItem(pack, remote.getType(), &remote));
+
+    for (int i = 0; i < merged->getNumDeltas(); ++i)
+    {
+        const Delta *delta = merged->getDelta(i);
+        const auto commonData(findDeltaData(common, delta->getType()));
+        const auto localData(findDeltaData(local, delta->getType()));
+
+        if (!commonData.isValid() || !localData.isValid())
+        { continue; } // the kind of delta missing on one of the sides
+
+        const auto remoteData(merged->serializeDeltaData(i));
+
+        if (delta->hasType(Serialization::VCS::PianoSequenceDeltas::notesAdded))
+        {
+            StringArray conflictingNotes;
+            const auto mergedData(PianoTrackDiffLogic::mergeNotes(commonData,
+                localData, remoteData, conflictingNotes));
+
+            merged->importDataForDelta(mergedData, delta->getUuid().toString());
+            outHasConflicts = outHasConflicts || !conflictingNotes.isEmpty();
+        }
+        else if (remoteData.isEquivalentTo(commonData))
+        {
+            merged->importDataForDelta(localData, delta->getUuid().toString());
+        }
+        else if (!localData.isEquivalentTo(commonData) && !localData.isEquivalentTo(remoteData))
+        {
+            merged->importDataForDelta(localData, delta->getUuid().toString());
+            outHasConflicts = true;
+        }
+    }
+
+    return merged;
+}
+
+void Head::mergeAll(const Head &common, StringArray &outConflicts)
+{
+    if (this->targetVcsItemsSource == nullptr)
+    { return; }
+
+    if (this->state == nullptr || common.state == nullptr)
+    { return; }
+
+    const ScopedReadLock lock(this->stateLock);
+
+    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+    {
+        RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
+        const RevisionItem::Ptr commonItem = common.state->getItemWithUuid(stateItem->getUuid());
+        TrackedItem *targetItem = findTrackedItem(*this->targetVcsItemsSource, stateItem->getUuid());
+
+        if (commonItem == nullptr)
+        {
+            // added since the common state
+            this->checkoutItem(stateItem);
+        }
+        else if (! hasChangesSince(*stateItem, *commonItem))
+        {
+            // only the project might have changed it, nothing to merge
+            continue;
+        }
+        else if (targetItem == nullptr)
+        {
+            // changed here, but removed in the project
+            outConflicts.add(stateItem->getVCSName());
+        }
+        else
+        {
+            bool hasConflicts = false;
+            const auto mergedItem(createMergedItem(this->pack,
+                *commonItem, *targetItem, *stateItem, hasConflicts));
+
+            targetItem->getDiffLogic()->resetStateTo(*mergedItem);
+
+            if (hasConflicts)
+            {
+                outConflicts.add(stateItem->getVCSName());
+            }
+        }
+    }
+
+    // the items removed since the common state are removed from the project,
+    // unless the project has changed them
+    Array<TrackedItem *> removedItems;
+    for (int i = 0; i < common.state->getNumTrackedItems(); ++i)
+    {
+        const RevisionItem::Ptr commonItem = static_cast<RevisionItem *>(common.state->getTrackedItem(i));
+        if (this->state->getItemWithUuid(commonItem->getUuid()) != nullptr)
+        { continue; }
+
+        if (TrackedItem *targetItem = findTrackedItem(*this->targetVcsItemsSource, commonItem->getUuid()))
+        {
+            if (hasChangesSince(*targetItem, *commonItem))
+            {
+                outConflicts.add(targetItem->getVCSName());
+            }
+            else
+            {
+                removedItems.add(targetItem);
+            }
+        }
+    }
+
+    for (auto item : removedItems)
+    {
+        this->targetVcsItemsSource->deleteTrackedItem(item);
+    }
+
+    this->targetVcsItemsSource->onResetState();
+}
+
 bool VCS::Head::resetChanges(const Array<RevisionItem::Ptr> &changes)
 {
     if (this->targetVcsItemsSource == nullptr)
@@ -529,7 +699,9 @@ ValueTree VCS::Head::serialize() const
                 ValueTree packItem(Serialization::VCS::packItem);
                 packItem.setProperty(Serialization::VCS::packItemRevId, stateItem->getUuid().toString(), nullptr);
                 packItem.setProperty(Serialization::VCS::packItemDeltaId, stateItem->getDelta(j)->getUuid().toString(), nullptr);
-                packItem.appendChild(deltaData, nullptr);
+                // merged state items hold their data in memory, don't share it
+                // with the serialized tree, which might be written on another thread
+                packItem.appendChild(deltaData.createCopy(), nullptr);
                 
                 stateDataNode.appendChild(packItem, nullptr);
             }
@@ -555,6 +727,15 @@ void VCS::Head::deserialize(const ValueTree &tree)
     const auto dataRoot = headRoot.getChildWithName(Serialization::VCS::headIndexData);
     if (!dataRoot.isValid()) { return; }
     
+    // group deltas data by items first, so that
+    // importing them doesn't take quadratic time
+    SparseHashMap<String, Array<ValueTree>, StringHash> itemsData;
+    forEachValueTreeChildWithType(dataRoot, dataElement, Serialization::VCS::packItem)
+    {
+        const String packItemRevId = dataElement.getProperty(Serialization::VCS::packItemRevId);
+        itemsData[packItemRevId].add(dataElement);
+    }
+
     forEachValueTreeChildWithType(indexRoot, stateElement, Serialization::VCS::revisionItem)
     {
         RevisionItem::Ptr stateItem(new RevisionItem(this->pack, RevisionItem::Added, nullptr));
@@ -563,16 +744,14 @@ void VCS::Head::deserialize(const ValueTree &tree)
         //Logger::writeToLog("- " + stateItem->getVCSName());
         
         // import deltas data
-        forEachValueTreeChildWithType(dataRoot, dataElement, Serialization::VCS::packItem)
+        const auto itemData = itemsData.find(stateItem->getUuid().toString());
+        if (itemData != itemsData.end())
         {
-            const String packItemRevId = dataElement.getProperty(Serialization::VCS::packItemRevId);
-            const String packItemDeltaId = dataElement.getProperty(Serialization::VCS::packItemDeltaId);
-            const auto deltaData = dataElement.getChild(0);
-            
-            if (packItemRevId == stateItem->getUuid().toString())
+            for (const auto &dataElement : itemData->second)
             {
+                const String packItemDeltaId = dataElement.getProperty(Serialization::VCS::packItemDeltaId);
+                const auto deltaData = dataElement.getChild(0);
                 stateItem->importDataForDelta(deltaData, packItemDeltaId);
-                //Logger::writeToLog("+ " + String(packItemDeltaId->getNumChildElements()));
             }
         }
         
@@ -601,7 +780,71 @@ void Head::changeListenerCallback(ChangeBroadcaster *source)
 // Thread
 //===----------------------------------------------------------------------===//
 
+// Diff jobs are independent from each other, so they are run
+// in a thread pool, each job only computing its own diff record;
+// the diff tree itself is only modified by the head's thread
+class DiffJob final : public ThreadPoolJob
+{
+public:
+
+    DiffJob(Pack::Ptr pack, TrackedItem *targetItem,
+        RevisionItem::Ptr stateItem, WaitableEvent &onDone) :
+        ThreadPoolJob("Diff Job"),
+        pack(pack),
+        targetItem(targetItem),
+        stateItem(stateItem),
+        onDone(onDone) {}
+
+    JobStatus runJob() override
+    {
+        if (! this->shouldExit())
+        {
+            ScopedPointer<Diff> itemDiff(this->targetItem->getDiffLogic()->createDiff(*this->stateItem));
+
+            if (itemDiff->hasAnyChanges())
+            {
+                this->result = new RevisionItem(this->pack, RevisionItem::Changed, itemDiff);
+            }
+        }
+
+        this->done.set(1);
+        this->onDone.signal();
+        return jobHasFinished;
+    }
+
+    bool isDone() const noexcept
+    {
+        return this->done.get() != 0;
+    }
+
+    Pack::Ptr pack;
+    TrackedItem *targetItem;
+    RevisionItem::Ptr stateItem;
+    RevisionItem::Ptr result;
+    bool isMerged = false;
+
+private:
+
+    WaitableEvent &onDone;
+    Atomic<int> done;
+
+    JUCE_DECLARE_NON_COPYABLE(DiffJob)
+};
+
 void Head::run()
+{
+    this->rebuildDiff(this);
+}
+
+void Head::rebuildDiffSynchronously()
+{
+    if (this->isRebuildingDiff())
+    { return; }
+
+    this->rebuildDiff(nullptr);
+}
+
+void Head::rebuildDiff(Thread *ownerThread)
 {
     if (this->targetVcsItemsSource == nullptr)
     { return; }
@@ -620,204 +863,123 @@ void Head::run()
 
     const ScopedReadLock threadStateLock(this->stateLock);
 
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
+    // the declaration order matters here: the pool should
+    // be destroyed before the jobs and the event they refer to
+    WaitableEvent jobDoneEvent;
+    OwnedArray<DiffJob> jobs;
+    ThreadPool pool(jmax(1, SystemStats::getNumCpus() - 1));
+
+    SparseHashMap<String, TrackedItem *, StringHash> targetItems;
+    for (int i = 0; i < this->targetVcsItemsSource->getNumTrackedItems(); ++i)
     {
-        if (this->threadShouldExit())
-        {
-            this->setRebuildingDiffMode(false);
-            this->sendChangeMessage();
-            return;
-        }
+        TrackedItem *targetItem = this->targetVcsItemsSource->getTrackedItem(i);
+        targetItems[targetItem->getUuid().toString()] = targetItem;
+    }
 
-        bool foundItemInTarget = false;
-        const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
+    SparseHashSet<String, StringHash> stateItems;
+    Array<RevisionItem::Ptr> removedAndAddedRecords;
 
-        // записи удаления рассматриваем позже
-        if (stateItem->getType() == RevisionItem::Removed) { continue; }
+    // the jobs get detached copies of the state items, with all their deltas data
+    // read beforehand under one lock, so that they don't contend for the pack
+    {
+        const ScopedLock packLock(this->pack->getLock());
 
-        for (int j = 0; j < this->targetVcsItemsSource->getNumTrackedItems(); ++j)
+        for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
         {
-            if (this->threadShouldExit())
-            {
-                this->setRebuildingDiffMode(false);
-                this->sendChangeMessage();
-                return;
-            }
-
-            TrackedItem *targetItem = this->targetVcsItemsSource->getTrackedItem(j); // i.e. LayerTreeItem
-
-            // айтем из состояния - существует в проекте. добавляем запись changed, если нужно.
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInTarget = true;
-
-                ScopedPointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
+            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
 
-                if (itemDiff->hasAnyChanges())
-                {
-                    RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Changed, itemDiff));
-                    var revisionVar(revisionRecord);
+            // записи удаления рассматриваем позже
+            if (stateItem->getType() == RevisionItem::Removed) { continue; }
 
-                    const ScopedWriteLock itemDiffLock(this->diffLock);
-                    this->diff.setProperty(stateItem->getUuid().toString(), revisionVar, nullptr);
-                }
+            const String stateItemId(stateItem->getUuid().toString());
+            stateItems.insert(stateItemId);
 
-                break;
+            const auto foundTarget = targetItems.find(stateItemId);
+            if (foundTarget != targetItems.end())
+            {
+                // айтем из состояния - существует в проекте. добавляем запись changed, если нужно.
+                RevisionItem::Ptr stateItemCopy(new RevisionItem(this->pack, stateItem->getType(), stateItem));
+                jobs.add(new DiffJob(this->pack, foundTarget->second, stateItemCopy, jobDoneEvent));
+            }
+            else
+            {
+                // айтем из состояния - в проекте не найден. добавляем запись removed.
+                ScopedPointer<Diff> emptyDiff(new Diff(*stateItem));
+                removedAndAddedRecords.add(new RevisionItem(this->pack, RevisionItem::Removed, emptyDiff));
             }
         }
+    }
 
-        // айтем из состояния - в проекте не найден. добавляем запись removed.
-        if (! foundItemInTarget)
-        {
-            ScopedPointer<Diff> emptyDiff(new Diff(*stateItem));
-
-            RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Removed, emptyDiff));
-            var revisionVar(revisionRecord);
-
-            const ScopedWriteLock emptyDiffLock(this->diffLock);
-            this->diff.setProperty(stateItem->getUuid().toString(), revisionVar, nullptr);
-        }
+    for (auto job : jobs)
+    {
+        pool.addJob(job, false);
     }
 
     // теперь ищем айтемы в проекте, которые отсутствуют - или удалены - в состоянии
+    // и добавляем запись - added, с дельтами, которые тупо копируем у targetItem
     for (int i = 0; i < this->targetVcsItemsSource->getNumTrackedItems(); ++i)
     {
-        if (this->threadShouldExit())
+        TrackedItem *targetItem = this->targetVcsItemsSource->getTrackedItem(i);
+        if (stateItems.find(targetItem->getUuid().toString()) == stateItems.end())
         {
+            removedAndAddedRecords.add(new RevisionItem(this->pack, RevisionItem::Added, targetItem));
+        }
+    }
+
+    // partial results are merged in batches as the jobs complete,
+    // and each batch is streamed to the listeners (i.e. the stage component)
+    int numMergedJobs = 0;
+    while (numMergedJobs < jobs.size())
+    {
+        if (ownerThread != nullptr && ownerThread->threadShouldExit())
+        {
+            pool.removeAllJobs(true, DIFF_BUILD_THREAD_STOP_TIMEOUT);
             this->setRebuildingDiffMode(false);
             this->sendChangeMessage();
             return;
         }
 
-        bool foundItemInState = false;
-        TrackedItem *targetItem = this->targetVcsItemsSource->getTrackedItem(i);
-
-        for (int j = 0; j < this->state->getNumTrackedItems(); ++j)
+        if (ownerThread != nullptr)
         {
-            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(j));
-
-            if (stateItem->getType() == RevisionItem::Removed) { continue; }
-
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInState = true;
-                break;
-            }
+            jobDoneEvent.wait(DIFF_BUILD_JOBS_POLL_TIMEOUT);
         }
-
-        // и добавляем запись - added, с дельтами, которые тупо копируем у targetItem
-        if (! foundItemInState)
+        else
         {
-            RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Added, targetItem));
-            var revisionVar(revisionRecord);
-
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff.setProperty(targetItem->getUuid().toString(), revisionVar, nullptr);
+            jobDoneEvent.wait();
         }
-    }
 
-    this->setDiffOutdated(false);
-    this->setRebuildingDiffMode(false);
-    this->sendChangeMessage();
-}
-
-// warning код практически дублирует Head::run
-void Head::rebuildDiffSynchronously()
-{
-    if (this->targetVcsItemsSource == nullptr)
-    { return; }
-    
-    if (this->state == nullptr)
-    { return; }
-    
-    if (this->isRebuildingDiff())
-    { return; }
-    
-    this->setRebuildingDiffMode(true);
-    
-    {
+        bool hasNewRecords = false;
         const ScopedWriteLock lock(this->diffLock);
-        this->diff.removeAllChildren(nullptr);
-        this->diff.removeAllProperties(nullptr);
-    }
-    
-    const ScopedReadLock rebuildStateLock(this->stateLock);
-    
-    for (int i = 0; i < this->state->getNumTrackedItems(); ++i)
-    {
-        bool foundItemInTarget = false;
-        const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(i));
-        
-        // записи удаления рассматриваем позже
-        if (stateItem->getType() == RevisionItem::Removed) { continue; }
-        
-        for (int j = 0; j < this->targetVcsItemsSource->getNumTrackedItems(); ++j)
+
+        for (auto job : jobs)
         {
-            TrackedItem *targetItem = this->targetVcsItemsSource->getTrackedItem(j); // i.e. LayerTreeItem
-            
-            // айтем из состояния - существует в проекте. добавляем запись changed, если нужно.
-            if (stateItem->getUuid() == targetItem->getUuid())
+            if (! job->isMerged && job->isDone())
             {
-                foundItemInTarget = true;
-                
-                ScopedPointer<Diff> itemDiff(targetItem->getDiffLogic()->createDiff(*stateItem));
-                
-                if (itemDiff->hasAnyChanges())
+                job->isMerged = true;
+                numMergedJobs++;
+
+                if (job->result != nullptr)
                 {
-                    RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Changed, itemDiff));
-                    var revisionVar(revisionRecord);
-                    
-                    const ScopedWriteLock lock(this->diffLock);
-                    this->diff.setProperty(stateItem->getUuid().toString(), revisionVar, nullptr);
+                    this->diff.setProperty(job->stateItem->getUuid().toString(), var(job->result), nullptr);
+                    hasNewRecords = true;
                 }
-                
-                break;
             }
         }
-        
-        // айтем из состояния - в проекте не найден. добавляем запись removed.
-        if (! foundItemInTarget)
+
+        if (hasNewRecords && numMergedJobs < jobs.size())
         {
-            ScopedPointer<Diff> emptyDiff(new Diff(*stateItem));
-            
-            RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Removed, emptyDiff));
-            var revisionVar(revisionRecord);
-            
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff.setProperty(stateItem->getUuid().toString(), revisionVar, nullptr);
+            this->sendChangeMessage();
         }
     }
-    
-    // теперь ищем айтемы в проекте, которые отсутствуют - или удалены - в состоянии
-    for (int i = 0; i < this->targetVcsItemsSource->getNumTrackedItems(); ++i)
+
     {
-        bool foundItemInState = false;
-        TrackedItem *targetItem = this->targetVcsItemsSource->getTrackedItem(i);
-        
-        for (int j = 0; j < this->state->getNumTrackedItems(); ++j)
-        {
-            const RevisionItem::Ptr stateItem = static_cast<RevisionItem *>(this->state->getTrackedItem(j));
-            
-            if (stateItem->getType() == RevisionItem::Removed) { continue; }
-            
-            if (stateItem->getUuid() == targetItem->getUuid())
-            {
-                foundItemInState = true;
-                break;
-            }
-        }
-        
-        // и добавляем запись - added, с дельтами, которые тупо копируем у targetItem
-        if (! foundItemInState)
+        const ScopedWriteLock lock(this->diffLock);
+        for (auto record : removedAndAddedRecords)
         {
-            RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Added, targetItem));
-            var revisionVar(revisionRecord);
-            
-            const ScopedWriteLock lock(this->diffLock);
-            this->diff.setProperty(targetItem->getUuid().toString(), revisionVar, nullptr);
+            this->diff.setProperty(record->getUuid().toString(), var(record), nullptr);
         }
     }
-    
+
     this->setDiffOutdated(false);
     this->setRebuildingDiffMode(false);
     this->sendChangeMessage();
@@ -53,16 +53,33 @@ namespace VCS
 
         void mergeStateWith(ValueTree changes);
         bool moveTo(const ValueTree revision); // rebuilds state index
+        void moveTo(const ValueTree revision, HeadState *prebuiltState); // takes ownership
         void pointTo(const ValueTree revision); // does not rebuild index
 
+        // a detached copy of the revisions from the root down to the given one,
+        // to be created on the message thread and passed to createStateFor
+        static Array<ValueTree> createRevisionsPath(const ValueTree revision);
+
+        // merges all deltas along the path; doesn't touch the project or history,
+        // so it can be called from a worker thread, and
+        // returns nullptr if that thread was asked to exit in the middle
+        static HeadState *createStateFor(const Array<ValueTree> &revisionsPath,
+            Thread *ownerThread = nullptr);
+
         void checkout();
         void cherryPick(const Array<Uuid> uuids);
         void cherryPickAll();
+
+        // Like cherryPickAll, but the items the project has changed since
+        // the common head's state are merged three-way, instead of being reset;
+        // fills in the names of the items with conflicting changes,
+        // which are resolved in favour of the project
+        void mergeAll(const Head &common, StringArray &outConflicts);
         bool resetChanges(const Array<RevisionItem::Ptr> &changes);
 
         void rebuildDiffIfNeeded(); // called from the editor when it gets visible
         void rebuildDiffNow(); // called from the visible editor, when it receives vcs change message 
-        void rebuildDiffSynchronously(); // a hack foe quick-stash
+        void rebuildDiffSynchronously(); // a hack for quick-stash, same as rebuildDiffNow, but blocking
         
         //===--------------------------------------------------------------===//
         // Serializable
@@ -85,6 +102,7 @@ namespace VCS
         //===--------------------------------------------------------------===//
 
         void run() override;
+        void rebuildDiff(Thread *ownerThread); // runs the diff jobs and waits for them
         void checkoutItem(VCS::RevisionItem::Ptr stateItem);
         bool resetChangedItemToState(const VCS::RevisionItem::Ptr diffItem);
 
@@ -43,6 +43,8 @@ Pack::~Pack()
 bool Pack::containsDeltaDataFor(const Uuid &itemId,
                                 const Uuid &deltaId) const
 {
+    const ScopedLock lock(this->packLocker);
+
     if (this->packStream != nullptr)
     {
         // on-disk data
@@ -54,19 +56,20 @@ bool Pack::containsDeltaDataFor(const Uuid &itemId,
                 return true;
             }
         }
-        
-        // new in-memory data
-        for (auto block : this->unsavedData)
+    }
+    
+    // new in-memory data
+    for (auto block : this->unsavedData)
+    {
+        if (/*block->itemId == itemId &&*/
+            block->deltaId == deltaId)
         {
-            if (/*block->itemId == itemId &&*/
-                block->deltaId == deltaId)
-            {
-                return true;
-            }
+            return true;
         }
     }
-    
-    return false;
+
+    // not yet accessed data loaded with the project
+    return this->lazyData.find(deltaId.toString()) != this->lazyData.end();
 }
 
 ValueTree Pack::createDeltaDataFor(const Uuid &itemId, const Uuid &deltaId) const
@@ -84,19 +87,27 @@ ValueTree Pack::createDeltaDataFor(const Uuid &itemId, const Uuid &deltaId) cons
                 return this->createSerializedData(header);
             }
         }
+    }
 
-        // in-memory data
-        for (auto chunk : this->unsavedData)
+    // in-memory data
+    for (auto chunk : this->unsavedData)
+    {
+        if (/*chunk->itemId == itemId &&*/
+            chunk->deltaId == deltaId)
         {
-            if (/*chunk->itemId == itemId &&*/
-                chunk->deltaId == deltaId)
-            {
-                MemoryInputStream chunkDataStream(chunk->data, false);
-                return ValueTree::readFromStream(chunkDataStream);
-            }
+            MemoryInputStream chunkDataStream(chunk->data, false);
+            return ValueTree::readFromStream(chunkDataStream);
         }
     }
 
+    // data loaded with the project, decoded on every access,
+    // just like the other sources above create a new tree for every call
+    const auto lazyItem = this->lazyData.find(deltaId.toString());
+    if (lazyItem != this->lazyData.end())
+    {
+        return decodeLazyData(lazyItem->second);
+    }
+
     jassertfalse;
     return {};
 }
@@ -116,6 +127,11 @@ void Pack::setDeltaDataFor(const Uuid &itemId, const Uuid &deltaId, const ValueT
     this->unsavedData.add(chunk);
 }
 
+const CriticalSection &Pack::getLock() const noexcept
+{
+    return this->packLocker;
+}
+
 //===----------------------------------------------------------------------===//
 // Serializable
 //===----------------------------------------------------------------------===//
@@ -126,29 +142,53 @@ ValueTree VCS::Pack::serialize() const
 
     ValueTree tree(Serialization::VCS::pack);
 
-    // save on-disk data
+    // all data is saved encoded, so that it is not parsed on loading:
+    // on-disk data is copied as is
     if (this->packStream != nullptr)
     {
         for (auto header : this->headers)
         {
-            const auto deltaData(this->createSerializedData(header));
+            MemoryBlock deltaData;
+            this->readEncodedData(header, deltaData);
             ValueTree packItem(Serialization::VCS::packItem);
             //packItem.setProperty(Serialization::VCS::packItemRevId, header->itemId.toString(), nullptr);
             packItem.setProperty(Serialization::VCS::packItemDeltaId, header->deltaId.toString(), nullptr);
-            packItem.appendChild(deltaData, nullptr);
+            packItem.setProperty(Serialization::VCS::packItemData, var(deltaData), nullptr);
             tree.appendChild(packItem, nullptr);
         }
     }
 
-    // and in-memory data
+    // and in-memory data too
     for (auto chunk : this->unsavedData)
     {
-        MemoryInputStream chunkDataStream(chunk->data, false);
-        const auto deltaData(ValueTree::readFromStream(chunkDataStream));
         ValueTree packItem(Serialization::VCS::packItem);
         //packItem.setProperty(Serialization::VCS::packItemRevId, chunk->itemId.toString(), nullptr);
         packItem.setProperty(Serialization::VCS::packItemDeltaId, chunk->deltaId.toString(), nullptr);
-        packItem.appendChild(deltaData, nullptr);
+        packItem.setProperty(Serialization::VCS::packItemData, var(chunk->data), nullptr);
+        tree.appendChild(packItem, nullptr);
+    }
+
+    // and the data loaded with the project, which is only encoded
+    // if it came from the older projects, where it was saved as trees
+    for (const auto &lazyItem : this->lazyData)
+    {
+        ValueTree packItem(Serialization::VCS::packItem);
+        packItem.setProperty(Serialization::VCS::packItemDeltaId, lazyItem.first, nullptr);
+
+        if (lazyItem.second.hasProperty(Serialization::VCS::packItemData))
+        {
+            packItem.setProperty(Serialization::VCS::packItemData,
+                lazyItem.second.getProperty(Serialization::VCS::packItemData), nullptr);
+        }
+        else
+        {
+            MemoryBlock deltaData;
+            MemoryOutputStream out(deltaData, false);
+            lazyItem.second.getChild(0).writeToStream(out);
+            out.flush();
+            packItem.setProperty(Serialization::VCS::packItemData, var(deltaData), nullptr);
+        }
+
         tree.appendChild(packItem, nullptr);
     }
 
@@ -166,27 +206,18 @@ void VCS::Pack::deserialize(const ValueTree &tree)
 
     if (!root.isValid()) { return; }
 
+    // the data is not decoded and not dumped on the disk here,
+    // since most of it is never accessed after the project is loaded
     forEachValueTreeChildWithType(root, e, Serialization::VCS::packItem)
     {
-        // first, load the data
-        auto block = new DeltaDataChunk();
-        //block->itemId = e.getProperty(Serialization::VCS::packItemRevId);
-        block->deltaId = e.getProperty(Serialization::VCS::packItemDeltaId);
+        const String deltaId = e.getProperty(Serialization::VCS::packItemDeltaId);
 
-        MemoryOutputStream ms(block->data, false);
-        const auto firstChild(e.getChild(0));
-
-        if (firstChild.isValid())
+        if (e.getProperty(Serialization::VCS::packItemData).isBinaryData() ||
+            e.getChild(0).isValid())
         {
-            firstChild.writeToStream(ms);
+            this->lazyData[deltaId] = e;
         }
-
-        ms.flush();
-        this->unsavedData.add(block);
     }
-
-    // then dump it on the disk
-    this->flush();
 }
 
 void Pack::reset()
@@ -195,6 +226,7 @@ void Pack::reset()
 
     this->headers.clear();
     this->unsavedData.clear();
+    this->lazyData.clear();
     this->packStream = nullptr;
     this->packWriteLocker = nullptr;
     this->packFile.deleteFile();
@@ -262,3 +294,22 @@ ValueTree Pack::createSerializedData(const DeltaDataHeader *header) const
     this->packStream->setPosition(header->startPosition);
     return ValueTree::readFromStream(*this->packStream);
 }
+
+void Pack::readEncodedData(const DeltaDataHeader *header, MemoryBlock &result) const
+{
+    const ScopedLock lock(this->packStreamLock);
+    this->packStream->setPosition(header->startPosition);
+    this->packStream->readIntoMemoryBlock(result, header->numBytes);
+}
+
+// Pack items are saved as the encoded bytes of their trees;
+// the older projects have the trees themselves as the items' children
+ValueTree Pack::decodeLazyData(const ValueTree &packItem)
+{
+    if (const MemoryBlock *data = packItem.getProperty(Serialization::VCS::packItemData).getBinaryData())
+    {
+        return ValueTree::readFromData(data->getData(), data->getSize());
+    }
+
+    return packItem.getChild(0).createCopy();
+}
@@ -54,6 +54,9 @@ namespace VCS
         void setDeltaDataFor(const Uuid &itemId,
             const Uuid &deltaId, const ValueTree &data);
 
+        // re-entrant, held by the callers reading many deltas at once
+        const CriticalSection &getLock() const noexcept;
+
         //===--------------------------------------------------------------===//
         // Serializable
         //===--------------------------------------------------------------===//
@@ -67,6 +70,8 @@ namespace VCS
     protected:
 
         ValueTree createSerializedData(const DeltaDataHeader *header) const;
+        void readEncodedData(const DeltaDataHeader *header, MemoryBlock &result) const;
+        static ValueTree decodeLazyData(const ValueTree &packItem);
 
     private:
 
@@ -75,6 +80,12 @@ namespace VCS
         OwnedArray<DeltaDataHeader> headers;
         OwnedArray<DeltaDataChunk> unsavedData;
 
+        // Data loaded with the project is not decoded or flushed
+        // on deserialization: these are just references to the loaded
+        // pack items, holding the encoded trees, which are only parsed
+        // when accessed; nothing is cached, each access decodes a new tree
+        SparseHashMap<String, ValueTree, StringHash> lazyData;
+
         File packFile;
         CriticalSection packStreamLock;
 
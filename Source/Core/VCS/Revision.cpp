@@ -48,6 +48,12 @@ static Pack::Ptr getPackPtr(ValueTree revision)
     return nullptr;
 }
 
+static inline bool isCachedHash(const Identifier &id)
+{
+    return id == Serialization::VCS::commitHash ||
+        id == Serialization::VCS::commitTreeHash;
+}
+
 // simple setProperty, or copy deltas when using different delta packs
 static void copyProperty(ValueTree valueTree,
     Identifier id, const RevisionItem::Ptr itemToCopy)
@@ -74,7 +80,7 @@ void Revision::copyProperties(ValueTree one, ValueTree another)
     for (int i = 0; i < another.getNumProperties(); ++i)
     {
         const Identifier id(another.getPropertyName(i));
-        if (id == Serialization::VCS::pack)
+        if (id == Serialization::VCS::pack || isCachedHash(id))
         {
             continue;
         }
@@ -89,6 +95,8 @@ void Revision::copyProperties(ValueTree one, ValueTree another)
             one.setProperty(id, property, nullptr);
         }
     }
+
+    Revision::invalidateHash(one);
 }
 
 static void resetAllDeltas(ValueTree valueTree)
@@ -123,10 +131,18 @@ void VCS::Revision::copyDeltas(ValueTree one, ValueTree another)
             copyProperty(one, id, revItem);
         }
     }
+
+    Revision::invalidateHash(one);
 }
 
-MD5 Revision::calculateHash(ValueTree revision)
+String Revision::calculateHash(ValueTree revision)
 {
+    const var cachedHash(revision.getProperty(Serialization::VCS::commitHash));
+    if (cachedHash.isString())
+    {
+        return cachedHash.toString();
+    }
+
     StringArray sum;
     for (int i = 0; i < revision.getNumProperties(); ++i)
     {
@@ -147,7 +163,43 @@ MD5 Revision::calculateHash(ValueTree revision)
     }
 
     sum.sort(true);
-    return MD5(sum.joinIntoString("").toUTF8());
+    const String hash(MD5(sum.joinIntoString("").toUTF8()).toHexString());
+    revision.setProperty(Serialization::VCS::commitHash, hash, nullptr);
+    return hash;
+}
+
+String Revision::calculateTreeHash(ValueTree revision)
+{
+    const var cachedHash(revision.getProperty(Serialization::VCS::commitTreeHash));
+    if (cachedHash.isString())
+    {
+        return cachedHash.toString();
+    }
+
+    // sorted, so that the result doesn't depend on the order of children
+    StringArray childrenHashes;
+    for (int i = 0; i < revision.getNumChildren(); ++i)
+    {
+        childrenHashes.add(Revision::calculateTreeHash(revision.getChild(i)));
+    }
+
+    childrenHashes.sort(true);
+    childrenHashes.insert(0, Revision::calculateHash(revision));
+
+    const String hash(MD5(childrenHashes.joinIntoString("").toUTF8()).toHexString());
+    revision.setProperty(Serialization::VCS::commitTreeHash, hash, nullptr);
+    return hash;
+}
+
+void Revision::invalidateHash(ValueTree revision)
+{
+    revision.removeProperty(Serialization::VCS::commitHash, nullptr);
+
+    // all parents' tree hashes depend on this one
+    for (ValueTree node(revision); node.isValid(); node = node.getParent())
+    {
+        node.removeProperty(Serialization::VCS::commitTreeHash, nullptr);
+    }
 }
 
 bool Revision::isEmpty(ValueTree revision)
@@ -219,7 +271,7 @@ ValueTree Revision::serialize(ValueTree revision)
                 tree.appendChild(revItem->serialize(), nullptr);
             }
         }
-        else if (property.isString() || property.isInt64())
+        else if ((property.isString() || property.isInt64()) && !isCachedHash(id))
         {
             tree.setProperty(id, property.toString(), nullptr);
         }
@@ -247,6 +299,7 @@ void Revision::deserialize(ValueTree revision, const ValueTree &tree)
     for (int i = 0; i < root.getNumProperties(); ++i)
     {
         const auto propertyId(root.getPropertyName(i));
+        if (isCachedHash(propertyId)) { continue; }
         revision.setProperty(propertyId, root.getProperty(propertyId), nullptr);
     }
 
@@ -273,4 +326,5 @@ void Revision::reset(ValueTree revision)
     //this->removeAllProperties(nullptr); // never delete properties
     resetAllDeltas(revision);
     revision.removeAllChildren(nullptr);
+    Revision::invalidateHash(revision);
 }
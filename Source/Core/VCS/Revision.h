@@ -34,7 +34,13 @@ namespace VCS
         static void copyProperties(ValueTree one, ValueTree another);
         static void copyDeltas(ValueTree one, ValueTree another);
 
-        static MD5 calculateHash(ValueTree revision);
+        // Both hashes are cached in the revision and only recalculated
+        // after invalidateHash() is called for it or any of its children;
+        // tree hash is a Merkle-style sum of the revision and its subtree
+        static String calculateHash(ValueTree revision);
+        static String calculateTreeHash(ValueTree revision);
+        static void invalidateHash(ValueTree revision);
+
         static void incrementVersion(ValueTree revision);
         static void flush(ValueTree revision);
 
@@ -22,10 +22,100 @@
 #include "TrackedItem.h"
 #include "MidiSequence.h"
 #include "SerializationKeys.h"
-#include "SerializationKeys.h"
 
 using namespace VCS;
 
+//===----------------------------------------------------------------------===//
+// Checkout thread
+//===----------------------------------------------------------------------===//
+
+// Merges deltas up to the target revision off the message thread,
+// so that the project is only touched once the whole state is ready;
+// works on a detached copy of the revisions path, so that, when cancelled,
+// it is not waited for, but left to finish and is deleted by the owner then
+class VersionControl::CheckoutThread final : public Thread, private AsyncUpdater
+{
+public:
+
+    CheckoutThread(VersionControl &owner, const ValueTree revision,
+        const Array<Uuid> uuids, bool cherryPickOnly, CheckoutCallback callback) :
+        Thread("Checkout Thread"),
+        owner(owner),
+        revision(revision),
+        revisionsPath(Head::createRevisionsPath(revision)),
+        uuids(uuids),
+        cherryPickOnly(cherryPickOnly),
+        callback(callback),
+        cancelled(false) {}
+
+    ~CheckoutThread() override
+    {
+        // createStateFor checks for this between the revisions, so it won't take long
+        this->signalThreadShouldExit();
+        this->waitForThreadToExit(-1);
+        this->cancelPendingUpdate();
+    }
+
+    ValueTree getRevision() const noexcept { return this->revision; }
+    const Array<Uuid> &getUuids() const noexcept { return this->uuids; }
+    bool isCherryPickOnly() const noexcept { return this->cherryPickOnly; }
+    HeadState *releaseState() noexcept { return this->state.release(); }
+
+    void notifyDone(bool applied)
+    {
+        if (this->callback != nullptr)
+        {
+            const auto callbackCopy = this->callback;
+            this->callback = nullptr;
+            callbackCopy(applied);
+        }
+    }
+
+    // Called on the message thread, after the owner has moved this object
+    // to the list of cancelled checkouts
+    void cancel()
+    {
+        this->cancelled = true;
+        this->signalThreadShouldExit();
+        this->notifyDone(false);
+    }
+
+private:
+
+    void run() override
+    {
+        this->state = Head::createStateFor(this->revisionsPath, this);
+
+        // either way, the rest is done on the message thread
+        this->triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        if (this->cancelled)
+        {
+            // will delete this thread object
+            this->owner.onCancelledCheckoutDone(this);
+            return;
+        }
+
+        // will delete this thread object
+        this->owner.onCheckoutStateReady();
+    }
+
+    VersionControl &owner;
+    const ValueTree revision;
+    const Array<ValueTree> revisionsPath;
+    const Array<Uuid> uuids;
+    const bool cherryPickOnly;
+    CheckoutCallback callback;
+    bool cancelled;
+
+    ScopedPointer<HeadState> state;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CheckoutThread)
+};
+
 VersionControl::VersionControl(WeakReference<VCS::TrackedItemsSource> parent,
                                const String &existingId,
                                const String &existingKeyBase64) :
@@ -65,6 +155,16 @@ VersionControl::VersionControl(WeakReference<VCS::TrackedItemsSource> parent,
 
 VersionControl::~VersionControl()
 {
+    if (this->checkoutThread != nullptr)
+    {
+        // the thread refers to this object, so here it has to be stopped right away
+        this->checkoutThread->notifyDone(false);
+        this->checkoutThread = nullptr;
+    }
+
+    // the cancelled ones might still be running, and they refer to this object too
+    this->cancelledCheckouts.clear();
+
     MessageManagerLock lock;
     this->removeChangeListener(&this->head);
 }
@@ -84,31 +184,35 @@ VersionControlEditor *VersionControl::createEditor()
 // Push-pull stuff
 //===----------------------------------------------------------------------===//
 
-MD5 VersionControl::calculateHash() const
+String VersionControl::calculateHash()
 {
-    // StringArray и sort - чтоб не зависеть от порядка чайлдов.
-    StringArray ids(this->recursiveGetHashes(this->rootRevision));
-    ids.sort(true);
-    return MD5(ids.joinIntoString("").toUTF8());
+    return Revision::calculateTreeHash(this->rootRevision);
 }
 
-StringArray VersionControl::recursiveGetHashes(const ValueTree revision) const
+// The deepest revision both given ones descend from
+static ValueTree findCommonRevision(const ValueTree &first, const ValueTree &second)
 {
-    StringArray sum;
+    SparseHashSet<String, StringHash> firstPath;
+    for (ValueTree r(first); r.isValid(); r = r.getParent())
+    {
+        firstPath.insert(Revision::getUuid(r));
+    }
 
-    for (int i = 0; i < revision.getNumChildren(); ++i)
+    for (ValueTree r(second); r.isValid(); r = r.getParent())
     {
-        ValueTree child(revision.getChild(i));
-        sum.addArray(this->recursiveGetHashes(child));
+        if (firstPath.find(Revision::getUuid(r)) != firstPath.end())
+        {
+            return r;
+        }
     }
 
-    const String revisionSum(Revision::calculateHash(revision).toHexString());
-    sum.add(revisionSum);
-    return sum;
+    return {};
 }
 
-void VersionControl::mergeWith(VersionControl &remoteHistory)
+void VersionControl::mergeWith(VersionControl &remoteHistory, StringArray &outConflicts)
 {
+    const ValueTree oldHeadRevision(this->head.getHeadingRevision());
+
     this->recursiveTreeMerge(this->getRoot(), remoteHistory.getRoot());
 
     this->publicId = remoteHistory.getPublicId();
@@ -119,7 +223,13 @@ void VersionControl::mergeWith(VersionControl &remoteHistory)
 
     if (! Revision::isEmpty(newHeadRevision))
     {
+        // the project is still at the old head, with its own changes on top of it,
+        // so it gets the remote changes made since the revision both heads descend from
+        Head commonHead(this->head);
+        commonHead.moveTo(findCommonRevision(oldHeadRevision, newHeadRevision));
+
         this->head.moveTo(newHeadRevision);
+        this->head.mergeAll(commonHead, outConflicts);
     }
 
     this->pack->flush();
@@ -129,6 +239,13 @@ void VersionControl::mergeWith(VersionControl &remoteHistory)
 void VersionControl::recursiveTreeMerge(ValueTree localRevision,
     ValueTree remoteRevision)
 {
+    // identical subtrees need no walk at all
+    if (Revision::calculateTreeHash(localRevision) ==
+        Revision::calculateTreeHash(remoteRevision))
+    {
+        return;
+    }
+
     // сначала мерж двух ревизий.
     // проход по чайлдам идет потом, чтоб head.moveTo у чайлда имел дело
     // с уже смерженным родителем.
@@ -182,6 +299,7 @@ void VersionControl::recursiveTreeMerge(ValueTree localRevision,
             Revision::copyProperties(newLocalChild, remoteChild);
             Revision::flush(newLocalChild);
             localRevision.appendChild(newLocalChild, nullptr);
+            Revision::invalidateHash(newLocalChild);
             this->recursiveTreeMerge(newLocalChild, remoteChild);
         }
     }
@@ -238,32 +356,91 @@ void VersionControl::moveHead(const ValueTree revision)
     }
 }
 
-void VersionControl::checkout(const ValueTree revision)
+void VersionControl::checkout(const ValueTree revision, CheckoutCallback callback)
 {
     if (! Revision::isEmpty(revision))
     {
-        this->head.moveTo(revision);
-        this->head.checkout();
-        this->sendChangeMessage();
+        this->startCheckoutThread(revision, {}, false, callback);
     }
 }
 
-void VersionControl::cherryPick(const ValueTree revision, const Array<Uuid> uuids)
+void VersionControl::cherryPick(const ValueTree revision,
+    const Array<Uuid> uuids, CheckoutCallback callback)
 {
     if (! Revision::isEmpty(revision))
     {
-        ValueTree headRevision(this->head.getHeadingRevision());
-        this->head.moveTo(revision);
-        this->head.cherryPick(uuids);
-        this->head.moveTo(headRevision);
-        this->sendChangeMessage();
+        this->startCheckoutThread(revision, uuids, true, callback);
+    }
+}
+
+bool VersionControl::isCheckingOut() const noexcept
+{
+    return this->checkoutThread != nullptr;
+}
+
+void VersionControl::cancelCheckout()
+{
+    // doesn't wait for the thread, and drops the state it builds
+    if (this->checkoutThread != nullptr)
+    {
+        auto *cancelledThread = this->checkoutThread.release();
+        this->cancelledCheckouts.add(cancelledThread);
+        cancelledThread->cancel();
+    }
+}
+
+void VersionControl::startCheckoutThread(const ValueTree revision,
+    const Array<Uuid> uuids, bool cherryPickOnly, CheckoutCallback callback)
+{
+    this->cancelCheckout();
+    this->checkoutThread = new CheckoutThread(*this, revision, uuids, cherryPickOnly, callback);
+    this->checkoutThread->startThread(5);
+}
+
+void VersionControl::onCheckoutStateReady()
+{
+    ScopedPointer<CheckoutThread> finishedThread(this->checkoutThread.release());
+    jassert(finishedThread != nullptr);
+
+    // run() has already built the state, just let it return
+    finishedThread->waitForThreadToExit(-1);
+
+    const ValueTree revision(finishedThread->getRevision());
+    HeadState *newState = finishedThread->releaseState();
+    if (newState == nullptr)
+    {
+        finishedThread->notifyDone(false);
+        return;
+    }
+
+    if (finishedThread->isCherryPickOnly())
+    {
+        // the head stays where it was, only the picked items are reset
+        Head tempHead(this->head);
+        tempHead.moveTo(revision, newState);
+        tempHead.cherryPick(finishedThread->getUuids());
+        this->head.setDiffOutdated(true);
+    }
+    else
+    {
+        this->head.moveTo(revision, newState);
+        this->head.checkout();
     }
+
+    this->sendChangeMessage();
+    finishedThread->notifyDone(true);
+}
+
+void VersionControl::onCancelledCheckoutDone(CheckoutThread *cancelledThread)
+{
+    this->cancelledCheckouts.removeObject(cancelledThread);
 }
 
 void VersionControl::quickAmendItem(TrackedItem *targetItem)
 {
     RevisionItem::Ptr revisionRecord(new RevisionItem(this->pack, RevisionItem::Added, targetItem));
     this->head.getHeadingRevision().setProperty(revisionRecord->getUuid().toString(), var(revisionRecord), nullptr);
+    Revision::invalidateHash(this->head.getHeadingRevision());
     this->head.moveTo(this->head.getHeadingRevision());
     Revision::flush(this->head.getHeadingRevision());
     this->pack->flush();
@@ -339,6 +516,7 @@ bool VersionControl::commit(SparseSet<int> selectedItems, const String &message)
     if (!headingRevision.isValid()) { return false; }
 
     headingRevision.appendChild(newRevision, nullptr);
+    Revision::invalidateHash(newRevision);
     this->head.moveTo(newRevision);
 
     Revision::flush(newRevision);
@@ -428,14 +606,16 @@ bool VersionControl::quickStashAll()
     return true;
 }
 
-bool VersionControl::applyQuickStash()
+bool VersionControl::applyQuickStash(StringArray &outConflicts)
 {
     if (! this->hasQuickStash())
     { return false; }
     
+    // the project might have been changed since the changes were stashed,
+    // so the stashed changes are merged with the project's changes since the head
     Head tempHead(this->head);
     tempHead.mergeStateWith(this->stashes->getQuickStash());
-    tempHead.cherryPickAll();
+    tempHead.mergeAll(this->head, outConflicts);
     this->stashes->resetQuickStash();
     
     this->sendChangeMessage();
@@ -68,8 +68,11 @@ public:
     inline void incrementVersion()
     { this->historyMergeVersion += 1; }
 
-    MD5 calculateHash() const;
-    void mergeWith(VersionControl &remoteHistory);
+    // Caches the hashes in the revision tree, hence not const
+    String calculateHash();
+    // Fills in the names of the items changed both locally and remotely,
+    // which are resolved in favour of the local changes
+    void mergeWith(VersionControl &remoteHistory, StringArray &outConflicts);
 
     //===------------------------------------------------------------------===//
     // VCS
@@ -80,8 +83,17 @@ public:
     ValueTree getRoot() { return this->rootRevision; }
 
     void moveHead(const ValueTree revision);
-    void checkout(const ValueTree revision);
-    void cherryPick(const ValueTree revision, const Array<Uuid> uuids);
+
+    // Called on the message thread, when the checkout is either applied or cancelled
+    using CheckoutCallback = Function<void(bool applied)>;
+
+    // both build the target state in a background thread
+    // and then apply it to the project in a single batch:
+    void checkout(const ValueTree revision, CheckoutCallback callback = nullptr);
+    void cherryPick(const ValueTree revision, const Array<Uuid> uuids,
+        CheckoutCallback callback = nullptr);
+    bool isCheckingOut() const noexcept;
+    void cancelCheckout();
 
     bool resetChanges(SparseSet<int> selectedItems);
     bool resetAllChanges();
@@ -94,7 +106,7 @@ public:
     
     bool hasQuickStash() const;
     bool quickStashAll();
-    bool applyQuickStash();
+    bool applyQuickStash(StringArray &outConflicts);
     
     //===------------------------------------------------------------------===//
     // Serializable
@@ -112,10 +124,19 @@ public:
     
 protected:
 
-    StringArray recursiveGetHashes(const ValueTree revision) const;
     void recursiveTreeMerge(ValueTree localRevision, ValueTree remoteRevision);
     ValueTree getRevisionById(const ValueTree startFrom, const String &id) const;
 
+    class CheckoutThread;
+    friend class CheckoutThread;
+    void startCheckoutThread(const ValueTree revision, const Array<Uuid> uuids,
+        bool cherryPickOnly, CheckoutCallback callback);
+    void onCheckoutStateReady();
+    void onCancelledCheckoutDone(CheckoutThread *cancelledThread);
+
+    ScopedPointer<CheckoutThread> checkoutThread;
+    OwnedArray<CheckoutThread> cancelledCheckouts;
+
     VCS::Pack::Ptr pack;
     VCS::StashesRepository::Ptr stashes;
     VCS::Head head;
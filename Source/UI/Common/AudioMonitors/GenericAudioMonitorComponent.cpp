@@ -38,10 +38,12 @@ static const float kSpectrumFrequencies[] =
 };
 
 GenericAudioMonitorComponent::GenericAudioMonitorComponent(WeakReference<AudioMonitor> monitor)
-    : Thread("Spectrum Component"),
-      audioMonitor(monitor),
-      skewTime(0)
+    : audioMonitor(monitor),
+      lPeak(0.f),
+      rPeak(0.f)
 {
+    zeromem(this->values, sizeof(float) * GENERIC_METER_NUM_BANDS);
+
     // (true, false) will enable switching rendering modes on click
     this->setInterceptsMouseClicks(false, false);
     this->setPaintingIsUnclipped(true);
@@ -56,7 +58,7 @@ GenericAudioMonitorComponent::GenericAudioMonitorComponent(WeakReference<AudioMo
 
     if (this->audioMonitor != nullptr)
     {
-        this->startThread(5);
+        this->audioMonitor->addAnalysisListener(this);
     }
 }
 
@@ -64,38 +66,34 @@ void GenericAudioMonitorComponent::setTargetAnalyzer(WeakReference<AudioMonitor>
 {
     if (monitor != nullptr)
     {
+        if (this->audioMonitor != nullptr)
+        {
+            this->audioMonitor->removeAnalysisListener(this);
+        }
+
         this->audioMonitor = monitor;
-        this->startThread(5);
+        this->audioMonitor->addAnalysisListener(this);
     }
 }
 
 GenericAudioMonitorComponent::~GenericAudioMonitorComponent()
 { 
-    this->stopThread(1000);
+    if (this->audioMonitor != nullptr)
+    {
+        this->audioMonitor->removeAnalysisListener(this);
+    }
 }
 
-void GenericAudioMonitorComponent::run()
+void GenericAudioMonitorComponent::onAnalysisUpdated()
 {
-    while (! this->threadShouldExit())
-    {
-        Thread::sleep(jlimit(10, 100, 35 - this->skewTime));
-        const double b = Time::getMillisecondCounterHiRes();
+    this->lPeak = this->audioMonitor->getPeak(0);
+    this->rPeak = this->audioMonitor->getPeak(1);
 
-        for (int i = 0; i < GENERIC_METER_NUM_BANDS; ++i)
-        {
-            this->lPeak = this->audioMonitor->getPeak(0);
-            this->rPeak = this->audioMonitor->getPeak(1);
-            this->values[i] = this->audioMonitor->getInterpolatedSpectrumAtFrequency(kSpectrumFrequencies[i]);
-        }
-
-        this->triggerAsyncUpdate();
-        const double a = Time::getMillisecondCounterHiRes();
-        this->skewTime = int(a - b);
+    for (int i = 0; i < GENERIC_METER_NUM_BANDS; ++i)
+    {
+        this->values[i] = this->audioMonitor->getInterpolatedSpectrumAtFrequency(kSpectrumFrequencies[i]);
     }
-}
 
-void GenericAudioMonitorComponent::handleAsyncUpdate()
-{
     this->repaint();
 }
 
@@ -121,8 +119,8 @@ void GenericAudioMonitorComponent::paint(Graphics &g)
 
 #if GENERIC_METER_SHOWS_VOLUME_PEAKS
 
-    this->lPeakBand->processSignal(this->lPeak.get(), h, timeNow);
-    this->rPeakBand->processSignal(this->rPeak.get(), h, timeNow);
+    this->lPeakBand->processSignal(this->lPeak, h, timeNow);
+    this->rPeakBand->processSignal(this->rPeak, h, timeNow);
 
     // Volume indicators:
     // TODO pretty up their look and add yellow/red colors for clipped signal
@@ -151,7 +149,7 @@ void GenericAudioMonitorComponent::paint(Graphics &g)
 
     for (int i = 0; i < GENERIC_METER_NUM_BANDS; ++i)
     {
-        this->bands[i]->processSignal(this->values[i].get(), h, timeNow);
+        this->bands[i]->processSignal(this->values[i], h, timeNow);
     }
 
     g.setColour(Colours::white.withAlpha(0.25f));
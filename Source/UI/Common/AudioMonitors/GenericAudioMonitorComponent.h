@@ -21,7 +21,7 @@
 
 #define GENERIC_METER_NUM_BANDS 10
 
-class GenericAudioMonitorComponent : public Component, private Thread, private AsyncUpdater
+class GenericAudioMonitorComponent : public Component, private AudioMonitor::AnalysisListener
 {
 public:
 
@@ -57,8 +57,7 @@ private:
     
 private:
     
-    void run() override;
-    void handleAsyncUpdate() override;
+    void onAnalysisUpdated() override;
     
     WeakReference<AudioMonitor> audioMonitor;
     OwnedArray<SpectrumBand> bands;
@@ -66,11 +65,9 @@ private:
     ScopedPointer<SpectrumBand> lPeakBand;
     ScopedPointer<SpectrumBand> rPeakBand;
 
-    Atomic<float> values[GENERIC_METER_NUM_BANDS];
-    Atomic<float> lPeak;
-    Atomic<float> rPeak;
-
-    int skewTime;
+    float values[GENERIC_METER_NUM_BANDS];
+    float lPeak;
+    float rPeak;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GenericAudioMonitorComponent);
 };
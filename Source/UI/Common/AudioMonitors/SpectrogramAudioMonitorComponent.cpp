@@ -37,59 +37,54 @@ static const float kSpectrumFrequencies[] =
 };
 
 SpectrogramAudioMonitorComponent::SpectrogramAudioMonitorComponent(WeakReference<AudioMonitor> targetAnalyzer) :
-    Thread("Volume Component"),
     audioMonitor(targetAnalyzer),
-    head(0),
-    skewTime(0)
+    head(0)
 {
     this->setInterceptsMouseClicks(false, false);
     this->setPaintingIsUnclipped(true);
 
+    zeromem(this->spectrum, sizeof(float) * SPECTROGRAM_BUFFER_SIZE * SPECTROGRAM_NUM_BANDS);
+
     if (this->audioMonitor != nullptr)
     {
-        this->startThread(6);
+        this->audioMonitor->addAnalysisListener(this);
     }
 }
 
 SpectrogramAudioMonitorComponent::~SpectrogramAudioMonitorComponent()
 {
-    this->stopThread(1000);
+    if (this->audioMonitor != nullptr)
+    {
+        this->audioMonitor->removeAnalysisListener(this);
+    }
 }
 
 void SpectrogramAudioMonitorComponent::setTargetAnalyzer(WeakReference<AudioMonitor> targetAnalyzer)
 {
     if (targetAnalyzer != nullptr)
     {
+        if (this->audioMonitor != nullptr)
+        {
+            this->audioMonitor->removeAnalysisListener(this);
+        }
+
         this->audioMonitor = targetAnalyzer;
-        this->startThread(6);
+        this->audioMonitor->addAnalysisListener(this);
     }
 }
 
-void SpectrogramAudioMonitorComponent::run()
+void SpectrogramAudioMonitorComponent::onAnalysisUpdated()
 {
-    while (! this->threadShouldExit())
-    {
-        Thread::sleep(jlimit(10, 100, 35 - this->skewTime));
-        const double b = Time::getMillisecondCounterHiRes();
+    // Move to the next row:
+    this->head = (this->head + 1) % SPECTROGRAM_BUFFER_SIZE;
 
-        // Move to the next row:
-        this->head = (this->head.get() + 1) % SPECTROGRAM_BUFFER_SIZE;
-
-        // Update matrix:
-        for (int i = 0; i < SPECTROGRAM_NUM_BANDS; ++i)
-        {
-            this->spectrum[this->head.get()][i] =
-                this->audioMonitor->getInterpolatedSpectrumAtFrequency(kSpectrumFrequencies[i]);
-        }
-
-        this->triggerAsyncUpdate();
-        const double a = Time::getMillisecondCounterHiRes();
-        this->skewTime = int(a - b);
+    // Update matrix:
+    for (int i = 0; i < SPECTROGRAM_NUM_BANDS; ++i)
+    {
+        this->spectrum[this->head][i] =
+            this->audioMonitor->getInterpolatedSpectrumAtFrequency(kSpectrumFrequencies[i]);
     }
-}
 
-void SpectrogramAudioMonitorComponent::handleAsyncUpdate()
-{
     this->repaint();
 }
 
@@ -114,7 +109,7 @@ void SpectrogramAudioMonitorComponent::paint(Graphics &g)
     }
     
     const int h = this->getHeight();
-    const int start = this->head.get();
+    const int start = this->head;
 
     // Head:
     for (int i = start + 1; i < SPECTROGRAM_BUFFER_SIZE; ++i)
@@ -122,7 +117,7 @@ void SpectrogramAudioMonitorComponent::paint(Graphics &g)
         for (int j = SPECTROGRAM_NUM_BANDS; j-- > 0; )
         {
             const float x = float(i - start);
-            const float v = iecLevel(this->spectrum[i][j].get());
+            const float v = iecLevel(this->spectrum[i][j]);
             g.setColour(Colours::white.withAlpha(v));
             g.drawHorizontalLine(h - j * 4, x * 2.f, x * 2.f + 1.f);
             //g.drawHorizontalLine(h - j * 4 + 1, x * 2.f, x * 2.f + 1.f);
@@ -135,7 +130,7 @@ void SpectrogramAudioMonitorComponent::paint(Graphics &g)
         for (int j = SPECTROGRAM_NUM_BANDS; j-- > 0; )
         {
             const float x = float(i + (SPECTROGRAM_BUFFER_SIZE - start));
-            const float v = iecLevel(this->spectrum[i][j].get());
+            const float v = iecLevel(this->spectrum[i][j]);
             g.setColour(Colours::white.withAlpha(v));
             g.drawHorizontalLine(h - j * 4, x * 2.f, x * 2.f + 1.f);
             //g.drawHorizontalLine(h - j * 4 + 1, x * 2.f, x * 2.f + 1.f);
@@ -17,15 +17,14 @@
 
 #pragma once
 
-class AudioMonitor;
-
+#include "AudioMonitor.h"
 #include "SequencerLayout.h"
 
 #define SPECTROGRAM_BUFFER_SIZE (SEQUENCER_SIDEBAR_WIDTH / 2)
 #define SPECTROGRAM_NUM_BANDS (SEQUENCER_SIDEBAR_WIDTH / 2)
 
 class SpectrogramAudioMonitorComponent :
-    public Component, private Thread, private AsyncUpdater
+    public Component, private AudioMonitor::AnalysisListener
 {
 public:
 
@@ -42,16 +41,12 @@ public:
 
 private:
 
-    void run() override;
-    void handleAsyncUpdate() override;
+    void onAnalysisUpdated() override;
     
     WeakReference<AudioMonitor> audioMonitor;
     
-    Atomic<float> peakBuffer[SPECTROGRAM_BUFFER_SIZE];
-    Atomic<float> spectrum[SPECTROGRAM_BUFFER_SIZE][SPECTROGRAM_NUM_BANDS];
-
-    Atomic<int> head;
-    int skewTime;
+    float spectrum[SPECTROGRAM_BUFFER_SIZE][SPECTROGRAM_NUM_BANDS];
+    int head;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramAudioMonitorComponent)
 
@@ -25,66 +25,61 @@
 #define WAVEFORM_METER_MINDB (-69.0f)
 
 WaveformAudioMonitorComponent::WaveformAudioMonitorComponent(WeakReference<AudioMonitor> targetAnalyzer) :
-    Thread("Volume Component"),
-    audioMonitor(targetAnalyzer),
-    skewTime(0)
+    audioMonitor(targetAnalyzer)
 {
     this->setInterceptsMouseClicks(false, false);
     this->setPaintingIsUnclipped(true);
 
+    zeromem(this->lPeakBuffer, sizeof(float) * WAVEFORM_METER_BUFFER_SIZE);
+    zeromem(this->rPeakBuffer, sizeof(float) * WAVEFORM_METER_BUFFER_SIZE);
+    zeromem(this->lRmsBuffer, sizeof(float) * WAVEFORM_METER_BUFFER_SIZE);
+    zeromem(this->rRmsBuffer, sizeof(float) * WAVEFORM_METER_BUFFER_SIZE);
+
     if (this->audioMonitor != nullptr)
     {
-        this->startThread(6);
+        this->audioMonitor->addAnalysisListener(this);
     }
 }
 
 WaveformAudioMonitorComponent::~WaveformAudioMonitorComponent()
 {
-    this->stopThread(1000);
+    if (this->audioMonitor != nullptr)
+    {
+        this->audioMonitor->removeAnalysisListener(this);
+    }
 }
 
 void WaveformAudioMonitorComponent::setTargetAnalyzer(WeakReference<AudioMonitor> targetAnalyzer)
 {
     if (targetAnalyzer != nullptr)
     {
+        if (this->audioMonitor != nullptr)
+        {
+            this->audioMonitor->removeAnalysisListener(this);
+        }
+
         this->audioMonitor = targetAnalyzer;
-        this->startThread(6);
+        this->audioMonitor->addAnalysisListener(this);
     }
 }
 
-void WaveformAudioMonitorComponent::run()
+void WaveformAudioMonitorComponent::onAnalysisUpdated()
 {
-    while (! this->threadShouldExit())
-    {
-        Thread::sleep(jlimit(10, 100, 35 - this->skewTime));
-        const double b = Time::getMillisecondCounterHiRes();
+    // Shift buffers:
+    const size_t numBytesToShift = sizeof(float) * (WAVEFORM_METER_BUFFER_SIZE - 1);
+    memmove(this->lPeakBuffer, this->lPeakBuffer + 1, numBytesToShift);
+    memmove(this->rPeakBuffer, this->rPeakBuffer + 1, numBytesToShift);
+    memmove(this->lRmsBuffer, this->lRmsBuffer + 1, numBytesToShift);
+    memmove(this->rRmsBuffer, this->rRmsBuffer + 1, numBytesToShift);
 
-        // Shift buffers:
-        for (int i = 0; i < WAVEFORM_METER_BUFFER_SIZE - 1; ++i)
-        {
-            this->lPeakBuffer[i] = this->lPeakBuffer[i + 1].get();
-            this->rPeakBuffer[i] = this->rPeakBuffer[i + 1].get();
-            this->lRmsBuffer[i] = this->lRmsBuffer[i + 1].get();
-            this->rRmsBuffer[i] = this->rRmsBuffer[i + 1].get();
-        }
-
-        const int i = WAVEFORM_METER_BUFFER_SIZE - 1;
-
-        // Push next values:
-        this->lPeakBuffer[i] = this->audioMonitor->getPeak(0);
-        this->rPeakBuffer[i] = this->audioMonitor->getPeak(1);
-        this->lRmsBuffer[i] = this->audioMonitor->getRootMeanSquare(0);
-        this->rRmsBuffer[i] = this->audioMonitor->getRootMeanSquare(1);
+    const int i = WAVEFORM_METER_BUFFER_SIZE - 1;
 
-        this->triggerAsyncUpdate();
+    // Push next values:
+    this->lPeakBuffer[i] = this->audioMonitor->getPeak(0);
+    this->rPeakBuffer[i] = this->audioMonitor->getPeak(1);
+    this->lRmsBuffer[i] = this->audioMonitor->getRootMeanSquare(0);
+    this->rRmsBuffer[i] = this->audioMonitor->getRootMeanSquare(1);
 
-        const double a = Time::getMillisecondCounterHiRes();
-        this->skewTime = int(a - b);
-    }
-}
-
-void WaveformAudioMonitorComponent::handleAsyncUpdate()
-{
     this->repaint();
 }
 
@@ -114,8 +109,8 @@ void WaveformAudioMonitorComponent::paint(Graphics &g)
 
     for (int i = 0; i < WAVEFORM_METER_BUFFER_SIZE; ++i)
     {
-        const float peakL = iecLevel(this->lPeakBuffer[i].get()) * midH;
-        const float peakR = iecLevel(this->rPeakBuffer[i].get()) * midH;
+        const float peakL = iecLevel(this->lPeakBuffer[i]) * midH;
+        const float peakR = iecLevel(this->rPeakBuffer[i]) * midH;
         g.drawVerticalLine(1 + i * 2, midH - peakL, midH + peakR);
     }
 
@@ -123,8 +118,8 @@ void WaveformAudioMonitorComponent::paint(Graphics &g)
 
     for (int i = 0; i < WAVEFORM_METER_BUFFER_SIZE; ++i)
     {
-        const float rmsL = iecLevel(this->lRmsBuffer[i].get()) * midH;
-        const float rmsR = iecLevel(this->rRmsBuffer[i].get()) * midH;
+        const float rmsL = iecLevel(this->lRmsBuffer[i]) * midH;
+        const float rmsR = iecLevel(this->rRmsBuffer[i]) * midH;
         g.drawVerticalLine(i * 2, midH - rmsL, midH + rmsR);
     }
 }
@@ -17,15 +17,14 @@
 
 #pragma once
 
-class AudioMonitor;
-
+#include "AudioMonitor.h"
 #include "SequencerLayout.h"
 
 // Set this depending on component width (or sidebar width):
 #define WAVEFORM_METER_BUFFER_SIZE (SEQUENCER_SIDEBAR_WIDTH / 2)
 
 class WaveformAudioMonitorComponent :
-    public Component, private Thread, private AsyncUpdater
+    public Component, private AudioMonitor::AnalysisListener
 {
 public:
 
@@ -42,18 +41,15 @@ public:
 
 private:
 
-    void run() override;
-    void handleAsyncUpdate() override;
+    void onAnalysisUpdated() override;
     
     WeakReference<AudioMonitor> audioMonitor;
     
-    Atomic<float> lPeakBuffer[WAVEFORM_METER_BUFFER_SIZE];
-    Atomic<float> rPeakBuffer[WAVEFORM_METER_BUFFER_SIZE];
-
-    Atomic<float> lRmsBuffer[WAVEFORM_METER_BUFFER_SIZE];
-    Atomic<float> rRmsBuffer[WAVEFORM_METER_BUFFER_SIZE];
+    float lPeakBuffer[WAVEFORM_METER_BUFFER_SIZE];
+    float rPeakBuffer[WAVEFORM_METER_BUFFER_SIZE];
 
-    int skewTime;
+    float lRmsBuffer[WAVEFORM_METER_BUFFER_SIZE];
+    float rRmsBuffer[WAVEFORM_METER_BUFFER_SIZE];
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformAudioMonitorComponent)
 
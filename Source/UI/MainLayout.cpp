@@ -38,6 +38,189 @@
 #include "CommandIDs.h"
 #include "Workspace.h"
 #include "App.h"
+#include "DocumentHelpers.h"
+#include "Profiler.h"
+#include "HybridRoll.h"
+
+#define PROFILER_OVERLAY_FRAME_MS 16
+#define PROFILER_OVERLAY_REPAINT_FRAMES 15
+#define PROFILER_OVERLAY_WIDTH 480
+#define PROFILER_OVERLAY_LINE_HEIGHT 14
+#define PROFILER_OVERLAY_NAME_LENGTH 44
+
+static int countVisibleComponents(const Component *root)
+{
+    int numComponents = 1;
+    for (const auto child : root->getChildren())
+    {
+        if (child->isVisible())
+        {
+            numComponents += countVisibleComponents(child);
+        }
+    }
+
+    return numComponents;
+}
+
+static void addVisibleRollsStats(const Component *root, HybridRoll::FrameStats &stats)
+{
+    if (const auto *roll = dynamic_cast<const HybridRoll *>(root))
+    {
+        const auto &rollStats = roll->getFrameStats();
+        stats.numFramesRendered += rollStats.numFramesRendered;
+        stats.numRectsRequested += rollStats.numRectsRequested;
+        stats.numRectsMerged += rollStats.numRectsMerged;
+        stats.lastPaintTimeMs = jmax(stats.lastPaintTimeMs, rollStats.lastPaintTimeMs);
+        stats.totalPaintTimeMs += rollStats.totalPaintTimeMs;
+        stats.numPaints += rollStats.numPaints;
+    }
+
+    for (const auto child : root->getChildren())
+    {
+        if (child->isVisible())
+        {
+            addVisibleRollsStats(child, stats);
+        }
+    }
+}
+
+static String formatMs(double ms)
+{
+    return String(ms, 2).paddedLeft(' ', 8);
+}
+
+// A frame here is a timer tick, so when the message thread is stalled,
+// both the frame time and the latency of a posted message grow
+class MainLayout::ProfilerOverlay final : public Component, private Timer, private AsyncUpdater
+{
+public:
+
+    ProfilerOverlay()
+    {
+        this->setInterceptsMouseClicks(false, false);
+        this->setPaintingIsUnclipped(true);
+        this->setSize(PROFILER_OVERLAY_WIDTH, PROFILER_OVERLAY_LINE_HEIGHT * 4);
+
+        Profiler::getInstance().setCollectingStats(true);
+        this->lastFrameStartMs = Time::getMillisecondCounterHiRes();
+        this->lastRepaintMs = this->lastFrameStartMs;
+        this->startTimer(PROFILER_OVERLAY_FRAME_MS);
+    }
+
+    ~ProfilerOverlay() override
+    {
+        this->stopTimer();
+        this->cancelPendingUpdate();
+        Profiler::getInstance().setCollectingStats(false);
+    }
+
+    void paint(Graphics &g) override
+    {
+        g.fillAll(Colours::black.withAlpha(0.75f));
+        g.setColour(Colours::white.withAlpha(0.85f));
+        g.setFont(Font(Font::getDefaultMonospacedFontName(), 12.f, Font::plain));
+
+        const int w = this->getWidth() - 8;
+        int y = 2;
+
+        g.drawText("frame" + formatMs(this->frameMs) + " ms, max" + formatMs(this->maxFrameMs) +
+            " ms, latency" + formatMs(this->latencyMs) + " ms, components " + String(this->numComponents) +
+            (Profiler::getInstance().isTracing() ? ", tracing" : ""),
+            4, y, w, PROFILER_OVERLAY_LINE_HEIGHT, Justification::centredLeft, false);
+
+        // the rolls' own frames, which are not the same as the overlay's ones
+        const double avgPaintMs = (this->rollStats.numPaints == 0) ? 0.0 :
+            this->rollStats.totalPaintTimeMs / this->rollStats.numPaints;
+
+        y += PROFILER_OVERLAY_LINE_HEIGHT;
+        g.drawText("roll frames " + String(this->rollStats.numFramesRendered) +
+            ", rects " + String(this->rollStats.numRectsMerged) + "/" +
+            String(this->rollStats.numRectsRequested) + " merged, paint" +
+            formatMs(this->rollStats.lastPaintTimeMs) + formatMs(avgPaintMs) + " ms",
+            4, y, w, PROFILER_OVERLAY_LINE_HEIGHT, Justification::centredLeft, false);
+
+        y += PROFILER_OVERLAY_LINE_HEIGHT;
+        g.drawText(String("section").paddedRight(' ', PROFILER_OVERLAY_NAME_LENGTH) +
+            "calls    last     avg     p95     max",
+            4, y, w, PROFILER_OVERLAY_LINE_HEIGHT, Justification::centredLeft, false);
+
+        for (const auto &section : this->sections)
+        {
+            y += PROFILER_OVERLAY_LINE_HEIGHT;
+            g.drawText(String(section.name).paddedRight(' ', PROFILER_OVERLAY_NAME_LENGTH) +
+                String(section.lastFrameCalls).paddedLeft(' ', 5) +
+                formatMs(section.lastFrameMs) +
+                formatMs(section.getAverageFrameMs()) +
+                formatMs(section.getPercentileMs(0.95f)) +
+                formatMs(section.maxFrameMs),
+                4, y, w, PROFILER_OVERLAY_LINE_HEIGHT, Justification::centredLeft, false);
+        }
+    }
+
+private:
+
+    void timerCallback() override
+    {
+        const double now = Time::getMillisecondCounterHiRes();
+        this->maxFrameMsSinceRepaint = jmax(this->maxFrameMsSinceRepaint, now - this->lastFrameStartMs);
+        this->lastFrameStartMs = now;
+
+        Profiler::getInstance().closeFrame();
+
+        if (! this->isUpdatePending())
+        {
+            this->latencyProbeStartMs = now;
+            this->triggerAsyncUpdate();
+        }
+
+        // the numbers are hard to read when updated each frame
+        if (++this->numFramesSinceRepaint < PROFILER_OVERLAY_REPAINT_FRAMES)
+        {
+            return;
+        }
+
+        this->frameMs = (now - this->lastRepaintMs) / this->numFramesSinceRepaint;
+        this->maxFrameMs = this->maxFrameMsSinceRepaint;
+        this->maxFrameMsSinceRepaint = 0.0;
+        this->numFramesSinceRepaint = 0;
+        this->lastRepaintMs = now;
+
+        this->sections = Profiler::getInstance().getSections();
+
+        if (const auto *parent = this->getParentComponent())
+        {
+            this->numComponents = countVisibleComponents(parent);
+            this->rollStats = {};
+            addVisibleRollsStats(parent, this->rollStats);
+        }
+
+        this->setSize(this->getWidth(),
+            PROFILER_OVERLAY_LINE_HEIGHT * (this->sections.size() + 3) + 4);
+
+        this->repaint();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        this->latencyMs = Time::getMillisecondCounterHiRes() - this->latencyProbeStartMs;
+    }
+
+    Array<Profiler::Section> sections;
+
+    double lastFrameStartMs = 0.0;
+    double lastRepaintMs = 0.0;
+    double maxFrameMsSinceRepaint = 0.0;
+    int numFramesSinceRepaint = 0;
+
+    double frameMs = 0.0;
+    double maxFrameMs = 0.0;
+    double latencyProbeStartMs = 0.0;
+    double latencyMs = 0.0;
+    int numComponents = 0;
+    HybridRoll::FrameStats rollStats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProfilerOverlay)
+};
 
 MainLayout::MainLayout() :
     currentContent(nullptr)
@@ -83,6 +266,7 @@ MainLayout::MainLayout() :
 
 MainLayout::~MainLayout()
 {
+    this->profilerOverlay = nullptr;
     this->removeAllChildren();
     this->hotkeyScheme = nullptr;
     this->headline = nullptr;
@@ -229,6 +413,11 @@ void MainLayout::resized()
     {
         this->currentContent->setBounds(r);
     }
+
+    if (this->profilerOverlay != nullptr)
+    {
+        this->profilerOverlay->setTopRightPosition(r.getRight(), r.getY());
+    }
 }
 
 void MainLayout::lookAndFeelChanged()
@@ -256,6 +445,22 @@ bool MainLayout::keyPressed(const KeyPress &key)
         return true;
     }
 
+#if HELIO_PROFILING
+
+    if (key == KeyPress::createFromDescription("command + shift + p"))
+    {
+        this->toggleProfilerOverlay();
+        return true;
+    }
+
+    if (key == KeyPress::createFromDescription("command + shift + t"))
+    {
+        this->toggleProfilerTracing();
+        return true;
+    }
+
+#endif
+
 #if JUCE_ENABLE_LIVE_CONSTANT_EDITOR
 
     if (key == KeyPress::createFromDescription("command + r"))
@@ -316,6 +521,45 @@ void MainLayout::handleCommandMessage(int commandId)
     }
 }
 
+void MainLayout::toggleProfilerOverlay()
+{
+    if (this->profilerOverlay != nullptr)
+    {
+        this->profilerOverlay = nullptr;
+        return;
+    }
+
+    this->profilerOverlay = new ProfilerOverlay();
+    this->addAndMakeVisible(this->profilerOverlay);
+    this->profilerOverlay->setAlwaysOnTop(true);
+    this->resized();
+}
+
+void MainLayout::toggleProfilerTracing()
+{
+    auto &profiler = Profiler::getInstance();
+    if (! profiler.isTracing())
+    {
+        profiler.startTracing();
+        this->showTooltip("Recording the trace");
+        return;
+    }
+
+    profiler.stopTracing();
+
+    const String fileName("Trace " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + ".json");
+    const File file(DocumentHelpers::getDocumentSlot(fileName));
+    if (profiler.exportTrace(file))
+    {
+        Logger::writeToLog("Trace saved: " + file.getFullPathName());
+        this->showTooltip("Trace saved: " + file.getFullPathName());
+    }
+    else
+    {
+        this->showTooltip("Failed to save the trace");
+    }
+}
+
 static void broadcastMessage(Component *root, int commandId)
 {
     if (root->isEnabled() && root->isShowing() &&
@@ -86,6 +86,13 @@ private:
     ScopedPointer<TooltipContainer> tooltipContainer;
     
     HotkeyScheme::Ptr hotkeyScheme;
+
+    // Debug tools: frame stats overlay and trace recording
+    void toggleProfilerOverlay();
+    void toggleProfilerTracing();
+
+    class ProfilerOverlay;
+    ScopedPointer<ProfilerOverlay> profilerOverlay;
     
 private:
 
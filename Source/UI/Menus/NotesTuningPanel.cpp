@@ -29,6 +29,7 @@
 #include "MidiSequence.h"
 #include "NoteComponent.h"
 #include "ProjectTreeItem.h"
+#include "UndoStack.h"
 #include "Transport.h"
 #include "CommandIDs.h"
 #include "MenuItemComponent.h"
@@ -446,12 +447,14 @@ void NotesTuningPanel::startTuning()
 {
     Lasso &selection = this->roll.getLassoSelection();
     SequencerOperations::startTuning(selection);
+    this->tuningCoalescing = new ScopedUndoCoalescing(this->project.getUndoStack());
 }
 
 void NotesTuningPanel::endTuning()
 {
     Lasso &selection = this->roll.getLassoSelection();
     SequencerOperations::endTuning(selection);
+    this->tuningCoalescing = nullptr;
 }
 
 //===----------------------------------------------------------------------===//
@@ -24,6 +24,7 @@ class PianoRoll;
 class ProjectTreeItem;
 class NotesTuningDiagram;
 class MenuItemComponent;
+class ScopedUndoCoalescing;
 //[/Headers]
 
 #include "../Themes/PanelBackgroundC.h"
@@ -80,6 +81,9 @@ private:
     void startTuning();
     void endTuning();
 
+    // All the intermediate volume changes of a slider drag end up in a single undo action
+    ScopedPointer<ScopedUndoCoalescing> tuningCoalescing;
+
 
     //===----------------------------------------------------------------------===//
     // TransportListener
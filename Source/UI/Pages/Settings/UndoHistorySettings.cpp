@@ -0,0 +1,179 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//[Headers]
+#include "Common.h"
+//[/Headers]
+
+#include "UndoHistorySettings.h"
+
+//[MiscUserDefs]
+#include "UndoStack.h"
+
+#define SHORT_UNDO_HISTORY 10
+#define MEDIUM_UNDO_HISTORY 100
+#define LONG_UNDO_HISTORY 1000
+//[/MiscUserDefs]
+
+UndoHistorySettings::UndoHistorySettings()
+{
+    addAndMakeVisible (shortHistoryButton = new ToggleButton (String()));
+    shortHistoryButton->setButtonText (TRANS("settings::history::short"));
+    shortHistoryButton->setRadioGroupId (1);
+    shortHistoryButton->addListener (this);
+    shortHistoryButton->setToggleState (true, dontSendNotification);
+    shortHistoryButton->setColour (ToggleButton::textColourId, Colour (0xbcffffff));
+
+    addAndMakeVisible (mediumHistoryButton = new ToggleButton (String()));
+    mediumHistoryButton->setButtonText (TRANS("settings::history::medium"));
+    mediumHistoryButton->setRadioGroupId (1);
+    mediumHistoryButton->addListener (this);
+    mediumHistoryButton->setColour (ToggleButton::textColourId, Colour (0xbcffffff));
+
+    addAndMakeVisible (longHistoryButton = new ToggleButton (String()));
+    longHistoryButton->setButtonText (TRANS("settings::history::long"));
+    longHistoryButton->setRadioGroupId (1);
+    longHistoryButton->addListener (this);
+    longHistoryButton->setColour (ToggleButton::textColourId, Colour (0xbcffffff));
+
+
+    //[UserPreSize]
+    //[/UserPreSize]
+
+    setSize (600, 96);
+
+    //[Constructor]
+    //[/Constructor]
+}
+
+UndoHistorySettings::~UndoHistorySettings()
+{
+    //[Destructor_pre]
+    //[/Destructor_pre]
+
+    shortHistoryButton = nullptr;
+    mediumHistoryButton = nullptr;
+    longHistoryButton = nullptr;
+
+    //[Destructor]
+    //[/Destructor]
+}
+
+void UndoHistorySettings::paint (Graphics& g)
+{
+    //[UserPrePaint] Add your own custom painting code here..
+    //[/UserPrePaint]
+
+    //[UserPaint] Add your own custom painting code here..
+    //[/UserPaint]
+}
+
+void UndoHistorySettings::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    shortHistoryButton->setBounds (8, (getHeight() / 2) + -32 - (32 / 2), getWidth() - 16, 32);
+    mediumHistoryButton->setBounds (8, (getHeight() / 2) - (32 / 2), getWidth() - 16, 32);
+    longHistoryButton->setBounds (8, (getHeight() / 2) + 32 - (32 / 2), getWidth() - 16, 32);
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+void UndoHistorySettings::buttonClicked (Button* buttonThatWasClicked)
+{
+    //[UserbuttonClicked_Pre]
+    //[/UserbuttonClicked_Pre]
+
+    if (buttonThatWasClicked == shortHistoryButton)
+    {
+        //[UserButtonCode_shortHistoryButton] -- add your button handler code here..
+        UndoStack::setNumTransactionsToStore(SHORT_UNDO_HISTORY);
+        this->updateButtons();
+        //[/UserButtonCode_shortHistoryButton]
+    }
+    else if (buttonThatWasClicked == mediumHistoryButton)
+    {
+        //[UserButtonCode_mediumHistoryButton] -- add your button handler code here..
+        UndoStack::setNumTransactionsToStore(MEDIUM_UNDO_HISTORY);
+        this->updateButtons();
+        //[/UserButtonCode_mediumHistoryButton]
+    }
+    else if (buttonThatWasClicked == longHistoryButton)
+    {
+        //[UserButtonCode_longHistoryButton] -- add your button handler code here..
+        UndoStack::setNumTransactionsToStore(LONG_UNDO_HISTORY);
+        this->updateButtons();
+        //[/UserButtonCode_longHistoryButton]
+    }
+
+    //[UserbuttonClicked_Post]
+    //[/UserbuttonClicked_Post]
+}
+
+void UndoHistorySettings::visibilityChanged()
+{
+    //[UserCode_visibilityChanged] -- Add your code here...
+    if (this->isVisible())
+    {
+        this->updateButtons();
+    }
+    //[/UserCode_visibilityChanged]
+}
+
+
+//[MiscUserCode]
+void UndoHistorySettings::updateButtons()
+{
+    // the values set elsewhere are shown as the nearest option
+    const int numTransactions = UndoStack::getNumTransactionsToStore();
+    this->shortHistoryButton->setToggleState(numTransactions < MEDIUM_UNDO_HISTORY, dontSendNotification);
+    this->mediumHistoryButton->setToggleState(numTransactions >= MEDIUM_UNDO_HISTORY &&
+        numTransactions < LONG_UNDO_HISTORY, dontSendNotification);
+    this->longHistoryButton->setToggleState(numTransactions >= LONG_UNDO_HISTORY, dontSendNotification);
+}
+//[/MiscUserCode]
+
+#if 0
+/*
+BEGIN_JUCER_METADATA
+
+<JUCER_COMPONENT documentType="Component" className="UndoHistorySettings" template="../../Template"
+                 componentName="" parentClasses="public Component" constructorParams=""
+                 variableInitialisers="" snapPixels="8" snapActive="1" snapShown="1"
+                 overlayOpacity="0.330" fixedSize="1" initialWidth="600" initialHeight="96">
+  <METHODS>
+    <METHOD name="visibilityChanged()"/>
+  </METHODS>
+  <BACKGROUND backgroundColour="4d4d4d"/>
+  <TOGGLEBUTTON name="" id="5b2e0c1f7a3d9e42" memberName="shortHistoryButton"
+                virtualName="" explicitFocusOrder="0" pos="8 -32Cc 16M 32" txtcol="bcffffff"
+                buttonText="settings::history::short" connectedEdges="0" needsCallback="1"
+                radioGroupId="1" state="1"/>
+  <TOGGLEBUTTON name="" id="c81d4a6e2f0b7395" memberName="mediumHistoryButton"
+                virtualName="" explicitFocusOrder="0" pos="8 0Cc 16M 32" txtcol="bcffffff"
+                buttonText="settings::history::medium" connectedEdges="0" needsCallback="1"
+                radioGroupId="1" state="0"/>
+  <TOGGLEBUTTON name="" id="9f3a7b2d5e1c8064" memberName="longHistoryButton"
+                virtualName="" explicitFocusOrder="0" pos="8 32Cc 16M 32" txtcol="bcffffff"
+                buttonText="settings::history::long" connectedEdges="0" needsCallback="1"
+                radioGroupId="1" state="0"/>
+</JUCER_COMPONENT>
+
+END_JUCER_METADATA
+*/
+#endif
@@ -25,6 +25,9 @@
 #include "RevisionItemComponent.h"
 #include "RevisionItem.h"
 #include "Delta.h"
+#include "ProgressTooltip.h"
+#include "MainLayout.h"
+#include "App.h"
 
 #if HELIO_DESKTOP
 #    define REVISION_TOOLTIP_ROWS_ONSCREEN (4.5)
@@ -127,7 +130,20 @@ void RevisionTooltipComponent::buttonClicked (Button* buttonThatWasClicked)
     if (buttonThatWasClicked == checkoutRevisionButton)
     {
         //[UserButtonCode_checkoutRevisionButton] -- add your button handler code here..
-        this->vcs.checkout(this->revision);
+        auto progress = new ProgressTooltip();
+        Component::SafePointer<Component> progressPointer(progress);
+        VersionControl &versionControl = this->vcs;
+        progress->onCancel = [&versionControl]() { versionControl.cancelCheckout(); };
+        App::Layout().showModalComponentUnowned(progress);
+
+        this->vcs.checkout(this->revision, [progressPointer](bool)
+        {
+            if (progressPointer != nullptr)
+            {
+                delete progressPointer.getComponent();
+            }
+        });
+
         this->hide();
         //[/UserButtonCode_checkoutRevisionButton]
     }
@@ -36,7 +36,6 @@
 #include "ComponentIDs.h"
 #include "CommandIDs.h"
 #include "App.h"
-#include "FailTooltip.h"
 
 using namespace VCS;
 
@@ -183,11 +182,22 @@ void StageComponent::changeListenerCallback(ChangeBroadcaster *source)
     {
         if (head->isRebuildingDiff())
         {
-            this->startProgressAnimation();
-            this->clearList();
+            // first message means the rebuild has started,
+            // the next ones are partial results as they come
+            if (! this->isShowingPartialDiff)
+            {
+                this->isShowingPartialDiff = true;
+                this->startProgressAnimation();
+                this->clearList();
+            }
+            else
+            {
+                this->updateList();
+            }
         }
         else
         {
+            this->isShowingPartialDiff = false;
             this->stopProgressAnimation();
             this->updateList();
         }
@@ -325,7 +335,7 @@ void StageComponent::toggleQuickStash()
     // 1 - has no quick stash, and has changes - clearly can toggle off, display toggle on button
     // 2 - has quick stash, and no changes - clearly can toggle on, display toggle off button
     // 3 - has no quick stash, and has no changes - don't display toggle button
-    // 4 - has quick stash, but also has changes - ? display toggle off button, show alert on press ?
+    // 4 - has quick stash, but also has changes - display toggle off button, merge the changes on press
 
     const bool case1 = !this->vcs.hasQuickStash() && this->vcs.getHead().hasAnythingOnTheStage();
     const bool case2 = this->vcs.hasQuickStash() && !this->vcs.getHead().hasAnythingOnTheStage();
@@ -336,15 +346,15 @@ void StageComponent::toggleQuickStash()
     {
         this->vcs.quickStashAll();
     }
-    else if (case2)
+    else if (case2 || case4)
     {
-        this->vcs.applyQuickStash();
-        //this->vcs.getHead().rebuildDiffSynchronously();
-    }
-    else if (case4)
-    {
-        App::Layout().showTooltip(TRANS("vcs::warning::cannotrevert"));
-        App::Layout().showModalComponentUnowned(new FailTooltip());
+        StringArray conflicts;
+        this->vcs.applyQuickStash(conflicts);
+
+        if (! conflicts.isEmpty())
+        {
+            App::Layout().showTooltip(TRANS("vcs::warning::conflicts") + conflicts.joinIntoString(", "));
+        }
     }
 }
 
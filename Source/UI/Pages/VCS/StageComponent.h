@@ -88,6 +88,7 @@ private:
     String lastCommitMessage;
 
     ComponentFader fader;
+    bool isShowingPartialDiff = false;
     void startProgressAnimation();
     void stopProgressAnimation();
 
@@ -34,6 +34,7 @@ ProgressTooltip::ProgressTooltip()
     //[UserPreSize]
     this->setComponentID(ComponentIDs::progressTooltipId);
     this->progressIndicator->startAnimating();
+    this->setWantsKeyboardFocus(true);
     //[/UserPreSize]
 
     setSize (96, 96);
@@ -84,8 +85,38 @@ void ProgressTooltip::parentHierarchyChanged()
     //[/UserCode_parentHierarchyChanged]
 }
 
+bool ProgressTooltip::keyPressed (const KeyPress& key)
+{
+    //[UserCode_keyPressed] -- Add your code here...
+    if (key.isKeyCode(KeyPress::escapeKey) && this->onCancel != nullptr)
+    {
+        this->cancel();
+        return true;
+    }
+
+    return false;  // Return true if your handler uses this key event, or false to allow it to be passed-on.
+    //[/UserCode_keyPressed]
+}
+
+void ProgressTooltip::inputAttemptWhenModal()
+{
+    //[UserCode_inputAttemptWhenModal] -- Add your code here...
+    if (this->onCancel != nullptr)
+    {
+        this->cancel();
+    }
+    //[/UserCode_inputAttemptWhenModal]
+}
+
 
 //[MiscUserCode]
+void ProgressTooltip::cancel()
+{
+    // the callback is likely to delete this tooltip
+    const auto callback = this->onCancel;
+    this->onCancel = nullptr;
+    callback();
+}
 //[/MiscUserCode]
 
 #if 0
@@ -99,6 +130,8 @@ BEGIN_JUCER_METADATA
                  initialHeight="96">
   <METHODS>
     <METHOD name="parentHierarchyChanged()"/>
+    <METHOD name="keyPressed (const KeyPress&amp; key)"/>
+    <METHOD name="inputAttemptWhenModal()"/>
   </METHODS>
   <BACKGROUND backgroundColour="0">
     <ROUNDRECT pos="0Cc 0Cc 96 96" cornerSize="15" fill="solid: a0000000" hasStroke="0"/>
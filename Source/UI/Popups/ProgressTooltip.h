@@ -32,16 +32,21 @@ public:
     ~ProgressTooltip();
 
     //[UserMethods]
+    // if set, escape key or a click outside cancels the operation
+    Function<void()> onCancel;
     //[/UserMethods]
 
     void paint (Graphics& g) override;
     void resized() override;
     void parentHierarchyChanged() override;
+    bool keyPressed (const KeyPress& key) override;
+    void inputAttemptWhenModal() override;
 
 
 private:
 
     //[UserVariables]
+    void cancel();
     //[/UserVariables]
 
     ScopedPointer<ProgressIndicator> progressIndicator;
@@ -40,7 +40,9 @@ HybridRollHeader::HybridRollHeader(Transport &transportRef, HybridRoll &rollRef,
     transport(transportRef),
     roll(rollRef),
     viewport(viewportRef),
-    soundProbeMode(false)
+    soundProbeMode(false),
+    pointingIndicatorAnchor(0.0),
+    selectionIndicatorAnchor(0.0)
 {
     this->setAlwaysOnTop(true);
     this->setOpaque(true);
@@ -102,6 +104,54 @@ void HybridRollHeader::updateIndicatorPosition(SoundProbeIndicator *indicator, c
     indicator->setAnchoredAt(this->getAlignedAnchorForEvent(e));
 }
 
+void HybridRollHeader::updateIndicators()
+{
+    if (this->selectionIndicator != nullptr)
+    {
+        this->selectionIndicator->setEndAnchor(this->selectionIndicatorAnchor);
+    }
+
+    if (this->pointingIndicator == nullptr)
+    {
+        return;
+    }
+
+    this->pointingIndicator->setAnchoredAt(this->pointingIndicatorAnchor);
+
+    if (this->playingIndicator != nullptr)
+    {
+        const int distance = abs(this->pointingIndicator->getX() - this->playingIndicator->getX());
+
+        if (this->timeDistanceIndicator == nullptr)
+        {
+            //Logger::writeToLog("HybridRollHeader::initTimeDistanceIndicatorIfPossible " + String(distance));
+
+            // todo rebuild sequences if not playing, do nothing if playing
+            this->transport.stopPlayback();
+
+            if (distance > MIN_TIME_DISTANCE_INDICATOR_SIZE)
+            {
+                this->timeDistanceIndicator = new TimeDistanceIndicator();
+                this->roll.addAndMakeVisible(this->timeDistanceIndicator);
+                this->timeDistanceIndicator->setBounds(0, this->getBottom() + 4,
+                                                       0, this->timeDistanceIndicator->getHeight());
+                this->updateTimeDistanceIndicator();
+            }
+        }
+        else
+        {
+            if (distance <= MIN_TIME_DISTANCE_INDICATOR_SIZE)
+            {
+                this->timeDistanceIndicator = nullptr;
+            }
+            else
+            {
+                this->updateTimeDistanceIndicator();
+            }
+        }
+    }
+}
+
 double HybridRollHeader::getUnalignedAnchorForEvent(const MouseEvent &e) const
 {
     const MouseEvent parentEvent = e.getEventRelativeTo(&this->roll);
@@ -233,10 +283,11 @@ void HybridRollHeader::mouseDown(const MouseEvent &e)
                                                 0, this->selectionIndicator->getHeight());
             
 #if HYBRID_ROLL_HEADER_SELECTION_ALIGNS_TO_BEATS
-            this->selectionIndicator->setStartAnchor(this->getAlignedAnchorForEvent(e));
+            this->selectionIndicatorAnchor = this->getAlignedAnchorForEvent(e);
 #else
-            this->selectionIndicator->setStartAnchor(this->getUnalignedAnchorForEvent(e));
+            this->selectionIndicatorAnchor = this->getUnalignedAnchorForEvent(e);
 #endif
+            this->selectionIndicator->setStartAnchor(this->selectionIndicatorAnchor);
         }
         else
         {
@@ -253,40 +304,8 @@ void HybridRollHeader::mouseDrag(const MouseEvent &e)
     {
         if (this->pointingIndicator != nullptr)
         {
-            this->updateIndicatorPosition(this->pointingIndicator, e);
-
-            if (this->playingIndicator != nullptr)
-            {
-                const int distance = abs(this->pointingIndicator->getX() - this->playingIndicator->getX());
-
-                if (this->timeDistanceIndicator == nullptr)
-                {
-                    //Logger::writeToLog("HybridRollHeader::initTimeDistanceIndicatorIfPossible " + String(distance));
-                    
-                    // todo rebuild sequences if not playing, do nothing if playing
-                    this->transport.stopPlayback();
-                    
-                    if (distance > MIN_TIME_DISTANCE_INDICATOR_SIZE)
-                    {
-                        this->timeDistanceIndicator = new TimeDistanceIndicator();
-                        this->roll.addAndMakeVisible(this->timeDistanceIndicator);
-                        this->timeDistanceIndicator->setBounds(0, this->getBottom() + 4,
-                                                               0, this->timeDistanceIndicator->getHeight());
-                        this->updateTimeDistanceIndicator();
-                    }
-                }
-                else
-                {
-                    if (distance <= MIN_TIME_DISTANCE_INDICATOR_SIZE)
-                    {
-                        this->timeDistanceIndicator = nullptr;
-                    }
-                    else
-                    {
-                        this->updateTimeDistanceIndicator();
-                    }
-                }
-            }
+            this->pointingIndicatorAnchor = this->getAlignedAnchorForEvent(e);
+            this->roll.updateHeaderOnNextFrame();
         }
     }
     else
@@ -308,10 +327,11 @@ void HybridRollHeader::mouseDrag(const MouseEvent &e)
             if (this->selectionIndicator != nullptr)
             {
 #if HYBRID_ROLL_HEADER_SELECTION_ALIGNS_TO_BEATS
-                this->selectionIndicator->setEndAnchor(this->getAlignedAnchorForEvent(e));
+                this->selectionIndicatorAnchor = this->getAlignedAnchorForEvent(e);
 #else
-                this->selectionIndicator->setEndAnchor(this->getUnalignedAnchorForEvent(e));
+                this->selectionIndicatorAnchor = this->getUnalignedAnchorForEvent(e);
 #endif
+                this->roll.updateHeaderOnNextFrame();
             }
         }
         else
@@ -377,7 +397,8 @@ void HybridRollHeader::mouseMove(const MouseEvent &e)
 {
     if (this->pointingIndicator != nullptr)
     {
-        this->updateIndicatorPosition(this->pointingIndicator, e);
+        this->pointingIndicatorAnchor = this->getAlignedAnchorForEvent(e);
+        this->roll.updateHeaderOnNextFrame();
     }
     
     if (this->soundProbeMode)
@@ -386,7 +407,8 @@ void HybridRollHeader::mouseMove(const MouseEvent &e)
         {
             this->pointingIndicator = new SoundProbeIndicator();
             this->roll.addAndMakeVisible(this->pointingIndicator);
-            this->updateIndicatorPosition(this->pointingIndicator, e);
+            this->pointingIndicatorAnchor = this->getAlignedAnchorForEvent(e);
+            this->pointingIndicator->setAnchoredAt(this->pointingIndicatorAnchor);
         }
     }
 }
@@ -33,6 +33,10 @@ public:
     void setSoundProbeMode(bool shouldProbeOnClick);
     void updateSubrangeIndicator(const Colour &colour, float firstBeat, float lastBeat);
 
+    // Mouse events only update the anchors, and the indicators
+    // are moved by the roll within its next frame
+    void updateIndicators();
+
     //===------------------------------------------------------------------===//
     // Component
     //===------------------------------------------------------------------===//
@@ -69,6 +73,9 @@ protected:
     ScopedPointer<TimeDistanceIndicator> timeDistanceIndicator;
     ScopedPointer<HeaderSelectionIndicator> selectionIndicator;
 
+    double pointingIndicatorAnchor;
+    double selectionIndicatorAnchor;
+
     void updateIndicatorPosition(SoundProbeIndicator *indicator, const MouseEvent &e);
     double getUnalignedAnchorForEvent(const MouseEvent &e) const;
     double getAlignedAnchorForEvent(const MouseEvent &e) const;
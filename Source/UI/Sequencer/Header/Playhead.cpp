@@ -215,12 +215,15 @@ void Playhead::parentChanged()
 void Playhead::updatePosition(double position)
 {
     const int &newX = this->roll.getXPositionByTransportPosition(position, double(this->getParentWidth()));
-    this->setTopLeftPosition(newX, 0);
 
     if (this->listener != nullptr)
     {
         this->listener->onPlayheadMoved(newX);
     }
+    else
+    {
+        this->setTopLeftPosition(newX, 0);
+    }
 }
 
 void Playhead::tick()
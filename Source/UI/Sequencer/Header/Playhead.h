@@ -35,6 +35,9 @@ public:
     {
     public:
         virtual ~Listener() {}
+
+        // The listener is the one to move the playhead, if any,
+        // so that it can be moved together with the view
         virtual void onPlayheadMoved(int indicatorX) = 0;
     };
 
@@ -70,6 +70,7 @@
 #include "AudioMonitor.h"
 
 #include "ColourIDs.h"
+#include "Profiler.h"
 
 #include <limits.h>
 
@@ -91,6 +92,188 @@ template class TimeSignaturesTrackMap<TimeSignatureLargeComponent>;
 #include "KeySignaturesTrackMap.cpp"
 template class KeySignaturesTrackMap<KeySignatureLargeComponent>;
 
+// Batches larger than that are repainted as a whole
+#define MAX_COMPONENTS_TO_REPAINT_SEPARATELY 64
+
+// Collects all update requests (batched components, dirty areas,
+// playhead movements) and lets the roll process them at most once per tick;
+// when nothing is requested, the timer is stopped
+class HybridRoll::FrameScheduler final : private Timer
+{
+public:
+
+    explicit FrameScheduler(HybridRoll &roll) : roll(roll) {}
+
+    void requestFrame()
+    {
+        this->hasPendingFrame = true;
+
+        // Was idle for at least a frame, so there's no need to wait
+        if (! this->isTimerRunning())
+        {
+            this->timerCallback();
+        }
+    }
+
+private:
+
+    void timerCallback() override
+    {
+        if (! this->hasPendingFrame)
+        {
+            this->stopTimer();
+            return;
+        }
+
+        this->hasPendingFrame = false;
+        this->roll.renderFrame();
+
+        if (! this->isTimerRunning())
+        {
+            this->startTimer(HYBRID_ROLL_FRAME_INTERVAL_MS);
+        }
+    }
+
+    HybridRoll &roll;
+    bool hasPendingFrame = false;
+
+    JUCE_DECLARE_NON_COPYABLE(FrameScheduler)
+};
+
+#define LASSO_INDEX_BEATS_PER_CELL (4.f)
+
+class HybridRoll::LassoIndex final
+{
+public:
+
+    LassoIndex() = default;
+
+    void add(MidiEventComponent *component, int row, float startBeat, float endBeat)
+    {
+        this->remove(component);
+
+        const Entry entry = { row, getCell(startBeat), jmax(getCell(startBeat), getCell(endBeat)) };
+        for (int cell = entry.firstCell; cell <= entry.lastCell; ++cell)
+        {
+            this->cells[getKey(row, cell)].add({ component, entry.firstCell });
+        }
+
+        this->entries[component] = entry;
+    }
+
+    void remove(MidiEventComponent *component)
+    {
+        const auto found = this->entries.find(component);
+        if (found == this->entries.end())
+        {
+            return;
+        }
+
+        const Entry entry = found->second;
+        for (int cell = entry.firstCell; cell <= entry.lastCell; ++cell)
+        {
+            const auto key = getKey(entry.row, cell);
+            auto &items = this->cells[key];
+            for (int i = 0; i < items.size(); ++i)
+            {
+                if (items.getReference(i).component == component)
+                {
+                    items.remove(i);
+                    break;
+                }
+            }
+
+            if (items.isEmpty())
+            {
+                this->cells.erase(key);
+            }
+        }
+
+        this->entries.erase(component);
+    }
+
+    void clear()
+    {
+        this->cells.clear();
+        this->entries.clear();
+    }
+
+    // Each component is only reported once, for the first cell
+    // where both the component and the lookup range overlap
+    void find(Array<MidiEventComponent *> &found,
+        int firstRow, int lastRow, float startBeat, float endBeat) const
+    {
+        const int firstCell = getCell(startBeat);
+        const int lastCell = jmax(firstCell, getCell(endBeat));
+        const int64 numCellsInRange = int64(lastRow - firstRow + 1) * int64(lastCell - firstCell + 1);
+
+        // The lookup area is huge, so it's faster to check all the entries
+        if (numCellsInRange > int64(this->entries.size()))
+        {
+            for (const auto &e : this->entries)
+            {
+                const Entry &entry = e.second;
+                if (entry.row >= firstRow && entry.row <= lastRow &&
+                    entry.lastCell >= firstCell && entry.firstCell <= lastCell)
+                {
+                    found.add(e.first);
+                }
+            }
+
+            return;
+        }
+
+        for (int row = firstRow; row <= lastRow; ++row)
+        {
+            for (int cell = firstCell; cell <= lastCell; ++cell)
+            {
+                const auto items = this->cells.find(getKey(row, cell));
+                if (items == this->cells.end())
+                {
+                    continue;
+                }
+
+                for (const auto &item : items->second)
+                {
+                    if (jmax(item.firstCell, firstCell) == cell)
+                    {
+                        found.add(item.component);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+
+    static int getCell(float beat) noexcept
+    {
+        return int(floorf(beat / LASSO_INDEX_BEATS_PER_CELL));
+    }
+
+    static int64 getKey(int row, int cell) noexcept
+    {
+        return (int64(row) << 32) | int64(uint32(cell));
+    }
+
+    struct Entry final
+    {
+        int row;
+        int firstCell;
+        int lastCell;
+    };
+
+    struct CellItem final
+    {
+        MidiEventComponent *component;
+        int firstCell;
+    };
+
+    SparseHashMap<int64, Array<CellItem>> cells;
+    SparseHashMap<MidiEventComponent *, Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE(LassoIndex)
+};
 
 HybridRoll::HybridRoll(ProjectTreeItem &parentProject, Viewport &viewportRef,
     WeakReference<AudioMonitor> audioMonitor,
@@ -117,6 +300,11 @@ HybridRoll::HybridRoll(ProjectTreeItem &parentProject, Viewport &viewportRef,
     lastTransportPosition(0.0),
     playheadOffset(0.0),
     shouldFollowPlayhead(false),
+    headerNeedsUpdate(false),
+    paintStartTicks(0),
+    rectsRequestedBeforeFrame(0),
+    pendingPlayheadX(-1),
+    lassoIndexIsOutdated(true),
     barLineColour(this->findColour(ColourIDs::Roll::barLine)),
     barLineBevelColour(this->findColour(ColourIDs::Roll::barLineBevel)),
     beatLineColour(this->findColour(ColourIDs::Roll::beatLine)),
@@ -131,6 +319,9 @@ HybridRoll::HybridRoll(ProjectTreeItem &parentProject, Viewport &viewportRef,
     this->setWantsKeyboardFocus(false);
     this->setFocusContainer(false);
 
+    // the playhead requests frames as soon as it's added
+    this->frameScheduler = new FrameScheduler(*this);
+
     this->topShadow = new LightShadowDownwards();
     this->bottomShadow = new LightShadowUpwards();
 
@@ -188,6 +379,7 @@ HybridRoll::HybridRoll(ProjectTreeItem &parentProject, Viewport &viewportRef,
 
     this->smoothPanController = new SmoothPanController(*this);
     this->smoothZoomController = new SmoothZoomController(*this);
+    this->lassoIndex = new LassoIndex();
     
     this->project.addListener(this);
     this->project.getEditMode().addChangeListener(this);
@@ -201,6 +393,9 @@ HybridRoll::HybridRoll(ProjectTreeItem &parentProject, Viewport &viewportRef,
 
 HybridRoll::~HybridRoll()
 {
+    this->renderer = nullptr;
+    this->frameScheduler = nullptr;
+
     if (this->clippingDetector != nullptr)
     {
         this->clippingDetector->removeClippingListener(this);
@@ -683,19 +878,269 @@ void HybridRoll::setBarWidth(const float newBarWidth)
 #define MIN_BAR_WIDTH 14
 #define MIN_BEAT_WIDTH 8
 
+// Adds the lines of a sorted cached array, which fall into a given range
+static void addCachedLines(const Array<float> &cache,
+    float startX, float endX, Array<float> &result)
+{
+    const int numLines = cache.size();
+    int s = 0, e = numLines;
+    while (s < e)
+    {
+        const int halfway = (s + e) / 2;
+        if (cache.getUnchecked(halfway) < startX)
+        { s = halfway + 1; }
+        else
+        { e = halfway; }
+    }
+
+    for (int i = s; i < numLines && cache.getUnchecked(i) <= endX; ++i)
+    {
+        result.add(cache.getUnchecked(i));
+    }
+}
+
+// Adds the lines of a freshly computed sorted array, which fall out of a given range
+static void addLinesOutside(const Array<float> &lines,
+    float cachedStartX, float cachedEndX, Array<float> &before, Array<float> &after)
+{
+    for (const auto &x : lines)
+    {
+        if (x < cachedStartX)
+        {
+            before.add(x);
+        }
+        else if (x > cachedEndX)
+        {
+            after.add(x);
+        }
+    }
+}
+
+static void mergeLines(Array<float> &cache, const Array<float> &before, const Array<float> &after)
+{
+    cache.insertArray(0, before.begin(), before.size());
+    cache.addArray(after);
+}
+
+// Removes the lines of a sorted cached array, which fall out of a given range
+static void trimCachedLines(Array<float> &cache, float startX, float endX)
+{
+    int numLinesBefore = 0;
+    while (numLinesBefore < cache.size() && cache.getUnchecked(numLinesBefore) < startX)
+    {
+        numLinesBefore++;
+    }
+
+    int numLinesAfter = 0;
+    while (numLinesAfter < cache.size() - numLinesBefore &&
+        cache.getUnchecked(cache.size() - 1 - numLinesAfter) > endX)
+    {
+        numLinesAfter++;
+    }
+
+    cache.removeRange(cache.size() - numLinesAfter, numLinesAfter);
+    cache.removeRange(0, numLinesBefore);
+}
+
 void HybridRoll::computeVisibleBeatLines()
 {
+    profileScope("HybridRoll::computeVisibleBeatLines");
+
+    const float viewStartX = float(this->viewport.getViewPositionX());
+    const float viewWidth = float(this->viewport.getViewWidth());
+    const float viewEndX = viewStartX + viewWidth;
+
+    // Some bars to the left are also included, as header relies on them
+    const float barsStartX = viewStartX - this->barWidth * 2.f;
+    const float linesEndX = viewEndX + this->barWidth;
+
+    // Computing the grid a screen further to each side,
+    // so that scrolling (e.g. following the playhead) hits the cache
+    // and the grid is only extended once per a screen scrolled
+    const float margin = viewWidth + this->barWidth * 2.f;
+
+    const int timeSignaturesRevision =
+        this->project.getTimeline()->getTimeSignatures()->getSequence()->getRevision();
+
+    const bool cacheIsStale = !this->gridCache.isValid ||
+        this->gridCache.barWidth != this->barWidth ||
+        this->gridCache.firstBar != this->firstBar ||
+        this->gridCache.timeSignaturesRevision != timeSignaturesRevision ||
+        linesEndX < this->gridCache.startX ||
+        barsStartX > this->gridCache.endX;
+
+    if (cacheIsStale)
+    {
+        this->gridCache.barWidth = this->barWidth;
+        this->gridCache.firstBar = this->firstBar;
+        this->gridCache.timeSignaturesRevision = timeSignaturesRevision;
+        this->rebuildGridCache(barsStartX - margin, linesEndX + margin);
+    }
+    else if (barsStartX < this->gridCache.startX || linesEndX > this->gridCache.endX)
+    {
+        // The view has scrolled partly out of the cached range:
+        // only the missing part is computed, and the lines too far away are dropped
+        this->extendGridCache(jmin(this->gridCache.startX, barsStartX - margin),
+            jmax(this->gridCache.endX, linesEndX + margin),
+            (linesEndX - barsStartX) + margin * 4.f);
+    }
+
     this->visibleBars.clearQuick();
     this->visibleBeats.clearQuick();
     this->visibleSnaps.clearQuick();
 
+    addCachedLines(this->gridCache.bars, barsStartX, linesEndX, this->visibleBars);
+    addCachedLines(this->gridCache.beats, viewStartX, linesEndX, this->visibleBeats);
+    addCachedLines(this->gridCache.snaps, viewStartX, linesEndX, this->visibleSnaps);
+}
+
+void HybridRoll::rebuildGridCache(float startX, float endX)
+{
+    this->gridCache.startX = startX;
+    this->gridCache.endX = endX;
+
+    this->gridCache.bars.clearQuick();
+    this->gridCache.beats.clearQuick();
+    this->gridCache.snaps.clearQuick();
+    this->gridCache.tiles.clear();
+
+    this->computeBeatLines(startX, endX,
+        this->gridCache.bars, this->gridCache.beats, this->gridCache.snaps);
+
+    this->gridCache.isValid = true;
+}
+
+void HybridRoll::extendGridCache(float startX, float endX, float maxWidth)
+{
+    Array<float> bars, beats, snaps;
+    Array<float> barsBefore, beatsBefore, snapsBefore;
+    Array<float> barsAfter, beatsAfter, snapsAfter;
+
+    const float cachedStartX = this->gridCache.startX;
+    const float cachedEndX = this->gridCache.endX;
+
+    if (startX < cachedStartX)
+    {
+        this->computeBeatLines(startX, cachedStartX, bars, beats, snaps);
+    }
+
+    if (endX > cachedEndX)
+    {
+        this->computeBeatLines(cachedEndX, endX, bars, beats, snaps);
+    }
+
+    // computeBeatLines may add some lines a bit outside the given range,
+    // so the ones that are already cached are filtered out here
+    addLinesOutside(bars, cachedStartX, cachedEndX, barsBefore, barsAfter);
+    addLinesOutside(beats, cachedStartX, cachedEndX, beatsBefore, beatsAfter);
+    addLinesOutside(snaps, cachedStartX, cachedEndX, snapsBefore, snapsAfter);
+
+    mergeLines(this->gridCache.bars, barsBefore, barsAfter);
+    mergeLines(this->gridCache.beats, beatsBefore, beatsAfter);
+    mergeLines(this->gridCache.snaps, snapsBefore, snapsAfter);
+
+    // When scrolling in one direction, the cache keeps a couple of screens
+    // behind the view, and the rest of it is dropped along with its tiles
+    if (endX - startX > maxWidth)
+    {
+        if (startX < cachedStartX)
+        {
+            endX = startX + maxWidth;
+        }
+        else
+        {
+            startX = endX - maxWidth;
+        }
+
+        trimCachedLines(this->gridCache.bars, startX, endX);
+        trimCachedLines(this->gridCache.beats, startX, endX);
+        trimCachedLines(this->gridCache.snaps, startX, endX);
+    }
+
+    this->gridCache.startX = startX;
+    this->gridCache.endX = endX;
+
+    Array<int> outdatedTiles;
+    for (const auto &tile : this->gridCache.tiles)
+    {
+        const float tileX = float(tile.first * HYBRID_ROLL_GRID_TILE_WIDTH);
+        if (tileX < startX || tileX + HYBRID_ROLL_GRID_TILE_WIDTH > endX)
+        {
+            outdatedTiles.add(tile.first);
+        }
+    }
+
+    for (const auto &tileIndex : outdatedTiles)
+    {
+        this->gridCache.tiles.erase(tileIndex);
+    }
+}
+
+void HybridRoll::invalidateGridCache() noexcept
+{
+    this->gridCache.isValid = false;
+}
+
+Image HybridRoll::renderGridTile(int tileIndex) const
+{
+    profileScope("HybridRoll::renderGridTile");
+
+    const int tileX = tileIndex * HYBRID_ROLL_GRID_TILE_WIDTH;
+    const float tileStartX = float(tileX);
+    const float tileEndX = float(tileX + HYBRID_ROLL_GRID_TILE_WIDTH);
+
+    // All lines of the same colour are submitted at once;
+    // the bar lines just before the tile still have their bevels in it
+    RectangleList<float> bars, bevels, beats, snaps;
+    Array<float> lines;
+
+    addCachedLines(this->gridCache.bars, tileStartX - 2.f, tileEndX, lines);
+    for (const auto &f : lines)
+    {
+        const float x = floorf(f);
+        bars.addWithoutMerging({ x, 0.f, 1.f, 1.f });
+        bevels.addWithoutMerging({ x + 1.f, 0.f, 1.f, 1.f });
+    }
+
+    lines.clearQuick();
+    addCachedLines(this->gridCache.beats, tileStartX - 1.f, tileEndX, lines);
+    for (const auto &f : lines)
+    {
+        beats.addWithoutMerging({ floorf(f), 0.f, 1.f, 1.f });
+    }
+
+    lines.clearQuick();
+    addCachedLines(this->gridCache.snaps, tileStartX - 1.f, tileEndX, lines);
+    for (const auto &f : lines)
+    {
+        snaps.addWithoutMerging({ floorf(f), 0.f, 1.f, 1.f });
+    }
+
+    Image tile(Image::ARGB, HYBRID_ROLL_GRID_TILE_WIDTH, 1, true);
+    Graphics g(tile);
+    g.setOrigin(-tileX, 0);
+
+    g.setColour(this->barLineColour);
+    g.fillRectList(bars);
+    g.setColour(this->barLineBevelColour);
+    g.fillRectList(bevels);
+    g.setColour(this->beatLineColour);
+    g.fillRectList(beats);
+    g.setColour(this->snapLineColour);
+    g.fillRectList(snaps);
+
+    return tile;
+}
+
+void HybridRoll::computeBeatLines(float rangeStartX, float rangeEndX,
+    Array<float> &bars, Array<float> &beats, Array<float> &snaps) const
+{
     const auto tsSequence =
         this->project.getTimeline()->getTimeSignatures()->getSequence();
     
     const float zeroCanvasOffset = this->firstBar * this->barWidth; // usually a negative value
-    const float viewPosX = float(this->viewport.getViewPositionX());
-    const float paintStartX = viewPosX + zeroCanvasOffset;
-    const float paintEndX = float(viewPosX + this->viewport.getViewWidth()) + zeroCanvasOffset;
+    const float paintStartX = rangeStartX + zeroCanvasOffset;
+    const float paintEndX = rangeEndX + zeroCanvasOffset;
     
     const float paintStartBar = roundf(paintStartX / this->barWidth) - 2.f;
     const float paintEndBar = roundf(paintEndX / this->barWidth) + 1.f;
@@ -709,31 +1154,37 @@ void HybridRoll::computeVisibleBeatLines()
     int numerator = TIME_SIGNATURE_DEFAULT_NUMERATOR;
     int denominator = TIME_SIGNATURE_DEFAULT_DENOMINATOR;
     float barIterator = float(this->firstBar);
-    int nextSignatureIdx = 0;
-    bool firstEvent = true;
 
-    // Find a time signature to start from (or use default values):
-    // find a first time signature after a paint start and take a previous one, if any
-    for (; nextSignatureIdx < tsSequence->size(); ++nextSignatureIdx)
+    // The very first event defines what's before it (both time signature and offset)
+    if (tsSequence->size() > 0)
     {
-        const auto signature =
-            static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(nextSignatureIdx));
+        const auto signature = static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(0));
+        numerator = signature->getNumerator();
+        denominator = signature->getDenominator();
+        const float beatStep = 1.f / float(denominator);
+        const float barStep = beatStep * float(numerator);
+        barIterator += fmodf(signature->getBeat() / BEATS_PER_BAR - float(this->firstBar), barStep) - barStep;
+    }
 
-        // The very first event defines what's before it (both time signature and offset)
-        if (firstEvent)
-        {
-            numerator = signature->getNumerator();
-            denominator = signature->getDenominator();
-            const float beatStep = 1.f / float(denominator);
-            const float barStep = beatStep * float(numerator);
-            barIterator += fmodf(signature->getBeat() / BEATS_PER_BAR - float(this->firstBar), barStep) - barStep;
-            firstEvent = false;
-        }
+    // Find a time signature to start from (or use default values):
+    // binary search for the first time signature after a paint start,
+    // and take a previous one, if any (the sequence is sorted by beat)
+    const float paintStartBeat = paintStartBar * BEATS_PER_BAR;
+    int nextSignatureIdx = 0;
+    int searchEnd = tsSequence->size();
+    while (nextSignatureIdx < searchEnd)
+    {
+        const int halfway = (nextSignatureIdx + searchEnd) / 2;
+        if (tsSequence->getUnchecked(halfway)->getBeat() < paintStartBeat)
+        { nextSignatureIdx = halfway + 1; }
+        else
+        { searchEnd = halfway; }
+    }
 
-        if (signature->getBeat() >= (paintStartBar * BEATS_PER_BAR))
-        {
-            break;
-        }
+    if (nextSignatureIdx > 0)
+    {
+        const auto signature =
+            static_cast<TimeSignatureEvent *>(tsSequence->getUnchecked(nextSignatureIdx - 1));
 
         numerator = signature->getNumerator();
         denominator = signature->getDenominator();
@@ -768,7 +1219,7 @@ void HybridRoll::computeVisibleBeatLines()
         {
             if (canDrawBarLine)
             {
-                visibleBars.add(barStartX);
+                bars.add(barStartX);
             }
 
             // Check if we have more time signatures to come
@@ -806,17 +1257,17 @@ void HybridRoll::computeVisibleBeatLines()
                     k < (nextBeatStartX - 1);
                     k += snapWidth)
                 {
-                    if (k >= viewPosX)
+                    if (k >= rangeStartX)
                     {
-                        visibleSnaps.add(k);
+                        snaps.add(k);
                     }
                 }
 
-                if (beatStartX >= viewPosX &&
+                if (beatStartX >= rangeStartX &&
                     j >= beatStep && // don't draw the first one as it is a bar line
                     (nextBeatStartX - beatStartX) > MIN_BEAT_WIDTH)
                 {
-                    visibleBeats.add(beatStartX);
+                    beats.add(beatStartX);
                 }
             }
         }
@@ -922,6 +1373,61 @@ SelectionComponent *HybridRoll::getSelectionComponent() const noexcept
     return this->lassoComponent;
 }
 
+//===----------------------------------------------------------------------===//
+// Lasso index
+//===----------------------------------------------------------------------===//
+
+void HybridRoll::invalidateLassoIndex() noexcept
+{
+    this->lassoIndexIsOutdated = true;
+}
+
+void HybridRoll::updateLassoIndexFor(MidiEventComponent *component,
+    int row, float startBeat, float endBeat)
+{
+    // Will be rebuilt from scratch anyway
+    if (!this->lassoIndexIsOutdated)
+    {
+        this->lassoIndex->add(component, row, startBeat, endBeat);
+    }
+}
+
+void HybridRoll::removeFromLassoIndex(MidiEventComponent *component)
+{
+    if (!this->lassoIndexIsOutdated)
+    {
+        this->lassoIndex->remove(component);
+    }
+}
+
+void HybridRoll::findLassoItemsInRows(Array<SelectableComponent *> &itemsFound,
+    const Rectangle<int> &area, int firstRow, int lastRow)
+{
+    if (this->lassoIndexIsOutdated)
+    {
+        this->lassoIndex->clear();
+        this->lassoIndexIsOutdated = false;
+        this->rebuildLassoIndex();
+    }
+
+    // A beat of margin around the area, the exact check is done by bounds
+    const float startBeat = this->getFirstBeat() +
+        float(area.getX()) * BEATS_PER_BAR / this->barWidth - 1.f;
+    const float endBeat = this->getFirstBeat() +
+        float(area.getRight()) * BEATS_PER_BAR / this->barWidth + 1.f;
+
+    Array<MidiEventComponent *> candidates;
+    this->lassoIndex->find(candidates, firstRow, lastRow, startBeat, endBeat);
+
+    for (auto *component : candidates)
+    {
+        if (component->isActive() && area.intersects(component->getBounds()))
+        {
+            itemsFound.add(component);
+        }
+    }
+}
+
 //===----------------------------------------------------------------------===//
 // ProjectListener
 //===----------------------------------------------------------------------===//
@@ -931,6 +1437,7 @@ void HybridRoll::onChangeMidiEvent(const MidiEvent &event, const MidiEvent &newE
     // Time signatures have changed, need to repaint
     if (event.isTypeOf(MidiEvent::TimeSignature))
     {
+        this->invalidateGridCache();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -940,6 +1447,7 @@ void HybridRoll::onAddMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::TimeSignature))
     {
+        this->invalidateGridCache();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -949,6 +1457,7 @@ void HybridRoll::onRemoveMidiEvent(const MidiEvent &event)
 {
     if (event.isTypeOf(MidiEvent::TimeSignature))
     {
+        this->invalidateGridCache();
         this->updateChildrenBounds();
         this->repaint();
     }
@@ -1228,41 +1737,157 @@ void HybridRoll::resized()
 
 void HybridRoll::paint(Graphics &g)
 {
+    profileScope("HybridRoll::paint");
+
+    this->paintStartTicks = Time::getHighResolutionTicks();
+
+    // The grid is already drawn beneath, see fillGeometry
+    if (this->isUsingOpenGLRenderer())
+    {
+        return;
+    }
+
     this->computeVisibleBeatLines();
 
-    const float paintStartY = float(this->viewport.getViewPositionY());
-    const float paintEndY = paintStartY + this->viewport.getViewHeight();
+    const int paintStartX = this->viewport.getViewPositionX();
+    const int paintEndX = paintStartX + this->viewport.getViewWidth();
+    const int paintStartY = this->viewport.getViewPositionY();
+    const int paintHeight = this->viewport.getViewHeight();
+
+    // Each pre-rasterized tile is repeated down the view height as a tiled fill,
+    // so painting the grid takes one fill per tile, no matter how dense it is;
+    // nearest neighbour, so that the lines stay sharp on hi-dpi screens
+    g.setImageResamplingQuality(Graphics::lowResamplingQuality);
+
+    const int firstTile = int(floorf(float(paintStartX) / HYBRID_ROLL_GRID_TILE_WIDTH));
+    const int lastTile = int(floorf(float(paintEndX) / HYBRID_ROLL_GRID_TILE_WIDTH));
+
+    for (int tileIndex = firstTile; tileIndex <= lastTile; ++tileIndex)
+    {
+        const int tileX = tileIndex * HYBRID_ROLL_GRID_TILE_WIDTH;
+
+        Image tile;
+        const auto found = this->gridCache.tiles.find(tileIndex);
+        if (found != this->gridCache.tiles.end())
+        {
+            tile = found->second;
+        }
+        else
+        {
+            tile = this->renderGridTile(tileIndex);
+
+            // the tiles at the edges of the cache are not complete yet
+            if (float(tileX) >= this->gridCache.startX &&
+                float(tileX + HYBRID_ROLL_GRID_TILE_WIDTH) <= this->gridCache.endX)
+            {
+                this->gridCache.tiles[tileIndex] = tile;
+            }
+        }
+
+        g.setTiledImageFill(tile, tileX, 0, 1.f);
+        g.fillRect(tileX, paintStartY, HYBRID_ROLL_GRID_TILE_WIDTH, paintHeight);
+    }
+}
+
+void HybridRoll::paintOverChildren(Graphics &g)
+{
+    // Measures the whole roll paint, including all the children
+    if (this->paintStartTicks != 0)
+    {
+        const int64 paintEndTicks = Time::getHighResolutionTicks();
+        const double paintTimeMs = Time::highResolutionTicksToSeconds(paintEndTicks - this->paintStartTicks) * 1000.0;
+        this->frameStats.lastPaintTimeMs = paintTimeMs;
+        this->frameStats.totalPaintTimeMs += paintTimeMs;
+        this->frameStats.numPaints++;
+        this->paintStartTicks = 0;
+    }
+}
+
+void HybridRoll::parentHierarchyChanged()
+{
+    // Called when the page with the roll is shown again,
+    // e.g. after the renderer was switched in the settings
+    this->updateRenderer();
+}
+
+//===----------------------------------------------------------------------===//
+// HybridRollRenderer::Source
+//===----------------------------------------------------------------------===//
+
+void HybridRoll::fillGeometry(HybridRollRenderer::Geometry &geometry)
+{
+    geometry.viewArea = { this->viewport.getViewPositionX(), this->viewport.getViewPositionY(),
+        this->viewport.getWidth(), this->viewport.getHeight() };
+
+    // The header relies on the visible lines as well,
+    // and it's painted right after the geometry is drawn
+    this->computeVisibleBeatLines();
+
+    const float y = float(geometry.viewArea.getY());
+    const float h = float(geometry.viewArea.getHeight());
 
-    g.setColour(this->barLineColour);
     for (const auto &f : this->visibleBars)
     {
-        g.drawVerticalLine(int(floorf(f)), paintStartY, paintEndY);
+        geometry.addQuad({ floorf(f), y, 1.f, h }, this->barLineColour);
     }
 
-    g.setColour(this->barLineBevelColour);
     for (const auto &f : this->visibleBars)
     {
-        g.drawVerticalLine(int(floorf(f)) + 1, paintStartY, paintEndY);
+        geometry.addQuad({ floorf(f) + 1.f, y, 1.f, h }, this->barLineBevelColour);
     }
 
-    g.setColour(this->beatLineColour);
     for (const auto &f : this->visibleBeats)
     {
-        g.drawVerticalLine(int(floorf(f)), paintStartY, paintEndY);
+        geometry.addQuad({ floorf(f), y, 1.f, h }, this->beatLineColour);
     }
-    
-    g.setColour(this->snapLineColour);
+
     for (const auto &f : this->visibleSnaps)
     {
-        g.drawVerticalLine(int(floorf(f)), paintStartY, paintEndY);
+        geometry.addQuad({ floorf(f), y, 1.f, h }, this->snapLineColour);
     }
 }
 
+bool HybridRoll::isUsingOpenGLRenderer() const noexcept
+{
+    return this->renderer != nullptr;
+}
+
+void HybridRoll::updateRenderer()
+{
+    const bool shouldUseOpenGL = MainWindow::isOpenGLRendererEnabled();
+    if (shouldUseOpenGL == this->isUsingOpenGLRenderer())
+    {
+        return;
+    }
+
+    if (shouldUseOpenGL)
+    {
+        this->renderer = new HybridRollRenderer(*this);
+        this->renderer->attachTo(this->viewport);
+    }
+    else
+    {
+        this->renderer = nullptr;
+    }
+
+    // Lets the geometry drawn beneath show through
+    this->setOpaque(!shouldUseOpenGL);
+    this->repaint();
+}
+
 //===----------------------------------------------------------------------===//
 // Playhead::Listener
 //===----------------------------------------------------------------------===//
 
 void HybridRoll::onPlayheadMoved(int playheadX)
+{
+    // The playhead and the view following it are both moved on the next frame,
+    // so that frequent playhead updates don't flood the message thread
+    this->pendingPlayheadX = playheadX;
+    this->frameScheduler->requestFrame();
+}
+
+void HybridRoll::followPlayhead(int playheadX)
 {
     if (this->shouldFollowPlayhead &&
         !this->smoothZoomController->isZooming())
@@ -1427,31 +2052,136 @@ void HybridRoll::scrollToSeekPosition()
 
 void HybridRoll::handleAsyncUpdate()
 {
+    this->frameScheduler->requestFrame();
+}
+
+void HybridRoll::repaintOnNextFrame(const Rectangle<int> &area)
+{
+    // Merging gets slower as the region grows, and a lot of scattered areas,
+    // like a large selection, are cheaper to repaint as a single one
+    if (this->dirtyRegion.getNumRectangles() >= MAX_COMPONENTS_TO_REPAINT_SEPARATELY)
+    {
+        const auto bounds = this->dirtyRegion.getBounds().getUnion(area);
+        this->dirtyRegion.clear();
+        this->dirtyRegion.add(bounds);
+    }
+    else
+    {
+        this->dirtyRegion.add(area);
+    }
+
+    this->frameStats.numRectsRequested++;
+    this->frameScheduler->requestFrame();
+}
+
+const HybridRoll::FrameStats &HybridRoll::getFrameStats() const noexcept
+{
+    return this->frameStats;
+}
+
+void HybridRoll::updateHeaderOnNextFrame()
+{
+    this->headerNeedsUpdate = true;
+    this->frameScheduler->requestFrame();
+}
+
+void HybridRoll::renderFrame()
+{
+    profileScope("HybridRoll::renderFrame");
+
+    this->frameStats.numFramesRendered++;
+
     // batch repaint & resize stuff
-    if (this->batchRepaintList.size() > 0)
+    const int batchSize = this->batchRepaintList.size();
+    if (batchSize > MAX_COMPONENTS_TO_REPAINT_SEPARATELY)
     {
+        // Hiding the roll makes all the bounds changes skip repainting,
+        // and showing it back repaints everything at once
         HYBRID_ROLL_BULK_REPAINT_START
 
-        //Logger::writeToLog(this->getComponentID() + " is repainting batch of " + String(this->batchRepaintList.size()));
-
-        for (int i = 0; i < this->batchRepaintList.size(); ++i)
+        for (int i = 0; i < batchSize; ++i)
         {
             // There are still many cases when a scheduled component is deleted at this time:
             if (FloatBoundsComponent *component = this->batchRepaintList.getUnchecked(i))
             {
-                const Rectangle<float> nb(this->getEventBounds(component));
-                component->setFloatBounds(nb);
-                component->repaint();
+                component->setFloatBounds(this->getEventBounds(component));
             }
         }
 
         HYBRID_ROLL_BULK_REPAINT_END
 
-        this->batchRepaintList.clear();
+        // everything requested so far ends up in a single repaint
+        const int64 numRequested = this->frameStats.numRectsRequested -
+            this->rectsRequestedBeforeFrame + batchSize;
+        this->frameStats.numRectsRequested += batchSize;
+        this->frameStats.numRectsMerged += numRequested - 1;
+        this->dirtyRegion.clear(); // already repainted
+    }
+    else if (batchSize > 0)
+    {
+        for (int i = 0; i < batchSize; ++i)
+        {
+            if (FloatBoundsComponent *component = this->batchRepaintList.getUnchecked(i))
+            {
+                // both old and new positions need to be repainted
+                this->dirtyRegion.add(component->getBounds());
+                component->setFloatBounds(this->getEventBounds(component));
+                this->dirtyRegion.add(component->getBounds());
+                this->frameStats.numRectsRequested += 2;
+            }
+        }
+    }
+
+    this->batchRepaintList.clearQuick();
+
+    if (! this->dirtyRegion.isEmpty())
+    {
+        // RectangleList merges the overlapping areas as they are added,
+        // so the number of repainted areas is usually much smaller
+        const int64 numRequested = this->frameStats.numRectsRequested - this->rectsRequestedBeforeFrame;
+        this->dirtyRegion.consolidate();
+
+        for (const auto &area : this->dirtyRegion)
+        {
+            this->repaint(area);
+        }
+
+        this->frameStats.numRectsMerged += jmax(int64(0), numRequested - this->dirtyRegion.getNumRectangles());
+        this->dirtyRegion.clear();
     }
 
+    this->rectsRequestedBeforeFrame = this->frameStats.numRectsRequested;
+
+    if (this->headerNeedsUpdate && this->header != nullptr)
+    {
+        this->header->updateIndicators();
+    }
+
+    this->headerNeedsUpdate = false;
+
+    // The view is either animated towards the seek position by the timer,
+    // or follows the playback, but never both within one frame
 #if ROLL_VIEW_FOLLOWS_PLAYHEAD
-    if (this->shouldFollowPlayhead &&
+    const bool isScrollingToSeekPosition = this->isTimerRunning();
+#else
+    const bool isScrollingToSeekPosition = false;
+#endif
+
+    if (this->pendingPlayheadX >= 0)
+    {
+        this->playhead->setTopLeftPosition(this->pendingPlayheadX, 0);
+
+        if (! isScrollingToSeekPosition)
+        {
+            this->followPlayhead(this->pendingPlayheadX);
+        }
+
+        this->pendingPlayheadX = -1;
+    }
+
+#if ROLL_VIEW_FOLLOWS_PLAYHEAD
+    if (isScrollingToSeekPosition &&
+        this->shouldFollowPlayhead &&
         !this->smoothZoomController->isZooming())
     {
         const int playheadX = this->getXPositionByTransportPosition(this->lastTransportPosition.get(), float(this->getWidth()));
@@ -51,12 +51,17 @@ class TimelineWarningMarker;
 #include "Lasso.h"
 #include "HybridRollEditMode.h"
 #include "AudioMonitor.h"
+#include "HybridRollRenderer.h"
 
 #define HYBRID_ROLL_MAX_BAR_WIDTH (192)
+#define HYBRID_ROLL_GRID_TILE_WIDTH (256)
 #define HYBRID_ROLL_HEADER_HEIGHT (40)
 
 #define DEFAULT_NUM_BARS 8
 
+// ~60 fps, the rolls never render more often than that
+#define HYBRID_ROLL_FRAME_INTERVAL_MS (16)
+
 #define HYBRID_ROLL_BULK_REPAINT_START \
     this->setVisible(false);
 
@@ -77,7 +82,8 @@ class HybridRoll :
     protected AsyncUpdater, // for async scrolling on transport listener events
     protected HighResolutionTimer, // for smooth scrolling to seek position
     protected Playhead::Listener, // for smooth scrolling to seek position
-    protected AudioMonitor::ClippingListener // for displaying clipping indicator components
+    protected AudioMonitor::ClippingListener, // for displaying clipping indicator components
+    protected HybridRollRenderer::Source // for drawing the static layers with OpenGL
 {
 public:
     
@@ -212,6 +218,28 @@ public:
     
     void triggerBatchRepaintFor(FloatBoundsComponent *target);
 
+    //===------------------------------------------------------------------===//
+    // Frame scheduling
+    //===------------------------------------------------------------------===//
+
+    struct FrameStats final
+    {
+        int64 numFramesRendered = 0;
+        int64 numRectsRequested = 0;
+        int64 numRectsMerged = 0;
+        double lastPaintTimeMs = 0.0;
+        double totalPaintTimeMs = 0.0;
+        int64 numPaints = 0;
+    };
+
+    // Areas requested within one frame are merged and repainted together,
+    // at most once per frame interval
+    void repaintOnNextFrame(const Rectangle<int> &area);
+    const FrameStats &getFrameStats() const noexcept;
+
+    // The header indicators are moved within the next frame as well
+    void updateHeaderOnNextFrame();
+
     bool isFollowingPlayhead() const noexcept;
     void startFollowingPlayhead();
     void stopFollowingPlayhead();
@@ -254,6 +282,8 @@ public:
     void handleCommandMessage(int commandId) override;
     void resized() override;
     void paint(Graphics &g) override;
+    void paintOverChildren(Graphics &g) override;
+    void parentHierarchyChanged() override;
 
 protected:
     
@@ -303,6 +333,23 @@ protected:
     
     void handleAsyncUpdate() override;
 
+    // All batched updates, dirty areas, the header indicators,
+    // the playhead and the view following it are processed here, see FrameScheduler
+    virtual void renderFrame();
+
+    class FrameScheduler;
+    ScopedPointer<FrameScheduler> frameScheduler;
+
+    RectangleList<int> dirtyRegion;
+    bool headerNeedsUpdate;
+
+    FrameStats frameStats;
+    int64 paintStartTicks;
+    int64 rectsRequestedBeforeFrame;
+
+    void followPlayhead(int playheadX);
+    int pendingPlayheadX;
+
     double findPlayheadOffsetFromViewCentre() const;
     friend class HybridRollHeader;
     
@@ -311,6 +358,20 @@ protected:
     //===------------------------------------------------------------------===//
 
     void hiResTimerCallback() override;
+
+    //===------------------------------------------------------------------===//
+    // HybridRollRenderer::Source
+    //===------------------------------------------------------------------===//
+
+    // The grid lines; the subclasses add their backgrounds before them,
+    // and whatever they paint over the grid, after them
+    void fillGeometry(HybridRollRenderer::Geometry &geometry) override;
+
+    // When the OpenGL renderer is enabled, the roll is transparent
+    // and only paints what's not in its geometry
+    ScopedPointer<HybridRollRenderer> renderer;
+    bool isUsingOpenGLRenderer() const noexcept;
+    void updateRenderer();
     
 protected:
     
@@ -415,6 +476,36 @@ protected:
     const Colour snapLineColour;
 
     void computeVisibleBeatLines();
+    void computeBeatLines(float rangeStartX, float rangeEndX,
+        Array<float> &bars, Array<float> &beats, Array<float> &snaps) const;
+
+    // Zoom level and time signature changes are detected automatically,
+    // this one is only needed to drop the cache explicitly
+    void invalidateGridCache() noexcept;
+
+private:
+
+    struct GridCache final
+    {
+        bool isValid = false;
+        float barWidth = 0.f;
+        float firstBar = 0.f;
+        int timeSignaturesRevision = 0;
+        float startX = 0.f;
+        float endX = 0.f;
+        Array<float> bars;
+        Array<float> beats;
+        Array<float> snaps;
+
+        // One pixel high tiles with all the lines pre-rasterized, keyed by index;
+        // only kept for the tiles that are entirely within the cached range
+        SparseHashMap<int, Image> tiles;
+    };
+
+    GridCache gridCache;
+    void rebuildGridCache(float startX, float endX);
+    void extendGridCache(float startX, float endX, float maxWidth);
+    Image renderGridTile(int tileIndex) const;
 
 protected:
 
@@ -425,6 +516,26 @@ protected:
 
     Array<SafePointer<FloatBoundsComponent>> batchRepaintList;
 
+    //===------------------------------------------------------------------===//
+    // Lasso index
+    //===------------------------------------------------------------------===//
+
+    // A uniform grid of rows and beats, so that the lasso only checks
+    // the components close to its area instead of all of them;
+    // rows are whatever a roll uses, e.g. keys for the piano roll
+    class LassoIndex;
+    ScopedPointer<LassoIndex> lassoIndex;
+    bool lassoIndexIsOutdated;
+
+    // Called before the next lookup after the index is invalidated
+    virtual void rebuildLassoIndex() = 0;
+    void invalidateLassoIndex() noexcept;
+    void updateLassoIndexFor(MidiEventComponent *component,
+        int row, float startBeat, float endBeat);
+    void removeFromLassoIndex(MidiEventComponent *component);
+    void findLassoItemsInRows(Array<SelectableComponent *> &itemsFound,
+        const Rectangle<int> &area, int firstRow, int lastRow);
+
 protected:
     
     void changeListenerCallback(ChangeBroadcaster *source) override;
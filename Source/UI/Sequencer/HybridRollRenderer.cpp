@@ -0,0 +1,395 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Common.h"
+#include "HybridRollRenderer.h"
+
+#if JUCE_WINDOWS
+#   define HYBRID_ROLL_GL_API __stdcall
+#else
+#   define HYBRID_ROLL_GL_API
+#endif
+
+// Each quad is two triangles of a unit square, stretched to the rectangle in the shader
+static const GLfloat kQuadCorners[] = { 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 1.f, 1.f, 0.f, 1.f, 1.f };
+static const int kNumQuadCorners = 6;
+
+static const char *const kVertexShader =
+    "attribute vec2 corner;\n"
+    "attribute vec4 rect;\n"
+    "attribute vec4 colour;\n"
+    "uniform vec4 viewArea;\n"
+    "varying " JUCE_LOWP " vec4 fragmentColour;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 position = rect.xy + corner * rect.zw - viewArea.xy;\n"
+    "    gl_Position = vec4(position.x / viewArea.z * 2.0 - 1.0,\n"
+    "        1.0 - position.y / viewArea.w * 2.0, 0.0, 1.0);\n"
+    "    fragmentColour = colour;\n"
+    "}\n";
+
+static const char *const kFragmentShader =
+    "varying " JUCE_LOWP " vec4 fragmentColour;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = fragmentColour;\n"
+    "}\n";
+
+static const GLvoid *getAttributeOffset(size_t numBytes) noexcept
+{
+    return reinterpret_cast<const GLvoid *>(numBytes);
+}
+
+//===----------------------------------------------------------------------===//
+// Instancing
+//===----------------------------------------------------------------------===//
+
+class HybridRollRenderer::Instancing final
+{
+public:
+
+    using DrawArraysInstanced = void (HYBRID_ROLL_GL_API *)(GLenum, GLint, GLsizei, GLsizei);
+    using VertexAttribDivisor = void (HYBRID_ROLL_GL_API *)(GLuint, GLuint);
+
+    // Needs an active context; returns nullptr if instanced arrays are not supported
+    static Instancing *createForCurrentContext()
+    {
+        // glXGetProcAddress returns something for any name,
+        // so the version and the extensions have to be checked first
+        const String version(reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+        const String versionNumber = version.trimCharactersAtStart("OpenGL ES-CM");
+        const int major = versionNumber.getIntValue();
+
+#if JUCE_OPENGL_ES
+        const bool hasCoreInstancing = (major >= 3);
+#else
+        const int minor = versionNumber.fromFirstOccurrenceOf(".", false, false).getIntValue();
+        const bool hasCoreInstancing = (major > 3) || (major == 3 && minor >= 3);
+#endif
+
+        String suffix;
+        if (! hasCoreInstancing)
+        {
+            if (OpenGLHelpers::isExtensionSupported("GL_ARB_instanced_arrays") &&
+                OpenGLHelpers::isExtensionSupported("GL_ARB_draw_instanced"))
+            {
+                suffix = "ARB";
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+
+        const auto drawArraysInstanced = reinterpret_cast<DrawArraysInstanced>(
+            OpenGLHelpers::getExtensionFunction(("glDrawArraysInstanced" + suffix).toRawUTF8()));
+
+        const auto vertexAttribDivisor = reinterpret_cast<VertexAttribDivisor>(
+            OpenGLHelpers::getExtensionFunction(("glVertexAttribDivisor" + suffix).toRawUTF8()));
+
+        if (drawArraysInstanced == nullptr || vertexAttribDivisor == nullptr)
+        {
+            return nullptr;
+        }
+
+        return new Instancing(drawArraysInstanced, vertexAttribDivisor);
+    }
+
+    const DrawArraysInstanced drawArraysInstanced;
+    const VertexAttribDivisor vertexAttribDivisor;
+
+private:
+
+    Instancing(DrawArraysInstanced drawArraysInstanced, VertexAttribDivisor vertexAttribDivisor) :
+        drawArraysInstanced(drawArraysInstanced),
+        vertexAttribDivisor(vertexAttribDivisor) {}
+
+    JUCE_DECLARE_NON_COPYABLE(Instancing)
+};
+
+//===----------------------------------------------------------------------===//
+// Geometry
+//===----------------------------------------------------------------------===//
+
+void HybridRollRenderer::Geometry::clear()
+{
+    this->viewArea = {};
+    this->fills.clearQuick();
+    this->quads.clearQuick();
+}
+
+void HybridRollRenderer::Geometry::addFill(const Rectangle<int> &area, const FillType &fillType)
+{
+    this->fills.add({ area, fillType });
+}
+
+void HybridRollRenderer::Geometry::addQuad(const Rectangle<float> &area, Colour colour)
+{
+    this->quads.add({ area.getX(), area.getY(), area.getWidth(), area.getHeight(),
+        colour.getRed(), colour.getGreen(), colour.getBlue(), colour.getAlpha() });
+}
+
+//===----------------------------------------------------------------------===//
+// HybridRollRenderer
+//===----------------------------------------------------------------------===//
+
+HybridRollRenderer::HybridRollRenderer(Source &source) :
+    source(source)
+{
+    this->context.setPixelFormat(OpenGLPixelFormat(8, 8, 0, 0));
+    this->context.setMultisamplingEnabled(false);
+    this->context.setComponentPaintingEnabled(true);
+    this->context.setRenderer(this);
+}
+
+HybridRollRenderer::~HybridRollRenderer()
+{
+    // Stops the rendering thread, so that the source is never called after this
+    this->context.detach();
+}
+
+void HybridRollRenderer::attachTo(Component &component)
+{
+    this->context.attachTo(component);
+}
+
+//===----------------------------------------------------------------------===//
+// OpenGLRenderer
+//===----------------------------------------------------------------------===//
+
+void HybridRollRenderer::newOpenGLContextCreated()
+{
+    auto &gl = this->context.extensions;
+
+    this->instancing = Instancing::createForCurrentContext();
+    Logger::writeToLog(this->instancing != nullptr ?
+        "Rendering the rolls with instanced arrays." :
+        "Instanced arrays are not supported, rendering the rolls with vertex arrays.");
+
+    this->shader = new OpenGLShaderProgram(this->context);
+    if (! this->shader->addVertexShader(kVertexShader) ||
+        ! this->shader->addFragmentShader(kFragmentShader) ||
+        ! this->shader->link())
+    {
+        Logger::writeToLog("Failed to build the roll shader: " + this->shader->getLastError());
+        this->shader = nullptr;
+        return;
+    }
+
+    const GLuint programId = this->shader->getProgramID();
+    this->cornerAttribute = gl.glGetAttribLocation(programId, "corner");
+    this->rectAttribute = gl.glGetAttribLocation(programId, "rect");
+    this->colourAttribute = gl.glGetAttribLocation(programId, "colour");
+
+    if (this->cornerAttribute < 0 || this->rectAttribute < 0 || this->colourAttribute < 0)
+    {
+        Logger::writeToLog("Failed to find the roll shader attributes.");
+        this->shader = nullptr;
+        return;
+    }
+
+    this->viewAreaUniform = new OpenGLShaderProgram::Uniform(*this->shader, "viewArea");
+
+    gl.glGenBuffers(1, &this->cornersBuffer);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, this->cornersBuffer);
+    gl.glBufferData(GL_ARRAY_BUFFER, sizeof(kQuadCorners), kQuadCorners, GL_STATIC_DRAW);
+
+    gl.glGenBuffers(1, &this->quadsBuffer);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    this->numUploadedQuads = 0;
+    this->geometryNeedsUpload = true;
+}
+
+void HybridRollRenderer::renderOpenGL()
+{
+    // JUCE locks the message thread for the frames that repaint the components,
+    // and that's when the roll has changed, so the geometry is only rebuilt then
+    if (MessageManager::getInstance()->currentThreadHasLockedMessageManager())
+    {
+        this->geometry.clear();
+        this->source.fillGeometry(this->geometry);
+        this->geometryNeedsUpload = true;
+    }
+
+    OpenGLHelpers::clear(Colours::transparentBlack);
+
+    if (this->geometry.viewArea.isEmpty())
+    {
+        return;
+    }
+
+    this->drawFills();
+    this->drawQuads();
+}
+
+void HybridRollRenderer::openGLContextClosing()
+{
+    auto &gl = this->context.extensions;
+
+    if (this->cornersBuffer != 0)
+    {
+        gl.glDeleteBuffers(1, &this->cornersBuffer);
+        this->cornersBuffer = 0;
+    }
+
+    if (this->quadsBuffer != 0)
+    {
+        gl.glDeleteBuffers(1, &this->quadsBuffer);
+        this->quadsBuffer = 0;
+    }
+
+    this->viewAreaUniform = nullptr;
+    this->shader = nullptr;
+    this->instancing = nullptr;
+    this->vertices.clear();
+    this->numUploadedQuads = 0;
+}
+
+//===----------------------------------------------------------------------===//
+// Drawing
+//===----------------------------------------------------------------------===//
+
+void HybridRollRenderer::uploadGeometry()
+{
+    auto &gl = this->context.extensions;
+    const auto &quads = this->geometry.quads;
+
+    gl.glBindBuffer(GL_ARRAY_BUFFER, this->quadsBuffer);
+
+    if (this->instancing != nullptr)
+    {
+        gl.glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(Quad) * size_t(quads.size())),
+            quads.getRawDataPointer(), GL_STREAM_DRAW);
+    }
+    else
+    {
+        this->vertices.clearQuick();
+        this->vertices.ensureStorageAllocated(quads.size() * kNumQuadCorners);
+
+        for (const auto &quad : quads)
+        {
+            for (int i = 0; i < kNumQuadCorners; ++i)
+            {
+                this->vertices.add({ kQuadCorners[i * 2], kQuadCorners[i * 2 + 1], quad });
+            }
+        }
+
+        gl.glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(Vertex) * size_t(this->vertices.size())),
+            this->vertices.getRawDataPointer(), GL_STREAM_DRAW);
+    }
+
+    this->numUploadedQuads = quads.size();
+}
+
+void HybridRollRenderer::drawFills()
+{
+    if (this->geometry.fills.isEmpty())
+    {
+        return;
+    }
+
+    const auto &viewArea = this->geometry.viewArea;
+    const float scale = float(this->context.getRenderingScale());
+
+    ScopedPointer<LowLevelGraphicsContext> glRenderer(createOpenGLGraphicsContext(this->context,
+        roundToInt(scale * viewArea.getWidth()), roundToInt(scale * viewArea.getHeight())));
+
+    if (glRenderer == nullptr)
+    {
+        return;
+    }
+
+    // Everything is flushed when the graphics context is deleted
+    Graphics g(*glRenderer);
+    g.addTransform(AffineTransform::scale(scale));
+    g.setOrigin(-viewArea.getX(), -viewArea.getY());
+
+    for (const auto &fill : this->geometry.fills)
+    {
+        g.setFillType(fill.fillType);
+        g.fillRect(fill.area);
+    }
+}
+
+void HybridRollRenderer::drawQuads()
+{
+    if (this->shader == nullptr || this->geometry.quads.isEmpty())
+    {
+        return;
+    }
+
+    if (this->geometryNeedsUpload)
+    {
+        this->uploadGeometry();
+        this->geometryNeedsUpload = false;
+    }
+
+    auto &gl = this->context.extensions;
+    const auto &viewArea = this->geometry.viewArea;
+    const GLuint corner = GLuint(this->cornerAttribute);
+    const GLuint rect = GLuint(this->rectAttribute);
+    const GLuint colour = GLuint(this->colourAttribute);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    this->shader->use();
+    this->viewAreaUniform->set(GLfloat(viewArea.getX()), GLfloat(viewArea.getY()),
+        GLfloat(viewArea.getWidth()), GLfloat(viewArea.getHeight()));
+
+    gl.glEnableVertexAttribArray(corner);
+    gl.glEnableVertexAttribArray(rect);
+    gl.glEnableVertexAttribArray(colour);
+
+    if (this->instancing != nullptr)
+    {
+        gl.glBindBuffer(GL_ARRAY_BUFFER, this->cornersBuffer);
+        gl.glVertexAttribPointer(corner, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+        gl.glBindBuffer(GL_ARRAY_BUFFER, this->quadsBuffer);
+        gl.glVertexAttribPointer(rect, 4, GL_FLOAT, GL_FALSE,
+            GLsizei(sizeof(Quad)), getAttributeOffset(offsetof(Quad, x)));
+        gl.glVertexAttribPointer(colour, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+            GLsizei(sizeof(Quad)), getAttributeOffset(offsetof(Quad, r)));
+
+        this->instancing->vertexAttribDivisor(rect, 1);
+        this->instancing->vertexAttribDivisor(colour, 1);
+        this->instancing->drawArraysInstanced(GL_TRIANGLES, 0, kNumQuadCorners, this->numUploadedQuads);
+
+        // JUCE's own renderer uses the same attribute slots and knows nothing about divisors
+        this->instancing->vertexAttribDivisor(rect, 0);
+        this->instancing->vertexAttribDivisor(colour, 0);
+    }
+    else
+    {
+        gl.glBindBuffer(GL_ARRAY_BUFFER, this->quadsBuffer);
+        gl.glVertexAttribPointer(corner, 2, GL_FLOAT, GL_FALSE,
+            GLsizei(sizeof(Vertex)), getAttributeOffset(offsetof(Vertex, cornerX)));
+        gl.glVertexAttribPointer(rect, 4, GL_FLOAT, GL_FALSE,
+            GLsizei(sizeof(Vertex)), getAttributeOffset(offsetof(Vertex, quad) + offsetof(Quad, x)));
+        gl.glVertexAttribPointer(colour, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+            GLsizei(sizeof(Vertex)), getAttributeOffset(offsetof(Vertex, quad) + offsetof(Quad, r)));
+
+        glDrawArrays(GL_TRIANGLES, 0, this->numUploadedQuads * kNumQuadCorners);
+    }
+
+    gl.glDisableVertexAttribArray(corner);
+    gl.glDisableVertexAttribArray(rect);
+    gl.glDisableVertexAttribArray(colour);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
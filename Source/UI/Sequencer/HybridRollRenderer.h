@@ -0,0 +1,126 @@
+/*
+    This file is part of Helio Workstation.
+
+    Helio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Helio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Helio. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Draws the static layers of a roll (backgrounds, grid, inactive notes)
+// with its own OpenGL context attached to the roll's viewport;
+// the roll itself stays transparent and is painted over them,
+// so all its components work just the same as with the software renderer.
+class HybridRollRenderer final : public OpenGLRenderer
+{
+public:
+
+    // A rectangle in the roll's coordinates, drawn as an instance of a unit quad
+    struct Quad final
+    {
+        float x;
+        float y;
+        float w;
+        float h;
+        uint8 r;
+        uint8 g;
+        uint8 b;
+        uint8 a;
+    };
+
+    // An area filled with a colour or a tiled image, like the rows backgrounds
+    struct Fill final
+    {
+        Rectangle<int> area;
+        FillType fillType;
+    };
+
+    // Everything needed to draw one frame
+    struct Geometry final
+    {
+        // The whole viewport area in the roll's coordinates
+        Rectangle<int> viewArea;
+
+        // Drawn first, with JUCE's own OpenGL graphics context
+        Array<Fill> fills;
+
+        // Drawn over the fills, all in a single instanced draw call
+        Array<Quad> quads;
+
+        void clear();
+        void addFill(const Rectangle<int> &area, const FillType &fillType);
+        void addQuad(const Rectangle<float> &area, Colour colour);
+    };
+
+    class Source
+    {
+    public:
+        virtual ~Source() {}
+
+        // Called on the rendering thread, but only while the message thread is locked
+        virtual void fillGeometry(Geometry &geometry) = 0;
+    };
+
+    explicit HybridRollRenderer(Source &source);
+    ~HybridRollRenderer() override;
+
+    void attachTo(Component &component);
+
+    //===------------------------------------------------------------------===//
+    // OpenGLRenderer
+    //===------------------------------------------------------------------===//
+
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+
+private:
+
+    void uploadGeometry();
+    void drawFills();
+    void drawQuads();
+
+    Source &source;
+    OpenGLContext context;
+
+    // Kept between the frames; only refilled when the components are repainted,
+    // the other frames draw the same geometry again
+    Geometry geometry;
+    bool geometryNeedsUpload = false;
+
+    ScopedPointer<OpenGLShaderProgram> shader;
+    ScopedPointer<OpenGLShaderProgram::Uniform> viewAreaUniform;
+    GLint cornerAttribute = -1;
+    GLint rectAttribute = -1;
+    GLint colourAttribute = -1;
+
+    GLuint cornersBuffer = 0;
+    GLuint quadsBuffer = 0;
+    int numUploadedQuads = 0;
+
+    // Instancing is not available everywhere (e.g. OpenGL ES 2),
+    // so there's also a fallback that expands each quad into vertices
+    class Instancing;
+    ScopedPointer<Instancing> instancing;
+
+    struct Vertex final
+    {
+        float cornerX;
+        float cornerY;
+        Quad quad;
+    };
+
+    Array<Vertex> vertices;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HybridRollRenderer)
+};
@@ -103,7 +103,8 @@ void MidiEventComponent::setSelected(bool selected)
     {
         this->selectedState = selected;
         this->updateColours();
-        this->roll.triggerBatchRepaintFor(this);
+        // the bounds stay the same, so the area is just repainted
+        this->roll.repaintOnNextFrame(this->getBounds());
     }
 }
 
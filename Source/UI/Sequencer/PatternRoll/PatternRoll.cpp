@@ -53,6 +53,7 @@
 #include "Config.h"
 #include "Icons.h"
 #include "App.h"
+#include "Profiler.h"
 
 #define DEFAULT_CLIP_LENGTH 1.0f
 
@@ -109,9 +110,11 @@ void PatternRoll::zoomViewToClip(const Clip &clip) const
 void PatternRoll::reloadRollContent()
 {
     this->selection.deselectAll();
+    this->invalidateGridCache(); // time signatures might have changed
 
     this->trackHeaders.clear();
     this->clipComponents.clear();
+    this->invalidateLassoIndex();
 
     this->tracks.clearQuick();
 
@@ -330,16 +333,19 @@ void PatternRoll::onAddMidiEvent(const MidiEvent &event)
     // is pattern roll supposed to monitor single event changes?
     // or it just reloads the whole sequence on show?
     //this->reloadRollContent();
+
+    // clips lengths depend on their sequences
+    this->invalidateLassoIndex();
 }
 
 void PatternRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &newEvent)
 {
-    //
+    this->invalidateLassoIndex();
 }
 
 void PatternRoll::onRemoveMidiEvent(const MidiEvent &event)
 {
-    //
+    this->invalidateLassoIndex();
 }
 
 void PatternRoll::onPostRemoveMidiEvent(MidiSequence *const layer)
@@ -355,6 +361,7 @@ void PatternRoll::onAddTrack(MidiTrack *const track)
         jassert(sequence != nullptr);
 
         this->tracks.addSorted(*track, track);
+        this->invalidateLassoIndex(); // rows have changed
 
         MidiTrackHeader *const trackHeader = new MidiTrackHeader(track);
         this->trackHeaders[track] = UniquePointer<MidiTrackHeader>(trackHeader);
@@ -399,6 +406,7 @@ void PatternRoll::onChangeTrackProperties(MidiTrack *const track)
         //this->tracks.removeAllInstancesOf(track);
         //this->tracks.addSorted(*track, track);
         this->tracks.sort();
+        this->invalidateLassoIndex();
 
         // TODO only repaint clips of a changed track?
         for (const auto &e : this->clipComponents)
@@ -417,6 +425,7 @@ void PatternRoll::onRemoveTrack(MidiTrack *const track)
     this->hideAllGhostClips();
 
     this->tracks.removeAllInstancesOf(track);
+    this->invalidateLassoIndex();
 
     if (MidiTrackHeader *deletedHeader = this->trackHeaders[track].get())
     {
@@ -458,6 +467,7 @@ void PatternRoll::onAddClip(const Clip &clip)
     {
         this->clipComponents[clip] = UniquePointer<ClipComponent>(clipComponent);
         this->addAndMakeVisible(clipComponent);
+        this->updateLassoIndexForClip(clipComponent);
         clipComponent->toFront(false);
 
         this->fader.fadeIn(clipComponent, 150);
@@ -480,6 +490,7 @@ void PatternRoll::onChangeClip(const Clip &clip, const Clip &newClip)
     {
         this->clipComponents.erase(clip);
         this->clipComponents[newClip] = UniquePointer<ClipComponent>(component);
+        this->updateLassoIndexForClip(component);
 
         this->batchRepaintList.add(component);
         this->triggerAsyncUpdate();
@@ -494,6 +505,7 @@ void PatternRoll::onRemoveClip(const Clip &clip)
 
         this->fader.fadeOut(deletedComponent, 150);
         this->selection.deselect(deletedComponent);
+        this->removeFromLassoIndex(deletedComponent);
         this->clipComponents.erase(clip);
     }
 }
@@ -533,28 +545,32 @@ void PatternRoll::selectEventsInRange(float startBeat, float endBeat, bool shoul
 
 void PatternRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound, const Rectangle<int> &rectangle)
 {
-    bool shouldInvalidateSelectionCache = false;
+    const int firstRow = (rectangle.getY() - HYBRID_ROLL_HEADER_HEIGHT) / rowHeight() - 1;
+    const int lastRow = (rectangle.getBottom() - HYBRID_ROLL_HEADER_HEIGHT) / rowHeight() + 1;
+    this->findLassoItemsInRows(itemsFound, rectangle,
+        jmax(0, firstRow), jmin(lastRow, this->getNumRows() - 1));
+}
 
+void PatternRoll::rebuildLassoIndex()
+{
     for (const auto &e : this->clipComponents)
     {
-        const auto component = e.second.get();
-        component->setSelected(this->selection.isSelected(component));
+        this->updateLassoIndexForClip(e.second.get());
     }
+}
 
-    for (const auto &e : this->clipComponents)
-    {
-        const auto component = e.second.get();
-        if (rectangle.intersects(component->getBounds()) && component->isActive())
-        {
-            shouldInvalidateSelectionCache = true;
-            itemsFound.addIfNotAlreadyThere(component);
-        }
-    }
+// Same as in getEventBounds, but in beats and rows
+void PatternRoll::updateLassoIndexForClip(ClipComponent *cc)
+{
+    const MidiTrack *track = cc->getClip().getPattern()->getTrack();
+    const MidiSequence *sequence = track->getSequence();
 
-    if (shouldInvalidateSelectionCache)
-    {
-        this->selection.invalidateCache();
-    }
+    const int trackIndex = this->tracks.indexOfSorted(*track, track);
+    const float sequenceOffset = sequence->size() > 0 ? sequence->getFirstBeat() : 0.f;
+    const float sequenceLength = jmax(sequence->getLengthInBeats(), float(BEATS_PER_BAR));
+    const float startBeat = sequenceOffset + cc->getBeat();
+
+    this->updateLassoIndexFor(cc, trackIndex, startBeat, startBeat + sequenceLength);
 }
 
 //===----------------------------------------------------------------------===//
@@ -731,11 +747,26 @@ void PatternRoll::resized()
 
 void PatternRoll::paint(Graphics &g)
 {
-    g.setTiledImageFill(this->rowPattern, 0, HYBRID_ROLL_HEADER_HEIGHT, 1.f);
-    g.fillRect(this->viewport.getViewArea());
+    profileScope("PatternRoll::paint");
+
+    // The rows and the grid are already drawn beneath
+    if (! this->isUsingOpenGLRenderer())
+    {
+        g.setTiledImageFill(this->rowPattern, 0, HYBRID_ROLL_HEADER_HEIGHT, 1.f);
+        g.fillRect(this->viewport.getViewArea());
+    }
+
     HybridRoll::paint(g);
 }
 
+void PatternRoll::fillGeometry(HybridRollRenderer::Geometry &geometry)
+{
+    geometry.addFill(this->viewport.getViewArea(),
+        FillType(this->rowPattern, AffineTransform::translation(0.f, float(HYBRID_ROLL_HEADER_HEIGHT))));
+
+    HybridRoll::fillGeometry(geometry);
+}
+
 void PatternRoll::parentSizeChanged()
 {
     this->updateRollSize();
@@ -95,6 +95,9 @@ public:
     void findLassoItemsInArea(Array<SelectableComponent *> &itemsFound,
         const Rectangle<int> &rectangle) override;
 
+    void rebuildLassoIndex() override;
+    void updateLassoIndexForClip(ClipComponent *cc);
+
     //===------------------------------------------------------------------===//
     // SmoothZoomListener
     //===------------------------------------------------------------------===//
@@ -114,6 +117,12 @@ public:
     void resized() override;
     void paint(Graphics &g) override;
     void parentSizeChanged() override;
+
+    //===------------------------------------------------------------------===//
+    // HybridRollRenderer::Source
+    //===------------------------------------------------------------------===//
+
+    void fillGeometry(HybridRollRenderer::Geometry &geometry) override;
     
     //===------------------------------------------------------------------===//
     // Serializable
@@ -25,9 +25,11 @@
 #include "Note.h"
 #include "SelectionComponent.h"
 #include "SequencerOperations.h"
+#include "UndoStack.h"
 #include "Transport.h"
 #include "App.h"
 #include "MainWindow.h"
+#include "Profiler.h"
 
 #define RESIZE_CORNER 10
 #define MAX_DRAG_POLYPHONY 8
@@ -55,6 +57,8 @@ NoteComponent::NoteComponent(PianoRoll &editor, const Note &event, const Clip &c
     this->setFloatBounds(this->getRoll().getEventBounds(this));
 }
 
+NoteComponent::~NoteComponent() {}
+
 PianoRoll &NoteComponent::getRoll() const noexcept
 {
     return static_cast<PianoRoll &>(this->roll);
@@ -192,6 +196,9 @@ void NoteComponent::mouseDown(const MouseEvent &e)
 
     const Lasso &selection = this->roll.getLassoSelection();
 
+    // each drag step performs a change action, and they all get merged into one
+    this->dragCoalescing = new ScopedUndoCoalescing(this->roll.getProject().getUndoStack());
+
     if (e.mods.isLeftButtonDown())
     {
 #if HELIO_MOBILE
@@ -538,6 +545,9 @@ void NoteComponent::mouseDrag(const MouseEvent &e)
 
 void NoteComponent::mouseUp(const MouseEvent &e)
 {
+    // the final changes of a drag are made below, merged or not
+    const ScopedPointer<ScopedUndoCoalescing> coalescing(this->dragCoalescing.release());
+
     if (this->shouldGoQuickSelectLayerMode(e.mods))
     {
         return;
@@ -659,58 +669,79 @@ void NoteComponent::paint(Graphics &g)
 #endif
 }
 
-// Really fast approximation, we don't need accuracy here:
-// (using Bhaskara I's sine approximation, ~5% error)
-static constexpr float piSqr5 = static_cast<float>(49.3480220f);
-static constexpr float fastSine(float x)
+// The bevel shape only depends on a note height, so it is computed once
+// per height instead of calling sin() for each row of each note on every repaint
+static const Array<float> &getBevelProfile(int height)
 {
-    return (16.f * x * (MathConstants<float>::pi - x)) /
-        (piSqr5 - 4.f * x * (MathConstants<float>::pi - x));
+    static OwnedArray<Array<float>> profiles;
+
+    height = jmax(0, height);
+    while (profiles.size() <= height)
+    {
+        profiles.add(nullptr);
+    }
+
+    if (profiles.getUnchecked(height) == nullptr)
+    {
+        auto profile = new Array<float>();
+        const float yh = float(height - 1);
+        for (int i = 1; i <= height - 2; ++i)
+        {
+            const float yMap = float(i) / yh * MathConstants<float>::pi;
+            profile->add(1.f - (sinf(yMap) - sinf(yMap) / 2.5f));
+        }
+
+        profiles.set(height, profile);
+    }
+
+    return *profiles.getUnchecked(height);
 }
 
 void NoteComponent::paintNewLook(Graphics &g)
 {
+    profileScope("NoteComponent::paintNewLook");
+
     const float w = this->floatLocalBounds.getWidth() - .75f; // a small gap between notes
     const float h = this->floatLocalBounds.getHeight();
     const float x1 = this->floatLocalBounds.getX();
     const float x2 = x1 + w;
     const float y1 = this->floatLocalBounds.getY();
     const float y2 = y1 + h - 1;
-    const float yh = (y2 - y1);
     
     // Bevel depends on a note size (so that small notes don't disappear):
     const float bevelCoeff = 1.f - jmax(0.f, (6.f - w) / 6.f);
-    
-    if (! this->activeState)
-    {
-        g.setColour(this->colourLighter);
-        g.drawHorizontalLine(int(y1), x1 + 1.f, x2 - 1.f);
-        g.setColour(this->colourDarker);
-        g.drawHorizontalLine(int(y2), x1 + 1.f, x2 - 1.f);
-        
-        g.setColour(this->colour);
-        for (float y = y1 + 1.f; y <= y2 - 1.f; y += 1.f)
-        {
-            const float yMap = (y - y1) / yh * MathConstants<float>::pi;
-            const float bevel = bevelCoeff * (1.f - (fastSine(yMap) - fastSine(yMap) / 2.5f));
-            g.drawHorizontalLine(int(y), x1 + bevel, x1 + bevel + 1.f);
-            g.drawHorizontalLine(int(y), x2 - bevel - 1.f, x2 - bevel);
-        }
+    const auto &bevelProfile = getBevelProfile(roundToInt(h));
 
-        return;
-    }
-    
     g.setColour(this->colourLighter);
     g.drawHorizontalLine(int(y1), x1 + 1.f, x2 - 1.f);
     g.setColour(this->colourDarker);
     g.drawHorizontalLine(int(y2), x1 + 1.f, x2 - 1.f);
-    
+
+    // The rows are filled with a single call instead of a line per row;
+    // this only saves the per-call overhead, the renderers still fill each rectangle
+    RectangleList<float> body;
+    for (int i = 0; i < bevelProfile.size(); ++i)
+    {
+        const float y = floorf(y1 + 1.f + float(i));
+        const float bevel = bevelCoeff * bevelProfile.getUnchecked(i);
+
+        if (! this->activeState)
+        {
+            body.addWithoutMerging({ x1 + bevel, y, 1.f, 1.f });
+            body.addWithoutMerging({ x2 - bevel - 1.f, y, 1.f, 1.f });
+        }
+        else
+        {
+            body.addWithoutMerging({ x1 + bevel, y, w - bevel * 2.f, 1.f });
+        }
+    }
+
     g.setColour(this->colour);
-    for (float y = y1 + 1.f; y <= y2 - 1.f; y += 1.f)
+    g.fillRectList(body);
+
+    if (! this->activeState)
     {
-        const float yMap = (y - y1) / yh * MathConstants<float>::pi;
-        const float bevel = bevelCoeff * (1.f - (sin(yMap) - sin(yMap) / 2.5f));
-        g.drawHorizontalLine(int(y), x1 + bevel, x2 - bevel);
+        return;
     }
     
 //#ifdef DEBUG
@@ -19,6 +19,7 @@
 
 class PianoRoll;
 class MidiTrack;
+class ScopedUndoCoalescing;
 
 #include "MidiEventComponent.h"
 #include "Note.h"
@@ -31,6 +32,8 @@ public:
     NoteComponent(PianoRoll &gridRef, const Note &note,
         const Clip &clip, bool ghostMode = false);
 
+    ~NoteComponent() override;
+
     enum State
     {
         None,
@@ -148,6 +151,10 @@ protected:
     bool firstChangeDone;
     void checkpointIfNeeded();
 
+    // Merges all the changes of a drag into one undo action,
+    // released on mouse up, or whenever the component is deleted
+    ScopedPointer<ScopedUndoCoalescing> dragCoalescing;
+
     bool shouldGoQuickSelectLayerMode(const ModifierKeys &modifiers) const;
     void setQuickSelectLayerMode(bool value);
 
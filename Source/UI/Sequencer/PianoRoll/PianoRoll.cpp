@@ -56,9 +56,27 @@
 #include "Arpeggiator.h"
 #include "HeadlineItemDataSource.h"
 #include "LassoListeners.h"
+#include "Profiler.h"
 
 #define ROWS_OF_TWO_OCTAVES 24
 #define DEFAULT_NOTE_LENGTH 0.25f
+#define ROWS_PATTERNS_CACHE_MAX_BYTES (8 * 1024 * 1024)
+
+// Returns the index of the first event starting at or after a given beat
+static int lowerBoundByBeat(const MidiSequence *const sequence, float beat) noexcept
+{
+    int s = 0, e = sequence->size();
+    while (s < e)
+    {
+        const int halfway = (s + e) / 2;
+        if (sequence->getUnchecked(halfway)->getBeat() < beat)
+        { s = halfway + 1; }
+        else
+        { e = halfway; }
+    }
+
+    return s;
+}
 
 #define forEachEventOfGivenTrack(map, child, track) \
     for (const auto &_c : map) \
@@ -85,10 +103,10 @@ PianoRoll::PianoRoll(ProjectTreeItem &parentProject,
     newNoteDragging(nullptr),
     addNewNoteMode(false),
     newNoteVolume(0.25f),
+    longestNoteLength(0.f),
     defaultHighlighting() // default pattern (black and white keys)
 {
     this->defaultHighlighting = new HighlightingScheme(0, Scale::getNaturalMajorScale());
-    this->defaultHighlighting->setRows(this->renderBackgroundCacheFor(this->defaultHighlighting));
 
     this->selectedNotesMenuManager = new PianoRollSelectionMenuManager(&this->selection, this->project);
 
@@ -105,8 +123,11 @@ PianoRoll::PianoRoll(ProjectTreeItem &parentProject,
 void PianoRoll::reloadRollContent()
 {
     this->selection.deselectAll();
+    this->invalidateGridCache(); // time signatures might have changed
     this->backgroundsCache.clear();
     this->patternMap.clear();
+    this->invalidateLassoIndex();
+    this->longestNoteLength = 0.f;
 
     HYBRID_ROLL_BULK_REPAINT_START
 
@@ -119,7 +140,12 @@ void PianoRoll::reloadRollContent()
         for (int j = 0; j < track->getSequence()->size(); ++j)
         {
             const MidiEvent *event = track->getSequence()->getUnchecked(j);
-            if (event->isTypeOf(MidiEvent::KeySignature))
+            if (event->isTypeOf(MidiEvent::Note))
+            {
+                const auto *note = static_cast<const Note *>(event);
+                this->longestNoteLength = jmax(this->longestNoteLength, note->getLength());
+            }
+            else if (event->isTypeOf(MidiEvent::KeySignature))
             {
                 const auto &key = static_cast<const KeySignatureEvent &>(*event);
                 this->updateBackgroundCacheFor(key);
@@ -134,7 +160,8 @@ void PianoRoll::reloadRollContent()
 
 void PianoRoll::loadTrack(const MidiTrack *const track)
 {
-    if (track->getPattern() == nullptr)
+    if (track->getPattern() == nullptr ||
+        track != this->activeTrack.get())
     {
         return;
     }
@@ -142,6 +169,10 @@ void PianoRoll::loadTrack(const MidiTrack *const track)
     for (int i = 0; i < track->getPattern()->size(); ++i)
     {
         const Clip *clip = track->getPattern()->getUnchecked(i);
+        if (!(*clip == this->activeClip) || this->patternMap.contains(*clip))
+        {
+            continue;
+        }
 
         auto sequenceMap = new SequenceMap();
         this->patternMap[*clip] = UniquePointer<SequenceMap>(sequenceMap);
@@ -168,9 +199,28 @@ void PianoRoll::setEditableScope(WeakReference<MidiTrack> activeTrack,
 {
     this->selection.deselectAll();
 
+    const bool scopeChanged = this->activeTrack.get() != activeTrack.get() ||
+        !(this->activeClip == activeClip);
+
     this->activeTrack = activeTrack;
     this->activeClip = activeClip;
 
+    if (scopeChanged)
+    {
+        // Components are only kept for the notes of the active clip
+        HYBRID_ROLL_BULK_REPAINT_START
+        this->hideHelpers();
+        this->hideAllGhostNotes();
+        this->newNoteDragging = nullptr;
+        this->patternMap.clear();
+        this->invalidateLassoIndex();
+        if (this->activeTrack != nullptr)
+        {
+            this->loadTrack(this->activeTrack);
+        }
+        HYBRID_ROLL_BULK_REPAINT_END
+    }
+
     int focusMinKey = INT_MAX;
     int focusMaxKey = 0;
     float focusMinBeat = FLT_MAX;
@@ -470,6 +520,10 @@ void PianoRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
         const Note &newNote = static_cast<const Note &>(newEvent);
         const auto track = newEvent.getSequence()->getTrack();
 
+        this->longestNoteLength = jmax(this->longestNoteLength, newNote.getLength());
+        this->repaintInactiveNote(note);
+        this->repaintInactiveNote(newNote);
+
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
             auto &sequenceMap = *c.second.get();
@@ -482,6 +536,7 @@ void PianoRoll::onChangeMidiEvent(const MidiEvent &oldEvent, const MidiEvent &ne
                 jassert(!sequenceMap.contains(newNote));
                 // Always erase before updating, as it may happen both events have the same hash code:
                 sequenceMap[newNote] = UniquePointer<NoteComponent>(component);
+                this->updateLassoIndexForNote(component);
                 // Schedule to be repainted later:
                 this->batchRepaintList.add(component);
                 this->triggerAsyncUpdate();
@@ -511,6 +566,9 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
         const Note &note = static_cast<const Note &>(event);
         const auto track = note.getSequence()->getTrack();
 
+        this->longestNoteLength = jmax(this->longestNoteLength, note.getLength());
+        this->repaintInactiveNote(note);
+
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
             auto &sequenceMap = *c.second.get();
@@ -523,6 +581,7 @@ void PianoRoll::onAddMidiEvent(const MidiEvent &event)
 
             const bool isActive = component->belongsTo(this->activeTrack, this->activeClip);
             component->setActive(isActive);
+            this->updateLassoIndexForNote(component);
 
             this->batchRepaintList.add(component);
             this->triggerAsyncUpdate(); // instead of updateBounds
@@ -556,6 +615,8 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
         const Note &note = static_cast<const Note &>(event);
         const auto track = note.getSequence()->getTrack();
 
+        this->repaintInactiveNote(note);
+
         forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
         {
             auto &sequenceMap = *c.second.get();
@@ -563,6 +624,7 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
             {
                 this->fader.fadeOut(deletedComponent, 150);
                 this->selection.deselect(deletedComponent);
+                this->removeFromLassoIndex(deletedComponent);
                 sequenceMap.erase(note);
             }
         }
@@ -579,48 +641,27 @@ void PianoRoll::onRemoveMidiEvent(const MidiEvent &event)
 
 void PianoRoll::onAddClip(const Clip &clip)
 {
-    const SequenceMap *referenceMap = nullptr;
-    const auto *track = clip.getPattern()->getTrack();
-
-    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-    {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
-    }
-
-    if (referenceMap == nullptr)
-    {
-        jassertfalse;
-        return;
-    }
-
-    auto sequenceMap = new SequenceMap();
-    this->patternMap[clip] = UniquePointer<SequenceMap>(sequenceMap);
-
-    for (const auto &e : *referenceMap)
-    {
-        // reference the same note as neighbor components:
-        const auto &note = e.second.get()->getNote();
-        auto component = new NoteComponent(*this, note, clip);
-        (*sequenceMap)[note] = UniquePointer<NoteComponent>(component);
-        this->addAndMakeVisible(component);
-
-        const bool isActive = component->belongsTo(this->activeTrack, this->activeClip);
-        component->setActive(isActive);
+    HYBRID_ROLL_BULK_REPAINT_START
 
-        this->batchRepaintList.add(component);
-    }
+    // Will only create components if that's the active clip (e.g. on redo),
+    // otherwise the new clip's notes are just painted as inactive ones
+    this->loadTrack(clip.getPattern()->getTrack());
+    this->invalidateLassoIndex();
+    this->repaint(this->viewport.getViewArea());
 
-    this->triggerAsyncUpdate();
+    HYBRID_ROLL_BULK_REPAINT_END
 }
 
 void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
 {
-    if (auto *sequenceMap = this->patternMap[clip].release())
+    // Only the active clip has a sequence map, so don't use operator[]
+    // here, as it would insert an empty map for any other clip
+    const auto found = this->patternMap.find(clip);
+    if (found != this->patternMap.end())
     {
         // Set new key for existing sequence map
-        this->patternMap.erase(clip);
+        auto *sequenceMap = found->second.release();
+        this->patternMap.erase(found);
         this->patternMap[newClip] = UniquePointer<SequenceMap>(sequenceMap);
 
         // And update all components within it, as their beats should change
@@ -629,6 +670,8 @@ void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
             this->batchRepaintList.add(e.second.get());
         }
 
+        this->invalidateLassoIndex();
+
         if (newClip == this->activeClip)
         {
             this->updateActiveRangeIndicator();
@@ -637,17 +680,25 @@ void PianoRoll::onChangeClip(const Clip &clip, const Clip &newClip)
         // Schedule batch repaint
         this->triggerAsyncUpdate();
     }
+    else
+    {
+        this->repaint(this->viewport.getViewArea());
+    }
 }
 
 void PianoRoll::onRemoveClip(const Clip &clip)
 {
     HYBRID_ROLL_BULK_REPAINT_START
 
-    if (const auto *deletedSequenceMap = this->patternMap[clip].get())
+    if (this->patternMap.contains(clip))
     {
+        this->selection.deselectAll();
         this->patternMap.erase(clip);
+        this->invalidateLassoIndex();
     }
 
+    this->repaint(this->viewport.getViewArea());
+
     HYBRID_ROLL_BULK_REPAINT_END
 }
 
@@ -671,11 +722,17 @@ void PianoRoll::onAddTrack(MidiTrack *const track)
     HYBRID_ROLL_BULK_REPAINT_START
 
     this->loadTrack(track);
+    this->invalidateLassoIndex();
 
     for (int j = 0; j < track->getSequence()->size(); ++j)
     {
         const MidiEvent *const event = track->getSequence()->getUnchecked(j);
-        if (event->isTypeOf(MidiEvent::KeySignature))
+        if (event->isTypeOf(MidiEvent::Note))
+        {
+            const Note &note = static_cast<const Note &>(*event);
+            this->longestNoteLength = jmax(this->longestNoteLength, note.getLength());
+        }
+        else if (event->isTypeOf(MidiEvent::KeySignature))
         {
             const KeySignatureEvent &key = static_cast<const KeySignatureEvent &>(*event);
             this->updateBackgroundCacheFor(key);
@@ -694,6 +751,7 @@ void PianoRoll::onRemoveTrack(MidiTrack *const track)
 
     this->hideHelpers();
     this->hideAllGhostNotes(); // Avoids crash
+    this->invalidateLassoIndex();
 
     for (int i = 0; i < track->getSequence()->size(); ++i)
     {
@@ -719,6 +777,8 @@ void PianoRoll::onRemoveTrack(MidiTrack *const track)
             this->repaint();
         }
     }
+
+    this->repaint(this->viewport.getViewArea());
 }
 
 void PianoRoll::onReloadProjectContent(const Array<MidiTrack *> &tracks)
@@ -755,30 +815,28 @@ void PianoRoll::selectEventsInRange(float startBeat, float endBeat, bool shouldC
     }
 }
 
+// Selection states are updated by the lasso itself, as it only
+// selects and deselects the items that entered or left the area
 void PianoRoll::findLassoItemsInArea(Array<SelectableComponent *> &itemsFound, const Rectangle<int> &rectangle)
 {
-    this->selection.invalidateCache();
+    const int lowestKey = (this->getHeight() - rectangle.getBottom()) / this->rowHeight - 1;
+    const int highestKey = (this->getHeight() - rectangle.getY()) / this->rowHeight + 1;
+    this->findLassoItemsInRows(itemsFound, rectangle,
+        jmax(0, lowestKey), jmin(highestKey, this->numRows - 1));
+}
 
+void PianoRoll::rebuildLassoIndex()
+{
     forEachEventComponent(this->patternMap, e)
     {
-        const auto component = e.second.get();
-        component->setSelected(false);
+        this->updateLassoIndexForNote(e.second.get());
     }
+}
 
-    for (const auto component : this->selection)
-    {
-        component->setSelected(true);
-    }
-    
-    forEachEventComponent(this->patternMap, e)
-    {
-        const auto component = e.second.get();
-        if (rectangle.intersects(component->getBounds()) && component->isActive())
-        {
-            component->setSelected(true);
-            itemsFound.addIfNotAlreadyThere(component);
-        }
-    }
+void PianoRoll::updateLassoIndexForNote(NoteComponent *nc)
+{
+    const float beat = nc->getBeat() + nc->getClip().getBeat();
+    this->updateLassoIndexFor(nc, nc->getKey(), beat, beat + nc->getLength());
 }
 
 //===----------------------------------------------------------------------===//
@@ -792,6 +850,19 @@ void PianoRoll::mouseDown(const MouseEvent &e)
         return;
     }
     
+    // Alt-click or right-click on an inactive note switches to its clip,
+    // the same way it works for the active notes, see NoteComponent::mouseDown
+    if (e.mods.isAltDown() || e.mods.isRightButtonDown())
+    {
+        const Note *note = nullptr;
+        const Clip *clip = nullptr;
+        if (this->findInactiveNoteAt(e.getPosition(), note, clip))
+        {
+            this->project.setEditableScope(note->getSequence()->getTrack(), *clip);
+            return;
+        }
+    }
+
     if (! this->isUsingSpaceDraggingMode())
     {
         this->setInterceptsMouseClicks(true, false);
@@ -1022,6 +1093,37 @@ void PianoRoll::resized()
 }
 
 void PianoRoll::paint(Graphics &g)
+{
+    profileScope("PianoRoll::paint");
+
+    // The rows, the grid and the inactive notes are already drawn beneath
+    if (this->isUsingOpenGLRenderer())
+    {
+        HybridRoll::paint(g);
+        return;
+    }
+
+    Array<HybridRollRenderer::Fill> fills;
+    this->collectBackgroundFills(fills);
+
+    for (const auto &fill : fills)
+    {
+        g.setFillType(fill.fillType);
+        g.fillRect(fill.area);
+    }
+
+    HybridRoll::paint(g);
+    this->paintInactiveNotes(g);
+}
+
+void PianoRoll::fillGeometry(HybridRollRenderer::Geometry &geometry)
+{
+    this->collectBackgroundFills(geometry.fills);
+    HybridRoll::fillGeometry(geometry);
+    this->addInactiveNotes(geometry);
+}
+
+void PianoRoll::collectBackgroundFills(Array<HybridRollRenderer::Fill> &fills) const
 {
     const auto sequences = this->project.getTimeline()->getKeySignatures()->getSequence();
     const int paintStartX = this->viewport.getViewPositionX();
@@ -1053,18 +1155,16 @@ void PianoRoll::paint(Graphics &g)
 #endif
 
         const auto s = (prevScheme == nullptr) ? this->backgroundsCache.getUnchecked(index) : prevScheme;
-        const FillType fillType(s->getUnchecked(this->rowHeight), AffineTransform::translation(0.f, paintOffsetY));
-        g.setFillType(fillType);
+        const FillType fillType(this->getRowsPatternFor(s), AffineTransform::translation(0.f, paintOffsetY));
 
         if (barX >= paintEndX)
         {
-            g.fillRect(prevBarX, y, barX - prevBarX, h);
-            HybridRoll::paint(g);
+            fills.add({ { prevBarX, y, barX - prevBarX, h }, fillType });
             return;
         }
         else if (barX >= paintStartX)
         {
-            g.fillRect(prevBarX, y, barX - prevBarX, h);
+            fills.add({ { prevBarX, y, barX - prevBarX, h }, fillType });
         }
 
         prevBarX = barX;
@@ -1074,13 +1174,201 @@ void PianoRoll::paint(Graphics &g)
     if (prevBarX < paintEndX)
     {
         const auto s = (prevScheme == nullptr) ? this->defaultHighlighting : prevScheme;
-        const FillType fillType(s->getUnchecked(this->rowHeight), AffineTransform::translation(0.f, paintOffsetY));
-        g.setFillType(fillType);
-        g.fillRect(prevBarX, y, paintEndX - prevBarX, h);
-        HybridRoll::paint(g);
+        const FillType fillType(this->getRowsPatternFor(s), AffineTransform::translation(0.f, paintOffsetY));
+        fills.add({ { prevBarX, y, paintEndX - prevBarX, h }, fillType });
     }
 }
 
+static Colour getInactiveNoteColour(const MidiTrack *track)
+{
+    return Colours::white.interpolatedWith(track->getTrackColour(), 0.5f).withAlpha(0.95f);
+}
+
+void PianoRoll::paintInactiveNotes(Graphics &g) const
+{
+    profileScope("PianoRoll::paintInactiveNotes");
+
+    this->collectInactiveNotes([&g](const MidiTrack *track,
+        const RectangleList<float> &topLines,
+        const RectangleList<float> &bottomLines,
+        const RectangleList<float> &sideLines)
+    {
+        const Colour colour = getInactiveNoteColour(track);
+        g.setColour(colour.brighter(0.125f));
+        g.fillRectList(topLines);
+        g.setColour(colour.darker(0.175f));
+        g.fillRectList(bottomLines);
+        g.setColour(colour);
+        g.fillRectList(sideLines);
+    });
+}
+
+void PianoRoll::addInactiveNotes(HybridRollRenderer::Geometry &geometry) const
+{
+    this->collectInactiveNotes([&geometry](const MidiTrack *track,
+        const RectangleList<float> &topLines,
+        const RectangleList<float> &bottomLines,
+        const RectangleList<float> &sideLines)
+    {
+        const Colour colour = getInactiveNoteColour(track);
+        const Colour topColour = colour.brighter(0.125f);
+        const Colour bottomColour = colour.darker(0.175f);
+
+        for (const auto &r : topLines)
+        {
+            geometry.addQuad(r, topColour);
+        }
+
+        for (const auto &r : bottomLines)
+        {
+            geometry.addQuad(r, bottomColour);
+        }
+
+        for (const auto &r : sideLines)
+        {
+            geometry.addQuad(r, colour);
+        }
+    });
+}
+
+void PianoRoll::collectInactiveNotes(const InactiveNotesCallback &callback) const
+{
+    const auto viewArea = this->viewport.getViewArea();
+    const float viewStartBeat = this->getBarByXPosition(viewArea.getX()) * float(BEATS_PER_BAR);
+    const float viewEndBeat = this->getBarByXPosition(viewArea.getRight()) * float(BEATS_PER_BAR);
+
+    // Rectangles are collected per track and passed in three lists,
+    // instead of painting each note separately
+    RectangleList<float> topLines;
+    RectangleList<float> bottomLines;
+    RectangleList<float> sideLines;
+
+    for (const auto *track : this->project.getTracks())
+    {
+        const auto *sequence = dynamic_cast<const PianoSequence *>(track->getSequence());
+        if (sequence == nullptr || track->getPattern() == nullptr || sequence->size() == 0)
+        {
+            continue;
+        }
+
+        topLines.clear();
+        bottomLines.clear();
+        sideLines.clear();
+
+        for (int i = 0; i < track->getPattern()->size(); ++i)
+        {
+            const Clip *clip = track->getPattern()->getUnchecked(i);
+            if (track == this->activeTrack.get() && *clip == this->activeClip)
+            {
+                continue;
+            }
+
+            const float startBeat = viewStartBeat - clip->getBeat() - this->longestNoteLength;
+            const float endBeat = viewEndBeat - clip->getBeat();
+
+            for (int j = lowerBoundByBeat(sequence, startBeat); j < sequence->size(); ++j)
+            {
+                const auto *note = static_cast<const Note *>(sequence->getUnchecked(j));
+                if (note->getBeat() > endBeat)
+                {
+                    break;
+                }
+
+                const auto r(this->getEventBounds(note->getKey(),
+                    note->getBeat() + clip->getBeat(), note->getLength()));
+
+                if (r.getRight() < viewArea.getX() ||
+                    r.getBottom() < viewArea.getY() || r.getY() > viewArea.getBottom())
+                {
+                    continue;
+                }
+
+                // Same shape as an inactive note component, a bit simplified
+                const float w = jmax(1.f, r.getWidth() - .75f);
+                topLines.addWithoutMerging({ r.getX() + 1.f, r.getY(), jmax(0.f, w - 2.f), 1.f });
+                bottomLines.addWithoutMerging({ r.getX() + 1.f, r.getBottom() - 1.f, jmax(0.f, w - 2.f), 1.f });
+                sideLines.addWithoutMerging({ r.getX(), r.getY() + 1.f, 1.f, r.getHeight() - 2.f });
+                sideLines.addWithoutMerging({ r.getX() + w - 1.f, r.getY() + 1.f, 1.f, r.getHeight() - 2.f });
+            }
+        }
+
+        if (sideLines.isEmpty())
+        {
+            continue;
+        }
+
+        callback(track, topLines, bottomLines, sideLines);
+    }
+}
+
+void PianoRoll::repaintInactiveNote(const Note &note)
+{
+    const auto *track = note.getSequence()->getTrack();
+    if (track->getPattern() == nullptr)
+    {
+        return;
+    }
+
+    for (int i = 0; i < track->getPattern()->size(); ++i)
+    {
+        const Clip *clip = track->getPattern()->getUnchecked(i);
+        if (track != this->activeTrack.get() || !(*clip == this->activeClip))
+        {
+            const auto bounds(this->getEventBounds(note.getKey(),
+                note.getBeat() + clip->getBeat(), note.getLength()));
+            this->repaintOnNextFrame(bounds.getSmallestIntegerContainer().expanded(1));
+        }
+    }
+}
+
+// Rows make a natural spatial index: key is found by the y position,
+// and notes within each clip are found with a binary search by beat
+bool PianoRoll::findInactiveNoteAt(const Point<int> &position,
+    const Note *&outNote, const Clip *&outClip) const
+{
+    const int key = (this->getHeight() - position.getY()) / this->rowHeight;
+    const float beat = this->getBarByXPosition(position.getX()) * float(BEATS_PER_BAR);
+
+    for (const auto *track : this->project.getTracks())
+    {
+        const auto *sequence = dynamic_cast<const PianoSequence *>(track->getSequence());
+        if (sequence == nullptr || track->getPattern() == nullptr)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < track->getPattern()->size(); ++i)
+        {
+            const Clip *clip = track->getPattern()->getUnchecked(i);
+            if (track == this->activeTrack.get() && *clip == this->activeClip)
+            {
+                continue;
+            }
+
+            const float localBeat = beat - clip->getBeat();
+            for (int j = lowerBoundByBeat(sequence, localBeat - this->longestNoteLength);
+                j < sequence->size(); ++j)
+            {
+                const auto *note = static_cast<const Note *>(sequence->getUnchecked(j));
+                if (note->getBeat() > localBeat)
+                {
+                    break;
+                }
+
+                if (note->getKey() == key &&
+                    (note->getBeat() + note->getLength()) > localBeat)
+                {
+                    outNote = note;
+                    outClip = clip;
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
 void PianoRoll::insertNewNoteAt(const MouseEvent &e)
 {
     int draggingRow = 0;
@@ -1094,7 +1382,7 @@ void PianoRoll::insertNewNoteAt(const MouseEvent &e)
 // HybridRoll's legacy
 //===----------------------------------------------------------------------===//
 
-void PianoRoll::handleAsyncUpdate()
+void PianoRoll::renderFrame()
 {
 #if PIANOROLL_HAS_NOTE_RESIZERS
     // resizers for the mobile version
@@ -1118,10 +1406,11 @@ void PianoRoll::handleAsyncUpdate()
         this->noteResizerRight = nullptr;
     }
 
-    if (this->batchRepaintList.size() > 0)
+    // selection changes don't move any components, they only mark
+    // the dirty areas, but the resizers have to follow the selection,
+    // and two small components are cheap to repaint on their own
+    if (this->batchRepaintList.size() > 0 || !this->dirtyRegion.isEmpty())
     {
-        HYBRID_ROLL_BULK_REPAINT_START
-
         if (this->noteResizerLeft != nullptr)
         {
             this->noteResizerLeft->updateBounds();
@@ -1131,12 +1420,10 @@ void PianoRoll::handleAsyncUpdate()
         {
             this->noteResizerRight->updateBounds();
         }
-
-        HYBRID_ROLL_BULK_REPAINT_END
     }
 #endif
 
-    HybridRoll::handleAsyncUpdate();
+    HybridRoll::renderFrame();
 }
 
 
@@ -1239,7 +1526,6 @@ void PianoRoll::updateBackgroundCacheFor(const KeySignatureEvent &key)
     if (duplicateSchemeIndex < 0)
     {
         ScopedPointer<HighlightingScheme> scheme(new HighlightingScheme(key.getRootKey(), key.getScale()));
-        scheme->setRows(this->renderBackgroundCacheFor(scheme));
         this->backgroundsCache.addSorted(*this->defaultHighlighting, scheme.release());
     }
 
@@ -1288,15 +1574,115 @@ void PianoRoll::removeBackgroundCacheFor(const KeySignatureEvent &key)
 #endif
 }
 
-Array<Image> PianoRoll::renderBackgroundCacheFor(const HighlightingScheme *const scheme) const
+class PianoRoll::RowsPatternsCache final
 {
-    Array<Image> result;
-    const auto &theme = static_cast<HelioTheme &>(this->getLookAndFeel());
-    for (int j = 0; j <= PIANOROLL_MAX_ROW_HEIGHT; ++j)
+public:
+
+    static RowsPatternsCache &getInstance()
     {
-        result.add(PianoRoll::renderRowsPattern(theme, scheme->getScale(), scheme->getRootKey(), j));
+        static RowsPatternsCache Instance;
+        return Instance;
+    }
+
+    Image get(const HelioTheme &theme, const Scale::Ptr scale, int root, int height)
+    {
+        const int64 themeHash = getThemeHash(theme);
+        this->usageCounter++;
+
+        for (auto &entry : this->entries)
+        {
+            if (entry.rootKey == root && entry.height == height &&
+                entry.themeHash == themeHash && entry.scale->isEquivalentTo(scale))
+            {
+                entry.lastUsed = this->usageCounter;
+                return entry.image;
+            }
+        }
+
+        Entry entry;
+        entry.rootKey = root;
+        entry.height = height;
+        entry.scale = scale;
+        entry.themeHash = themeHash;
+        entry.lastUsed = this->usageCounter;
+        entry.image = PianoRoll::renderRowsPattern(theme, scale, root, height);
+        entry.numBytes = getImageSize(entry.image);
+
+        this->totalBytes += entry.numBytes;
+        this->entries.add(entry);
+        this->evictIfNeeded();
+
+        return entry.image;
     }
-    return result;
+
+private:
+
+    RowsPatternsCache() = default;
+
+    struct Entry final
+    {
+        int rootKey = 0;
+        int height = 0;
+        Scale::Ptr scale;
+        int64 themeHash = 0;
+        Image image;
+        int numBytes = 0;
+        uint32 lastUsed = 0;
+    };
+
+    // Only the colours used by renderRowsPattern matter,
+    // so that rolls with the same colour scheme share the images
+    static int64 getThemeHash(const HelioTheme &theme)
+    {
+        int64 hash = 0;
+        for (const auto colourId : { ColourIDs::Roll::blackKey, ColourIDs::Roll::blackKeyAlt,
+            ColourIDs::Roll::whiteKey, ColourIDs::Roll::whiteKeyAlt, ColourIDs::Roll::rowLine })
+        {
+            hash = hash * 31 + int64(theme.findColour(colourId).getARGB());
+        }
+
+        return hash;
+    }
+
+    static int getImageSize(const Image &image)
+    {
+        const int bytesPerPixel = image.getFormat() == Image::RGB ? 3 : 4;
+        return image.getWidth() * image.getHeight() * bytesPerPixel;
+    }
+
+    // The number of entries is small, so a linear search for
+    // the least recently used one is fine here
+    void evictIfNeeded()
+    {
+        while (this->totalBytes > ROWS_PATTERNS_CACHE_MAX_BYTES && this->entries.size() > 1)
+        {
+            int lruIndex = 0;
+            for (int i = 1; i < this->entries.size(); ++i)
+            {
+                if (this->entries.getReference(i).lastUsed <
+                    this->entries.getReference(lruIndex).lastUsed)
+                {
+                    lruIndex = i;
+                }
+            }
+
+            this->totalBytes -= this->entries.getReference(lruIndex).numBytes;
+            this->entries.remove(lruIndex);
+        }
+    }
+
+    Array<Entry> entries;
+    int totalBytes = 0;
+    uint32 usageCounter = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(RowsPatternsCache)
+};
+
+Image PianoRoll::getRowsPatternFor(const HighlightingScheme *const scheme) const
+{
+    const auto &theme = static_cast<HelioTheme &>(this->getLookAndFeel());
+    return RowsPatternsCache::getInstance().get(theme,
+        scheme->getScale(), scheme->getRootKey(), this->rowHeight);
 }
 
 Image PianoRoll::renderRowsPattern(const HelioTheme &theme,
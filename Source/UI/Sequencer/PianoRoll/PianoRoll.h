@@ -138,6 +138,9 @@ public:
     void findLassoItemsInArea(Array<SelectableComponent *> &itemsFound,
         const Rectangle<int> &rectangle) override;
 
+    void rebuildLassoIndex() override;
+    void updateLassoIndexForNote(NoteComponent *nc);
+
     //===------------------------------------------------------------------===//
     // Component
     //===------------------------------------------------------------------===//
@@ -154,7 +157,13 @@ public:
     // HybridRoll's legacy
     //===------------------------------------------------------------------===//
     
-    void handleAsyncUpdate() override;
+    void renderFrame() override;
+
+    //===------------------------------------------------------------------===//
+    // HybridRollRenderer::Source
+    //===------------------------------------------------------------------===//
+
+    void fillGeometry(HybridRollRenderer::Geometry &geometry) override;
 
     //===------------------------------------------------------------------===//
     // Serializable
@@ -183,6 +192,23 @@ private:
     void reloadRollContent();
     void loadTrack(const MidiTrack *const track);
 
+    // Only the notes of the active clip are editable, so only they get components;
+    // all other notes are painted in bulk straight from the model,
+    // and only the ones within the visible area
+    using InactiveNotesCallback = Function<void(const MidiTrack *track,
+        const RectangleList<float> &topLines,
+        const RectangleList<float> &bottomLines,
+        const RectangleList<float> &sideLines)>;
+    void collectInactiveNotes(const InactiveNotesCallback &callback) const;
+    void paintInactiveNotes(Graphics &g) const;
+    void addInactiveNotes(HybridRollRenderer::Geometry &geometry) const;
+    void repaintInactiveNote(const Note &note);
+    bool findInactiveNoteAt(const Point<int> &position,
+        const Note *&outNote, const Clip *&outClip) const;
+
+    // Used as a search margin to find notes starting before the visible area
+    float longestNoteLength;
+
     void updateChildrenBounds() override;
     void updateChildrenPositions() override;
     void setChildrenInteraction(bool interceptsMouse, MouseCursor c) override;
@@ -218,20 +244,23 @@ private:
 
         const Scale::Ptr getScale() const noexcept { return this->scale; }
         const int getRootKey() const noexcept { return this->rootKey; }
-        const Image getUnchecked(int i) const noexcept { return this->rows.getUnchecked(i); }
-        void setRows(Array<Image> val) noexcept { this->rows = val; }
 
     private:
         Scale::Ptr scale;
         int rootKey;
-        Array<Image> rows;
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HighlightingScheme);
     };
 
+    // The rows backgrounds for the visible area, one per key signature
+    void collectBackgroundFills(Array<HybridRollRenderer::Fill> &fills) const;
+
     void updateBackgroundCacheFor(const KeySignatureEvent &key);
     void removeBackgroundCacheFor(const KeySignatureEvent &key);
-    Array<Image> renderBackgroundCacheFor(const HighlightingScheme *const scheme) const;
+    // Row patterns are rendered on demand, for the current row height only,
+    // and kept in a size-limited cache, shared by all piano rolls
+    Image getRowsPatternFor(const HighlightingScheme *const scheme) const;
     static Image renderRowsPattern(const HelioTheme &, const Scale::Ptr, int root, int height);
+    class RowsPatternsCache;
     OwnedArray<HighlightingScheme> backgroundsCache;
     ScopedPointer<HighlightingScheme> defaultHighlighting;
     int binarySearchForHighlightingScheme(const KeySignatureEvent *const e) const noexcept;
@@ -21,7 +21,8 @@
 #include "HelioTheme.h"
 
 SelectionComponent::SelectionComponent() :
-    source(nullptr) {}
+    source(nullptr),
+    mode(None) {}
 
 void SelectionComponent::beginLasso(const MouseEvent &e, LassoSource<SelectableComponent *> *const lassoSource)
 {
@@ -32,6 +33,9 @@ void SelectionComponent::beginLasso(const MouseEvent &e, LassoSource<SelectableC
     {
         source = lassoSource;
         originalSelection = lassoSource->getLassoSelection().getItemArray();
+        originalSelection.sort();
+        itemsInLasso.clearQuick();
+        mode = None;
         this->setSize(0, 0);
         this->toFront(false);
         dragStartPos = e.getMouseDownPosition();
@@ -45,24 +49,92 @@ void SelectionComponent::dragLasso(const MouseEvent &e)
         this->setBounds(Rectangle<int>(dragStartPos, e.getPosition()));
         this->setVisible(true);
 
-        Array<SelectableComponent *> itemsInLasso;
-        source->findLassoItemsInArea(itemsInLasso, getBounds());
+        Array<SelectableComponent *> newItemsInLasso;
+        source->findLassoItemsInArea(newItemsInLasso, getBounds());
+        newItemsInLasso.sort();
 
-        if (e.mods.isShiftDown())
+        const Mode newMode = getModeFor(e.mods);
+        if (newMode != mode)
         {
-            itemsInLasso.removeValuesIn(originalSelection);
-            itemsInLasso.addArray(originalSelection);
+            // The first drag, or modifiers have changed, so the whole selection is updated
+            Array<SelectableComponent *> items(newItemsInLasso);
+
+            if (newMode == Add)
+            {
+                items.removeValuesIn(originalSelection);
+                items.addArray(originalSelection);
+            }
+            else if (newMode == Toggle)
+            {
+                Array<SelectableComponent *> originalMinusNew(originalSelection);
+                originalMinusNew.removeValuesIn(newItemsInLasso);
+
+                items.removeValuesIn(originalSelection);
+                items.addArray(originalMinusNew);
+            }
+
+            mode = newMode;
+            source->getLassoSelection() = Lasso(items);
         }
-        else if (e.mods.isAltDown())
+        else
         {
-            Array<SelectableComponent *> originalMinusNew(originalSelection);
-            originalMinusNew.removeValuesIn(itemsInLasso);
-
-            itemsInLasso.removeValuesIn(originalSelection);
-            itemsInLasso.addArray(originalMinusNew);
+            // Only the items that have entered or left the area are updated
+            int i = 0;
+            int j = 0;
+            while (i < itemsInLasso.size() || j < newItemsInLasso.size())
+            {
+                if (j >= newItemsInLasso.size() ||
+                    (i < itemsInLasso.size() && itemsInLasso.getUnchecked(i) < newItemsInLasso.getUnchecked(j)))
+                {
+                    applyToItem(itemsInLasso.getUnchecked(i++), false);
+                }
+                else if (i >= itemsInLasso.size() ||
+                    newItemsInLasso.getUnchecked(j) < itemsInLasso.getUnchecked(i))
+                {
+                    applyToItem(newItemsInLasso.getUnchecked(j++), true);
+                }
+                else
+                {
+                    ++i;
+                    ++j;
+                }
+            }
         }
 
-        source->getLassoSelection() = Lasso(itemsInLasso);
+        itemsInLasso.swapWith(newItemsInLasso);
+    }
+}
+
+SelectionComponent::Mode SelectionComponent::getModeFor(const ModifierKeys &mods) noexcept
+{
+    if (mods.isShiftDown())
+    {
+        return Add;
+    }
+    else if (mods.isAltDown())
+    {
+        return Toggle;
+    }
+
+    return Replace;
+}
+
+void SelectionComponent::applyToItem(SelectableComponent *item, bool isInLasso)
+{
+    DefaultElementComparator<SelectableComponent *> comparator;
+    const bool wasSelected = originalSelection.indexOfSorted(comparator, item) >= 0;
+    const bool shouldBeSelected =
+        (mode == Add) ? (isInLasso || wasSelected) :
+        (mode == Toggle) ? (isInLasso != wasSelected) :
+        isInLasso;
+
+    if (shouldBeSelected)
+    {
+        source->getLassoSelection().addToSelection(item);
+    }
+    else
+    {
+        source->getLassoSelection().deselect(item);
     }
 }
 
@@ -72,6 +144,8 @@ void SelectionComponent::endLasso()
     {
         this->source = nullptr;
         this->originalSelection.clear();
+        this->itemsInLasso.clear();
+        this->mode = None;
         this->setVisible(false);
     }
 }
@@ -39,7 +39,22 @@ public:
 
 private:
 
+    enum Mode
+    {
+        None,
+        Replace,
+        Add,        // shift
+        Toggle      // alt
+    };
+
+    static Mode getModeFor(const ModifierKeys &mods) noexcept;
+    void applyToItem(SelectableComponent *item, bool isInLasso);
+
+    // Both arrays are sorted, so that the items which have entered
+    // or left the lasso area are found with a single pass
     Array<SelectableComponent *> originalSelection;
+    Array<SelectableComponent *> itemsInLasso;
+    Mode mode;
 
     LassoSource<SelectableComponent *> *source;
 
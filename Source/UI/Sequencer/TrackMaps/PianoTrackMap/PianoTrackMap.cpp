@@ -27,62 +27,217 @@
 #include "AnnotationEvent.h"
 #include "MidiTrack.h"
 
-class TrackMapNoteComponent final : public Component
+#define TRACK_MAP_NUM_ROWS (128)
+#define TRACK_MAP_COLUMNS_PER_BEAT (4)
+#define TRACK_MAP_MAX_COLUMNS (2048)
+#define TRACK_MAP_BEAT_RANGE_STEP (16.f)
+#define TRACK_MAP_MAX_STACKED_NOTES (8)
+
+struct TrackMapNote final
+{
+    int key;
+    float beat;
+    float length;
+    Colour colour;
+};
+
+static Colour getTrackMapNoteColour(const Note &note)
+{
+    return note.getTrackColour().interpolatedWith(Colours::white, .35f);
+}
+
+//===----------------------------------------------------------------------===//
+// Overview
+//===----------------------------------------------------------------------===//
+
+// Each pixel keeps the sums of colours of all notes covering it, so that
+// removing a note is an exact inverse of adding it, and the neighbours
+// don't need to be looked up and re-rendered
+class PianoTrackMap::Overview final
 {
 public:
 
-    TrackMapNoteComponent(PianoTrackMap &parent, const Note &note, const Clip &clip) :
-        note(note),
-        clip(clip),
-        map(parent),
-        dx(0.f),
-        dw(0.f)
+    Overview(float firstBeat, float lastBeat) :
+        firstBeat(firstBeat),
+        lastBeat(lastBeat)
     {
-        this->updateColour();
-        this->setInterceptsMouseClicks(false, false);
-        this->setPaintingIsUnclipped(true);
+        const float numBeats = jmax(1.f, lastBeat - firstBeat);
+        this->numColumns = jlimit(1, TRACK_MAP_MAX_COLUMNS,
+            int(numBeats * TRACK_MAP_COLUMNS_PER_BEAT));
+        this->columnsPerBeat = float(this->numColumns) / numBeats;
+
+        this->cells.calloc(size_t(this->numColumns * TRACK_MAP_NUM_ROWS));
+
+        // Software image, since it is rendered in a background thread
+        this->image = Image(Image::ARGB, this->numColumns,
+            TRACK_MAP_NUM_ROWS, true, SoftwareImageType());
+
+        // Same as drawing semi-transparent lines on top of each other
+        for (int i = 0; i <= TRACK_MAP_MAX_STACKED_NOTES; ++i)
+        {
+            this->alphaByStackSize[i] = uint8(255.f * (1.f - powf(.45f, float(i))));
+        }
     }
 
-    inline int getKey() const noexcept           { return this->note.getKey(); }
-    inline float getBeat() const noexcept        { return this->note.getBeat() + this->clip.getBeat(); }
-    inline float getLength() const noexcept      { return this->note.getLength(); }
-    inline float getVelocity() const noexcept    { return this->note.getVelocity(); }
-    inline const Note &getNote() const noexcept  { return this->note; }
+    Rectangle<int> addNote(const TrackMapNote &note, int delta)
+    {
+        const int row = TRACK_MAP_NUM_ROWS - 1 - note.key;
+        if (row < 0 || row >= TRACK_MAP_NUM_ROWS)
+        {
+            return {};
+        }
+
+        const int startColumn = jlimit(0, this->numColumns - 1,
+            int(floorf((note.beat - this->firstBeat) * this->columnsPerBeat)));
+
+        const int endColumn = jlimit(startColumn + 1, this->numColumns,
+            int(ceilf((note.beat + note.length - this->firstBeat) * this->columnsPerBeat)));
+
+        Cell *cell = this->cells + (row * this->numColumns + startColumn);
+        for (int i = startColumn; i < endColumn; ++i, ++cell)
+        {
+            cell->r += delta * note.colour.getRed();
+            cell->g += delta * note.colour.getGreen();
+            cell->b += delta * note.colour.getBlue();
+            cell->count += delta;
+            jassert(cell->count >= 0);
+        }
 
-    inline void updateColour()
+        return { startColumn, row, endColumn - startColumn, 1 };
+    }
+
+    void updateImage(const Rectangle<int> &area)
+    {
+        const auto clippedArea = area.getIntersection(this->image.getBounds());
+        if (clippedArea.isEmpty())
+        {
+            return;
+        }
+
+        Image::BitmapData data(this->image, clippedArea.getX(), clippedArea.getY(),
+            clippedArea.getWidth(), clippedArea.getHeight(), Image::BitmapData::writeOnly);
+
+        for (int y = 0; y < clippedArea.getHeight(); ++y)
+        {
+            const Cell *cell = this->cells +
+                ((clippedArea.getY() + y) * this->numColumns + clippedArea.getX());
+
+            for (int x = 0; x < clippedArea.getWidth(); ++x, ++cell)
+            {
+                if (cell->count <= 0)
+                {
+                    data.setPixelColour(x, y, Colours::transparentBlack);
+                    continue;
+                }
+
+                const uint8 alpha = this->alphaByStackSize[jmin(cell->count, TRACK_MAP_MAX_STACKED_NOTES)];
+                data.setPixelColour(x, y, Colour(uint8(cell->r / cell->count),
+                    uint8(cell->g / cell->count), uint8(cell->b / cell->count), alpha));
+            }
+        }
+    }
+
+    const Image &getImage() const noexcept
     {
-        this->colour = this->note.getTrackColour().
-            interpolatedWith(Colours::white, .35f).
-            withAlpha(.55f);
+        return this->image;
     }
 
-    void setRealBounds(float x, int y, float w, int h)
+    float getFirstBeat() const noexcept
     {
-        this->dx = x - floorf(x);
-        this->dw = ceilf(w) - w;
-        this->setBounds(int(floorf(x)), y, int(ceilf(w)), h);
+        return this->firstBeat;
     }
-    
-    void paint(Graphics &g) override
+
+    float getLastBeat() const noexcept
     {
-        g.setColour(this->colour);
-        g.drawHorizontalLine(0, this->dx, float(this->getWidth()) - this->dw);
+        return this->lastBeat;
     }
 
 private:
 
-    const Note &note;
-    const Clip &clip;
+    struct Cell final
+    {
+        int r;
+        int g;
+        int b;
+        int count;
+    };
+
+    const float firstBeat;
+    const float lastBeat;
+
+    int numColumns;
+    float columnsPerBeat;
+
+    HeapBlock<Cell> cells;
+    Image image;
+
+    uint8 alphaByStackSize[TRACK_MAP_MAX_STACKED_NOTES + 1];
+
+    JUCE_DECLARE_NON_COPYABLE(Overview)
+};
+
+//===----------------------------------------------------------------------===//
+// RenderThread
+//===----------------------------------------------------------------------===//
+
+class PianoTrackMap::RenderThread final : public Thread
+{
+public:
+
+    RenderThread(PianoTrackMap &map, float firstBeat, float lastBeat,
+        const Array<TrackMapNote> &notes) :
+        Thread("Track Map Render Thread"),
+        map(map),
+        firstBeat(firstBeat),
+        lastBeat(lastBeat),
+        notes(notes) {}
+
+    ~RenderThread() override
+    {
+        this->stopThread(1000);
+    }
+
+    void run() override
+    {
+        ScopedPointer<Overview> newOverview(new Overview(this->firstBeat, this->lastBeat));
+
+        for (const auto &note : this->notes)
+        {
+            if (this->threadShouldExit())
+            {
+                return;
+            }
+
+            newOverview->addNote(note, 1);
+        }
+
+        newOverview->updateImage(newOverview->getImage().getBounds());
+        this->result = newOverview.release();
+        this->map.triggerAsyncUpdate();
+    }
+
+    Overview *releaseResult()
+    {
+        return this->result.release();
+    }
+
+private:
 
     PianoTrackMap &map;
-    
-    Colour colour;
 
-    float dx;
-    float dw;
+    const float firstBeat;
+    const float lastBeat;
+    const Array<TrackMapNote> notes;
+
+    ScopedPointer<Overview> result;
 
+    JUCE_DECLARE_NON_COPYABLE(RenderThread)
 };
 
+//===----------------------------------------------------------------------===//
+// PianoTrackMap
+//===----------------------------------------------------------------------===//
+
 PianoTrackMap::PianoTrackMap(ProjectTreeItem &parentProject, HybridRoll &parentRoll) :
     project(parentProject),
     roll(parentRoll),
@@ -90,10 +245,17 @@ PianoTrackMap::PianoTrackMap(ProjectTreeItem &parentProject, HybridRoll &parentR
     projectLastBeat(0.f),
     rollFirstBeat(0.f),
     rollLastBeat(0.f),
-    componentHeight(1.f)
+    overviewFirstBeat(0.f),
+    overviewLastBeat(0.f),
+    overviewIsOutdated(false)
 {
     this->setInterceptsMouseClicks(false, false);
     this->setPaintingIsUnclipped(true);
+
+    const auto projectRange = this->project.getProjectRangeInBeats();
+    this->projectFirstBeat = projectRange.getX();
+    this->projectLastBeat = projectRange.getY();
+
     this->reloadTrackMap();
     this->project.addListener(this);
 }
@@ -101,39 +263,35 @@ PianoTrackMap::PianoTrackMap(ProjectTreeItem &parentProject, HybridRoll &parentR
 PianoTrackMap::~PianoTrackMap()
 {
     this->project.removeListener(this);
+    this->renderThread = nullptr;
 }
 
 //===----------------------------------------------------------------------===//
 // Component
 //===----------------------------------------------------------------------===//
 
-void PianoTrackMap::resized()
+void PianoTrackMap::paint(Graphics &g)
 {
-    this->componentHeight = float(this->getHeight()) / 128.f; // TODO remove hard-coded value
-    
-    this->setVisible(false);
-
-    for (const auto &c : this->patternMap)
+    const float rollLengthInBeats = (this->rollLastBeat - this->rollFirstBeat);
+    if (this->overview == nullptr || rollLengthInBeats <= 0.f)
     {
-        const auto sequenceMap = c.second.get();
-        for (const auto &e : *sequenceMap)
-        {
-            jassert(e.second.get());
-            this->applyNoteBounds(e.second.get());
-        }
+        return;
     }
 
-    this->setVisible(true);
+    const Image &image = this->overview->getImage();
+    const float overviewLengthInBeats = this->overview->getLastBeat() - this->overview->getFirstBeat();
+    const float pixelsPerBeat = float(this->getWidth()) / rollLengthInBeats;
+    const float x = (this->overview->getFirstBeat() - this->rollFirstBeat) * pixelsPerBeat;
+    const float w = overviewLengthInBeats * pixelsPerBeat;
+
+    g.drawImageTransformed(image, AffineTransform::scale(w / float(image.getWidth()),
+        float(this->getHeight()) / float(image.getHeight())).translated(x, 0.f));
 }
 
 //===----------------------------------------------------------------------===//
 // ProjectListener
 //===----------------------------------------------------------------------===//
 
-#define forEachSequenceMapOfGivenTrack(map, child, track) \
-    for (const auto &child : map) \
-        if (child.first.getPattern()->getTrack() == track)
-
 void PianoTrackMap::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2)
 {
     if (e1.isTypeOf(MidiEvent::Note))
@@ -141,16 +299,16 @@ void PianoTrackMap::onChangeMidiEvent(const MidiEvent &e1, const MidiEvent &e2)
         const Note &note = static_cast<const Note &>(e1);
         const Note &newNote = static_cast<const Note &>(e2);
         const auto *track = newNote.getSequence()->getTrack();
+        if (track->getPattern() == nullptr)
+        {
+            return;
+        }
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
+        for (int i = 0; i < track->getPattern()->size(); ++i)
         {
-            auto &sequenceMap = *c.second.get();
-            if (const auto component = sequenceMap[note].release())
-            {
-                sequenceMap.erase(note);
-                sequenceMap[newNote] = UniquePointer<TrackMapNoteComponent>(component);
-                this->applyNoteBounds(component);
-            }
+            const float clipBeat = track->getPattern()->getUnchecked(i)->getBeat();
+            this->patchNote(note, clipBeat, -1);
+            this->patchNote(newNote, clipBeat, 1);
         }
     }
 }
@@ -161,14 +319,14 @@ void PianoTrackMap::onAddMidiEvent(const MidiEvent &event)
     {
         const Note &note = static_cast<const Note &>(event);
         const auto *track = note.getSequence()->getTrack();
+        if (track->getPattern() == nullptr)
+        {
+            return;
+        }
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
+        for (int i = 0; i < track->getPattern()->size(); ++i)
         {
-            auto &componentsMap = *c.second.get();
-            auto component = new TrackMapNoteComponent(*this, note, c.first);
-            componentsMap[note] = UniquePointer<TrackMapNoteComponent>(component);
-            this->addAndMakeVisible(component);
-            this->applyNoteBounds(component);
+            this->patchNote(note, track->getPattern()->getUnchecked(i)->getBeat(), 1);
         }
     }
 }
@@ -179,96 +337,40 @@ void PianoTrackMap::onRemoveMidiEvent(const MidiEvent &event)
     {
         const Note &note = static_cast<const Note &>(event);
         const auto *track = note.getSequence()->getTrack();
+        if (track->getPattern() == nullptr)
+        {
+            return;
+        }
 
-        forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
+        for (int i = 0; i < track->getPattern()->size(); ++i)
         {
-            auto &sequenceMap = *c.second.get();
-            if (const auto *deletedComponent = sequenceMap[note].get())
-            {
-                sequenceMap.erase(note);
-            }
+            this->patchNote(note, track->getPattern()->getUnchecked(i)->getBeat(), -1);
         }
     }
 }
 
 void PianoTrackMap::onAddClip(const Clip &clip)
 {
-    const SequenceMap *referenceMap = nullptr;
-    const auto *track = clip.getPattern()->getTrack();
-
-    forEachSequenceMapOfGivenTrack(this->patternMap, c, track)
-    {
-        // Found a sequence map for the same track
-        referenceMap = c.second.get();
-        break;
-    }
-
-    if (referenceMap == nullptr)
-    {
-        jassertfalse;
-        return;
-    }
-
-    auto sequenceMap = new SequenceMap();
-    this->patternMap[clip] = UniquePointer<SequenceMap>(sequenceMap);
-
-    this->setVisible(false);
-    for (const auto &e : *referenceMap)
-    {
-        const auto &note = e.second.get()->getNote();
-        const auto noteComponent = new TrackMapNoteComponent(*this, note, clip);
-        (*sequenceMap)[note] = UniquePointer<TrackMapNoteComponent>(noteComponent);
-        this->addAndMakeVisible(noteComponent);
-        this->applyNoteBounds(noteComponent);
-    }
-    this->setVisible(true);
+    this->patchTrack(clip.getPattern()->getTrack(), &clip, 1);
 }
 
 void PianoTrackMap::onChangeClip(const Clip &clip, const Clip &newClip)
 {
-    if (auto *sequenceMap = this->patternMap[clip].release())
-    {
-        // Set new key for existing sequence map
-        this->patternMap.erase(clip);
-        this->patternMap[newClip] = UniquePointer<SequenceMap>(sequenceMap);
-
-        // And update all components within it, as their beats should change
-        this->setVisible(false);
-        for (const auto &e : *sequenceMap)
-        {
-            this->applyNoteBounds(e.second.get());
-        }
-        this->setVisible(true);
-    }
+    this->patchTrack(clip.getPattern()->getTrack(), &clip, -1);
+    this->patchTrack(newClip.getPattern()->getTrack(), &newClip, 1);
 }
 
 void PianoTrackMap::onRemoveClip(const Clip &clip)
 {
-    this->setVisible(false);
-    if (const auto *deletedSequenceMap = this->patternMap[clip].get())
-    {
-        this->patternMap.erase(clip);
-    }
-    this->setVisible(true);
+    this->patchTrack(clip.getPattern()->getTrack(), &clip, -1);
 }
 
 void PianoTrackMap::onChangeTrackProperties(MidiTrack *const track)
 {
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
 
-    this->setVisible(false);
-
-    for (const auto &c : this->patternMap)
-    {
-        const auto &componentsMap = *c.second.get();
-        for (const auto &e : componentsMap)
-        {
-            e.second->updateColour();
-        }
-    }
-
-    this->setVisible(true);
-    this->repaint();
+    // The colour might have changed, and all its notes should be re-rendered
+    this->reloadTrackMap();
 }
 
 void PianoTrackMap::onReloadProjectContent(const Array<MidiTrack *> &tracks)
@@ -279,30 +381,23 @@ void PianoTrackMap::onReloadProjectContent(const Array<MidiTrack *> &tracks)
 void PianoTrackMap::onAddTrack(MidiTrack *const track)
 {
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
-
-    this->setVisible(false);
-    this->loadTrack(track);
-    this->setVisible(true);
+    this->patchTrack(track, nullptr, 1);
 }
 
 void PianoTrackMap::onRemoveTrack(MidiTrack *const track)
 {
     if (!dynamic_cast<const PianoSequence *>(track->getSequence())) { return; }
+    this->patchTrack(track, nullptr, -1);
+}
 
-    for (int i = 0; i < track->getSequence()->size(); ++i)
-    {
-        const auto *event = track->getSequence()->getUnchecked(i);
-        const Note &note = static_cast<const Note &>(*event);
-
-        for (const auto &c : this->patternMap)
-        {
-            auto &componentsMap = *c.second.get();
-            if (const auto *deletedComponent = componentsMap[note].get())
-            {
-                componentsMap.erase(note);
-            }
-        }
-    }
+// The overview covers a bit more than the project, so that it is
+// not re-rendered each time the project gets a little bit longer
+static Range<float> getOverviewRange(float firstBeat, float lastBeat)
+{
+    const float step = TRACK_MAP_BEAT_RANGE_STEP;
+    const float start = floorf(firstBeat / step) * step;
+    const float end = jmax(start + step, ceilf(lastBeat / step) * step);
+    return { start, end };
 }
 
 void PianoTrackMap::onChangeProjectBeatRange(float firstBeat, float lastBeat)
@@ -315,7 +410,14 @@ void PianoTrackMap::onChangeProjectBeatRange(float firstBeat, float lastBeat)
     {
         this->rollFirstBeat = firstBeat;
         this->rollLastBeat = lastBeat;
-        this->resized();
+        this->repaint();
+    }
+
+    const auto range = getOverviewRange(firstBeat, lastBeat);
+    if (range.getStart() != this->overviewFirstBeat ||
+        range.getEnd() != this->overviewLastBeat)
+    {
+        this->reloadTrackMap();
     }
 }
 
@@ -323,7 +425,36 @@ void PianoTrackMap::onChangeViewBeatRange(float firstBeat, float lastBeat)
 {
     this->rollFirstBeat = firstBeat;
     this->rollLastBeat = lastBeat;
-    this->resized();
+    this->repaint();
+}
+
+//===----------------------------------------------------------------------===//
+// AsyncUpdater
+//===----------------------------------------------------------------------===//
+
+void PianoTrackMap::handleAsyncUpdate()
+{
+    if (this->renderThread == nullptr)
+    {
+        return;
+    }
+
+    // The thread has just finished, so this shouldn't block for long
+    this->renderThread->waitForThreadToExit(-1);
+    if (Overview *newOverview = this->renderThread->releaseResult())
+    {
+        this->overview = newOverview;
+    }
+
+    this->renderThread = nullptr;
+
+    // Something has changed while rendering
+    if (this->overviewIsOutdated)
+    {
+        this->reloadTrackMap();
+    }
+
+    this->repaint();
 }
 
 //===----------------------------------------------------------------------===//
@@ -332,58 +463,116 @@ void PianoTrackMap::onChangeViewBeatRange(float firstBeat, float lastBeat)
 
 void PianoTrackMap::reloadTrackMap()
 {
-    this->patternMap.clear();
+    // Wait until the current rendering is done, and start over
+    if (this->renderThread != nullptr)
+    {
+        this->overviewIsOutdated = true;
+        return;
+    }
+
+    this->overviewIsOutdated = false;
 
-    this->setVisible(false);
+    const auto range = getOverviewRange(this->projectFirstBeat, this->projectLastBeat);
+    this->overviewFirstBeat = range.getStart();
+    this->overviewLastBeat = range.getEnd();
 
+    // The model is only accessed on the message thread,
+    // so the background thread only gets a plain copy of notes
+    Array<TrackMapNote> notes;
     const auto &tracks = this->project.getTracks();
     for (const auto *track : tracks)
     {
-        this->loadTrack(track);
+        if (track->getPattern() == nullptr)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < track->getPattern()->size(); ++i)
+        {
+            const float clipBeat = track->getPattern()->getUnchecked(i)->getBeat();
+            for (int j = 0; j < track->getSequence()->size(); ++j)
+            {
+                const MidiEvent *event = track->getSequence()->getUnchecked(j);
+                if (event->isTypeOf(MidiEvent::Note))
+                {
+                    const Note *note = static_cast<const Note *>(event);
+                    notes.add({ note->getKey(), note->getBeat() + clipBeat,
+                        note->getLength(), getTrackMapNoteColour(*note) });
+                }
+            }
+        }
+    }
+
+    this->renderThread = new RenderThread(*this, range.getStart(), range.getEnd(), notes);
+    this->renderThread->startThread(3);
+}
+
+void PianoTrackMap::patchNote(const Note &note, float clipBeat, int delta)
+{
+    // The new overview will be rendered with all the changes anyway
+    if (this->renderThread != nullptr)
+    {
+        this->overviewIsOutdated = true;
+        return;
+    }
+
+    if (this->overview == nullptr)
+    {
+        return;
     }
 
-    this->setVisible(true);
+    const TrackMapNote mapNote = { note.getKey(), note.getBeat() + clipBeat,
+        note.getLength(), getTrackMapNoteColour(note) };
+
+    this->overview->updateImage(this->overview->addNote(mapNote, delta));
+    this->repaint();
 }
 
-void PianoTrackMap::loadTrack(const MidiTrack *const track)
+void PianoTrackMap::patchTrack(const MidiTrack *const track, const Clip *clip, int delta)
 {
-    if (track->getPattern() == nullptr)
+    if (this->renderThread != nullptr)
     {
+        this->overviewIsOutdated = true;
         return;
     }
 
-    for (int i = 0; i < track->getPattern()->size(); ++i)
+    if (this->overview == nullptr ||
+        (clip == nullptr && track->getPattern() == nullptr))
     {
-        const Clip *clip = track->getPattern()->getUnchecked(i);
+        return;
+    }
 
-        auto sequenceMap = new SequenceMap();
-        this->patternMap[*clip] = UniquePointer<SequenceMap>(sequenceMap);
+    // Either a single clip is added or removed, or the whole track
+    Array<float> clipBeats;
+    if (clip != nullptr)
+    {
+        clipBeats.add(clip->getBeat());
+    }
+    else
+    {
+        for (int i = 0; i < track->getPattern()->size(); ++i)
+        {
+            clipBeats.add(track->getPattern()->getUnchecked(i)->getBeat());
+        }
+    }
 
+    Rectangle<int> dirtyArea;
+    for (const float clipBeat : clipBeats)
+    {
         for (int j = 0; j < track->getSequence()->size(); ++j)
         {
             const MidiEvent *event = track->getSequence()->getUnchecked(j);
             if (event->isTypeOf(MidiEvent::Note))
             {
                 const Note *note = static_cast<const Note *>(event);
-                const auto noteComponent = new TrackMapNoteComponent(*this, *note, *clip);
-                (*sequenceMap)[*note] = UniquePointer<TrackMapNoteComponent>(noteComponent);
-                this->addAndMakeVisible(noteComponent);
-                this->applyNoteBounds(noteComponent);
+                const TrackMapNote mapNote = { note->getKey(), note->getBeat() + clipBeat,
+                    note->getLength(), getTrackMapNoteColour(*note) };
+
+                dirtyArea = dirtyArea.getUnion(this->overview->addNote(mapNote, delta));
             }
         }
     }
-}
-
-void PianoTrackMap::applyNoteBounds(TrackMapNoteComponent *nc)
-{
-    const float rollLengthInBeats = (this->rollLastBeat - this->rollFirstBeat);
-    const float projectLengthInBeats = (this->projectLastBeat - this->projectFirstBeat);
-
-    const float beat = (nc->getBeat() - this->rollFirstBeat);
-    const float mapWidth = float(this->getWidth()) * (projectLengthInBeats / rollLengthInBeats);
 
-    const float x = (mapWidth * (beat / projectLengthInBeats));
-    const float w = (mapWidth * (nc->getLength() / projectLengthInBeats));
-    const int y = this->getHeight() - int(nc->getKey() * this->componentHeight);
-    nc->setRealBounds(x, y, jmax(1.f, w), 1);
+    this->overview->updateImage(dirtyArea);
+    this->repaint();
 }
@@ -23,11 +23,11 @@
 
 class HybridRoll;
 class ProjectTreeItem;
-class TrackMapNoteComponent;
 
 class PianoTrackMap :
     public Component,
-    public ProjectListener
+    public ProjectListener,
+    private AsyncUpdater
 {
 public:
 
@@ -38,7 +38,7 @@ public:
     // Component
     //===------------------------------------------------------------------===//
 
-    void resized() override;
+    void paint(Graphics &g) override;
 
     //===------------------------------------------------------------------===//
     // ProjectListener
@@ -62,9 +62,17 @@ public:
 
 private:
 
-    void applyNoteBounds(TrackMapNoteComponent *nc);
+    //===------------------------------------------------------------------===//
+    // AsyncUpdater
+    //===------------------------------------------------------------------===//
+
+    void handleAsyncUpdate() override;
+
+private:
+
     void reloadTrackMap();
-    void loadTrack(const MidiTrack *const track);
+    void patchNote(const Note &note, float clipBeat, int delta);
+    void patchTrack(const MidiTrack *const track, const Clip *clip, int delta);
 
     float projectFirstBeat;
     float projectLastBeat;
@@ -72,14 +80,22 @@ private:
     float rollFirstBeat;
     float rollLastBeat;
     
-    float componentHeight;
-    
     HybridRoll &roll;
     ProjectTreeItem &project;
-    
-    using SequenceMap = SparseHashMap<Note, UniquePointer<TrackMapNoteComponent>, MidiEventHash>;
-    using PatternMap = SparseHashMap<const Clip, UniquePointer<SequenceMap>, ClipHash>;
-    PatternMap patternMap;
+
+    // The whole project is rendered into a small image, a pixel per key
+    // and a fraction of beat, so that painting doesn't depend on notes count;
+    // it is rebuilt from scratch in a background thread, and patched in place
+    // when separate notes or clips change
+    class Overview;
+    ScopedPointer<Overview> overview;
+
+    class RenderThread;
+    ScopedPointer<RenderThread> renderThread;
+
+    float overviewFirstBeat;
+    float overviewLastBeat;
+    bool overviewIsOutdated;
 
     JUCE_LEAK_DETECTOR(PianoTrackMap)
 };